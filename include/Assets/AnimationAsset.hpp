@@ -1,12 +1,30 @@
 #pragma once
 #include <Asset.hpp>
+#include <Animation.hpp>
 
 namespace lustra
 {
 
+// The skeleton of a model and the animations that move it, imported along with the model
 struct AnimationAsset final : Asset
 {
-    
+    AnimationAsset() : Asset(Type::Animation) {}
+
+    // -1 if there's no such animation
+    int32_t Find(const std::string_view name) const
+    {
+        for(size_t i = 0; i < animations.size(); i++)
+            if(animations[i].GetName() == name)
+                return static_cast<int32_t>(i);
+
+        return -1;
+    }
+
+    Skeleton skeleton;
+
+    std::vector<Animation> animations;
 };
 
+using AnimationAssetPtr = std::shared_ptr<AnimationAsset>;
+
 }
@@ -21,7 +21,8 @@ struct Asset
         VertexShader,
         FragmentShader,
         Scene,
-        Sound
+        Sound,
+        Animation // Only comes with a model
     };
 
     explicit Asset(const Type type) : type(type) {}
@@ -1,6 +1,7 @@
 #pragma once
 #include <AssetLoader.hpp>
 #include <ModelAsset.hpp>
+#include <MeshOptimizer.hpp>
 
 #include <assimp/BaseImporter.h>
 #include <assimp/Importer.hpp>
@@ -30,10 +31,25 @@ private:
 private:
     void ImportModel(const std::filesystem::path& path, const ModelAssetPtr& modelAsset);
 
-    void ProcessNode(const aiNode* node, const aiScene* scene, const ModelAssetPtr& modelAsset);
+    void ProcessNode(
+        const aiNode* node,
+        const aiScene* scene,
+        const ModelAssetPtr& modelAsset,
+        const Skeleton* skeleton,
+        MeshOptimizer::Statistics& statistics
+    );
     void ProcessMaterial(aiMaterial* material, const ModelAssetPtr& modelAsset);
 
-    static MeshPtr ProcessMesh(const aiMesh* mesh, const aiScene* scene);
+    static MeshPtr ProcessMesh(
+        const aiMesh* mesh,
+        const aiScene* scene,
+        const Skeleton* skeleton,
+        MeshOptimizer::Statistics& statistics
+    );
+
+    // The skeleton is made of the bones and their ancestors, null if there are no bones
+    static AnimationAssetPtr ProcessAnimations(const aiScene* scene);
+    static Animation ProcessAnimation(const aiAnimation* animation, const Skeleton& skeleton);
 
 private:
     MeshPtr cube, plane;
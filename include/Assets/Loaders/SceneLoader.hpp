@@ -2,6 +2,9 @@
 #include <AssetLoader.hpp>
 #include <SceneAsset.hpp>
 
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+
 namespace lustra
 {
 
@@ -39,6 +42,8 @@ private:
             .template get<SoundComponent>(archive)
             .template get<PrefabComponent>(archive);
 
+        LoadExtensions(archive, asset);
+
         ScriptManager::Get().Build();
     }
 
@@ -64,6 +69,148 @@ private:
             .template get<RigidBodyComponent>(archive)
             .template get<SoundComponent>(archive)
             .template get<PrefabComponent>(archive);
+
+        WriteExtensions(archive, asset);
+    }
+
+    // Component settings added after the scene format was fixed go after the snapshot, one list per setting.
+    // A scene saved before a setting existed ends there, so the setting keeps the value it had before
+    template<class Archive>
+    static void WriteExtensions(Archive& archive, const SceneAssetPtr& asset)
+    {
+        auto& registry = asset->scene->GetRegistry();
+
+        auto lightRanges = Collect<LightComponent>(registry, &LightComponent::range);
+        auto bloomMipChains = Collect<BloomComponent>(registry, &BloomComponent::mipChain);
+        auto bloomMipCounts = Collect<BloomComponent>(registry, &BloomComponent::mipCount);
+        auto bloomFilterRadii = Collect<BloomComponent>(registry, &BloomComponent::filterRadius);
+        auto skyTimeSliced = Collect<ProceduralSkyComponent>(registry, &ProceduralSkyComponent::timeSliced);
+        auto gtaoTemporal = Collect<GTAOComponent>(registry, &GTAOComponent::temporal);
+        auto gtaoHistoryWeights = Collect<GTAOComponent>(registry, &GTAOComponent::historyWeight);
+        auto ssrHiZ = Collect<SSRComponent>(registry, &SSRComponent::hiZ);
+        auto ssrMaxDistances = Collect<SSRComponent>(registry, &SSRComponent::maxDistance);
+        auto ssrThicknesses = Collect<SSRComponent>(registry, &SSRComponent::thickness);
+        auto ssrTemporal = Collect<SSRComponent>(registry, &SSRComponent::temporal);
+        auto ssrHistoryWeights = Collect<SSRComponent>(registry, &SSRComponent::historyWeight);
+        auto lodThresholds = Collect<MeshRendererComponent>(registry, &MeshRendererComponent::lodThreshold);
+        auto shadowLodBiases = Collect<MeshRendererComponent>(registry, &MeshRendererComponent::shadowLodBias);
+        auto animatorAnimations = Collect<AnimatorComponent>(registry, &AnimatorComponent::animation);
+        auto animatorSpeeds = Collect<AnimatorComponent>(registry, &AnimatorComponent::speed);
+        auto animatorLoops = Collect<AnimatorComponent>(registry, &AnimatorComponent::loop);
+        auto animatorPlaying = Collect<AnimatorComponent>(registry, &AnimatorComponent::playing);
+
+        archive(
+            cereal::make_nvp("lightRanges", lightRanges),
+            cereal::make_nvp("bloomMipChains", bloomMipChains),
+            cereal::make_nvp("bloomMipCounts", bloomMipCounts),
+            cereal::make_nvp("bloomFilterRadii", bloomFilterRadii),
+            cereal::make_nvp("skyTimeSliced", skyTimeSliced),
+            cereal::make_nvp("gtaoTemporal", gtaoTemporal),
+            cereal::make_nvp("gtaoHistoryWeights", gtaoHistoryWeights),
+            cereal::make_nvp("ssrHiZ", ssrHiZ),
+            cereal::make_nvp("ssrMaxDistances", ssrMaxDistances),
+            cereal::make_nvp("ssrThicknesses", ssrThicknesses),
+            cereal::make_nvp("ssrTemporal", ssrTemporal),
+            cereal::make_nvp("ssrHistoryWeights", ssrHistoryWeights),
+            cereal::make_nvp("lodThresholds", lodThresholds),
+            cereal::make_nvp("shadowLodBiases", shadowLodBiases),
+            cereal::make_nvp("animatorAnimations", animatorAnimations),
+            cereal::make_nvp("animatorSpeeds", animatorSpeeds),
+            cereal::make_nvp("animatorLoops", animatorLoops),
+            cereal::make_nvp("animatorPlaying", animatorPlaying)
+        );
+    }
+
+    template<class Archive>
+    static void LoadExtensions(Archive& archive, const SceneAssetPtr& asset)
+    {
+        auto& registry = asset->scene->GetRegistry();
+
+        if(!Apply<LightComponent>(archive, "lightRanges", registry, &LightComponent::range))
+            registry.view<LightComponent>().each([](auto& light) { light.range = 0.0f; });
+
+        if(!Apply<BloomComponent>(archive, "bloomMipChains", registry, &BloomComponent::mipChain))
+            registry.view<BloomComponent>().each([](auto& bloom) { bloom.mipChain = false; });
+
+        Apply<BloomComponent>(archive, "bloomMipCounts", registry, &BloomComponent::mipCount);
+        Apply<BloomComponent>(archive, "bloomFilterRadii", registry, &BloomComponent::filterRadius);
+
+        // Set up by BloomComponent::load before the mip chain was known
+        registry.view<BloomComponent>().each([](auto& bloom) { bloom.SetupPostProcessing(); });
+
+        // The sky from the file is already built, only the next builds are time-sliced
+        Apply<ProceduralSkyComponent>(archive, "skyTimeSliced", registry, &ProceduralSkyComponent::timeSliced);
+
+        if(!Apply<GTAOComponent>(archive, "gtaoTemporal", registry, &GTAOComponent::temporal))
+            registry.view<GTAOComponent>().each([](auto& gtao) { gtao.temporal = false; });
+
+        Apply<GTAOComponent>(archive, "gtaoHistoryWeights", registry, &GTAOComponent::historyWeight);
+
+        // The resolution scale is in the snapshot, the old scenes keep theirs
+        if(!Apply<SSRComponent>(archive, "ssrHiZ", registry, &SSRComponent::hiZ))
+            registry.view<SSRComponent>().each([](auto& ssr) { ssr.hiZ = false; });
+
+        Apply<SSRComponent>(archive, "ssrMaxDistances", registry, &SSRComponent::maxDistance);
+        Apply<SSRComponent>(archive, "ssrThicknesses", registry, &SSRComponent::thickness);
+
+        if(!Apply<SSRComponent>(archive, "ssrTemporal", registry, &SSRComponent::temporal))
+            registry.view<SSRComponent>().each([](auto& ssr) { ssr.temporal = false; });
+
+        Apply<SSRComponent>(archive, "ssrHistoryWeights", registry, &SSRComponent::historyWeight);
+
+        Apply<MeshRendererComponent>(archive, "lodThresholds", registry, &MeshRendererComponent::lodThreshold);
+        Apply<MeshRendererComponent>(archive, "shadowLodBiases", registry, &MeshRendererComponent::shadowLodBias);
+
+        // The animators aren't in the snapshot, the first list adds them
+        Apply<AnimatorComponent>(archive, "animatorAnimations", registry, &AnimatorComponent::animation, true);
+        Apply<AnimatorComponent>(archive, "animatorSpeeds", registry, &AnimatorComponent::speed);
+        Apply<AnimatorComponent>(archive, "animatorLoops", registry, &AnimatorComponent::loop);
+        Apply<AnimatorComponent>(archive, "animatorPlaying", registry, &AnimatorComponent::playing);
+    }
+
+    template<class Component, class T>
+    static std::vector<std::pair<entt::id_type, T>> Collect(entt::registry& registry, T Component::* member)
+    {
+        std::vector<std::pair<entt::id_type, T>> values;
+
+        for(const auto [entity, component] : registry.view<Component>().each())
+            values.emplace_back(entt::to_integral(entity), component.*member);
+
+        return values;
+    }
+
+    // Returns false if the archive ends before the list. With add, the entities without the component get one
+    template<class Component, class Archive, class T>
+    static bool Apply(
+        Archive& archive,
+        const char* name,
+        entt::registry& registry,
+        T Component::* member,
+        bool add = false
+    )
+    {
+        std::vector<std::pair<entt::id_type, T>> values;
+
+        try
+        {
+            archive(cereal::make_nvp(name, values));
+        }
+        catch(const std::runtime_error&) // Both cereal and RapidJSON exceptions
+        {
+            return false;
+        }
+
+        for(const auto& [id, value] : values)
+        {
+            const auto entity = static_cast<entt::entity>(id);
+
+            if(add && registry.valid(entity))
+                registry.get_or_emplace<Component>(entity).*member = value;
+            else if(const auto component = registry.try_get<Component>(entity))
+                component->*member = value;
+        }
+
+        return true;
     }
 };
 
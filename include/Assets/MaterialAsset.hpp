@@ -7,6 +7,8 @@
 #include <cereal/cereal.hpp>
 #include <glm/glm.hpp>
 
+#include <array>
+
 namespace lustra
 {
 
@@ -70,14 +72,18 @@ struct MaterialAsset final : Asset
         emission = glm::vec4(0.0f);
     }
 
-    void SetUniforms(LLGL::CommandBuffer* commandBuffer) const
+    // A shader compiled with the keywords of GetVariant already knows the property types
+    void SetUniforms(LLGL::CommandBuffer* commandBuffer, const bool types = true) const
     {
-        commandBuffer->SetUniforms(0, &albedo.type, sizeof(albedo.type));
-        commandBuffer->SetUniforms(2, &normal.type, sizeof(normal.type));
-        commandBuffer->SetUniforms(3, &metallic.type, sizeof(metallic.type));
-        commandBuffer->SetUniforms(5, &roughness.type, sizeof(roughness.type));
-        commandBuffer->SetUniforms(7, &ao.type, sizeof(ao.type));
-        commandBuffer->SetUniforms(8, &emission.type, sizeof(emission.type));
+        if(types)
+        {
+            commandBuffer->SetUniforms(0, &albedo.type, sizeof(albedo.type));
+            commandBuffer->SetUniforms(2, &normal.type, sizeof(normal.type));
+            commandBuffer->SetUniforms(3, &metallic.type, sizeof(metallic.type));
+            commandBuffer->SetUniforms(5, &roughness.type, sizeof(roughness.type));
+            commandBuffer->SetUniforms(7, &ao.type, sizeof(ao.type));
+            commandBuffer->SetUniforms(8, &emission.type, sizeof(emission.type));
+        }
 
         if(albedo.type == Property::Type::Color)
             commandBuffer->SetUniforms(1, &albedo.value, sizeof(albedo.value));
@@ -96,6 +102,34 @@ struct MaterialAsset final : Asset
         commandBuffer->SetUniforms(12, &uvOffset, sizeof(uvOffset));
     }
 
+    // A bit per property that is a texture, in the order of GetKeywords
+    uint32_t GetVariant() const
+    {
+        uint32_t variant = 0;
+
+        for(int i = 0; const auto property : { &albedo, &normal, &metallic, &roughness, &ao, &emission })
+            variant |= (property->type == Property::Type::Texture) << i++;
+
+        return variant;
+    }
+
+    static std::vector<std::string> GetKeywords(const uint32_t variant)
+    {
+        static constexpr std::array names =
+        {
+            "ALBEDO_TEXTURE", "NORMAL_TEXTURE", "METALLIC_TEXTURE",
+            "ROUGHNESS_TEXTURE", "AO_TEXTURE", "EMISSION_TEXTURE"
+        };
+
+        std::vector<std::string> keywords;
+
+        for(size_t i = 0; i < names.size(); i++)
+            if(variant & (1u << i))
+                keywords.emplace_back(names[i]);
+
+        return keywords;
+    }
+
     template<class Archive>
     void serialize(Archive& archive)
     {
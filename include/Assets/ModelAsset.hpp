@@ -1,5 +1,6 @@
 #pragma once
 #include <Asset.hpp>
+#include <AnimationAsset.hpp>
 #include <Mesh.hpp>
 #include <vector>
 
@@ -12,6 +13,8 @@ struct ModelAsset final : Asset
     explicit ModelAsset(const std::vector<MeshPtr>& meshes) : Asset(Type::Model), meshes(meshes) {}
 
     std::vector<MeshPtr> meshes, temporaryMeshes;
+
+    AnimationAssetPtr animation, temporaryAnimation; // Null if the model has no bones
 };
 
 using ModelAssetPtr = std::shared_ptr<ModelAsset>;
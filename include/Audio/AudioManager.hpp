@@ -3,30 +3,108 @@
 #include <Sound.hpp>
 
 #include <filesystem>
+#include <unordered_map>
+#include <vector>
 
 namespace lustra
 {
 
 class AudioManager final : public Singleton<AudioManager>
 {
+public:
+    struct VoiceStats
+    {
+        uint32_t real = 0;
+        uint32_t virtualized = 0; // Paused emitters that are out of range or over the voice cap
+    };
+
+public:
+    static constexpr uint32_t defaultMaxVoices = 32;
+    static constexpr uint32_t defaultMaxInstances = 4;
+    static constexpr uintmax_t defaultStreamingThreshold = 2 * 1024 * 1024; // Bytes of the encoded file
+
 public:
     ~AudioManager() override;
 
 public:
     void Init();
 
-    static void RemoveSound(Sound& sound);
+    void RemoveSound(Sound& sound);
 
+    // Files larger than the streaming threshold are streamed from disk,
+    // smaller ones are decoded asynchronously by the resource manager
     Sound LoadSound(const std::filesystem::path& path);
     Sound CopySound(Sound& sound);
 
+    // Plays an independent instance of the sound from the voice pool.
+    // Returns false if the voice cap is reached and no voice with a lower or equal priority could be stolen
+    bool PlayInstance(Sound& sound);
+    void StopInstances(Sound& sound);
+
+    void SetInstanceLimit(const Sound& sound, uint32_t limit);
+    void SetPriority(const Sound& sound, int priority);
+
+    void SetMaxVoices(uint32_t maxVoices);
+    void SetStreamingThreshold(uintmax_t bytes);
+
+    // Reported by the scene after culling the emitters
+    void SetEmitterStats(uint32_t real, uint32_t virtualized);
+
+    bool IsStreamed(const Sound& sound) const;
+
+    int GetPriority(const Sound& sound) const;
+    uint32_t GetMaxVoices() const;
+    uint32_t GetPlayingVoiceCount() const;
+
+    // Pooled instances count as real voices
+    VoiceStats GetVoiceStats() const;
+
     ma_engine* GetEngine();
 
+private:
+    struct Source
+    {
+        std::weak_ptr<ma_sound> sound;
+        std::filesystem::path path;
+
+        bool streamed = false;
+
+        int priority = 0;
+        uint32_t maxInstances = defaultMaxInstances;
+    };
+
+    struct Voice
+    {
+        Sound sound;
+        ma_sound* source{};
+
+        int priority = 0;
+        uint64_t order = 0; // Bigger is newer
+    };
+
+    Source* FindSource(const Sound& sound);
+    const Source* FindSource(const Sound& sound) const;
+
+    bool InitVoice(Voice& voice, Sound& sound, const Source* source);
+    static void CopyParameters(const Sound& from, const Sound& to);
+    static bool IsPlaying(const Voice& voice);
+
 private:
     ma_engine engine{};
     ma_result result{};
 
     bool initialized = false;
+
+private:
+    uint32_t maxVoices = defaultMaxVoices;
+    uintmax_t streamingThreshold = defaultStreamingThreshold;
+
+    uint64_t voiceOrder = 0;
+
+    VoiceStats emitterStats;
+
+    std::unordered_map<ma_sound*, Source> sources;
+    std::vector<Voice> voices;
 };
 
 }
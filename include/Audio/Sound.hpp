@@ -19,6 +19,13 @@ public:
     void Play() const;
     void Stop() const;
 
+    // Overlapping playback through the AudioManager's voice pool
+    bool PlayInstance();
+    void StopInstances();
+
+    void SetPriority(int priority) const;
+    void SetInstanceLimit(uint32_t limit) const;
+
     void SetPosition(const glm::vec3& position) const;
     void SetVelocity(const glm::vec3& velocity) const;
     void SetOrientation(const glm::quat& orientation) const;
@@ -66,11 +73,22 @@ public:
 
     bool IsLooping() const;
     bool IsSpatializationEnabled() const;
+    bool IsPlaying() const;
+
+    // How many times Stop was called, so a pause by the scene can be told from a stop by a script
+    uint32_t GetStopCount() const;
 
     std::shared_ptr<ma_sound> GetSound();
+    ma_sound* GetHandle() const;
+
+    // Drops the handle without uninitializing it, for a sound that was already uninitialized or
+    // failed to initialize. Nothing but the destructor may be called after that
+    void Detach();
 
 private:
     std::shared_ptr<ma_sound> sound;
+
+    mutable uint32_t stopCount = 0;
 };
 
 }
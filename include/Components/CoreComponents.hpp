@@ -46,9 +46,17 @@ struct MeshRendererComponent final : public ComponentBase
     }
 
     std::vector<MaterialAssetPtr> materials;
+
+    // LODs are picked so their error stays under lodThreshold pixels on the screen, 0 always draws the full detail.
+    // Shadow maps allow shadowLodBias times more. Both are saved after the snapshot (see SceneLoader)
+    float lodThreshold = 1.0f;
+    float shadowLodBias = 4.0f;
+
+    std::vector<uint32_t> lods; // Per submesh, picked by the scene every frame
 };
 
-struct PipelineComponent final : public ComponentBase, public EventListener
+// Shader hot reload is handled by the Scene, so a component doesn't have to subscribe to AssetLoadedEvent on its own
+struct PipelineComponent final : public ComponentBase
 {
     explicit PipelineComponent(
         const VertexShaderAssetPtr& vertexShader = {},
@@ -57,59 +65,83 @@ struct PipelineComponent final : public ComponentBase, public EventListener
         vertexShader(vertexShader),
         fragmentShader(fragmentShader)
     {
-        EventManager::Get().AddListener(Event::Type::AssetLoaded, this);
-
         if(vertexShader && fragmentShader)
             SetupPipeline();
     }
 
-    PipelineComponent(PipelineComponent&& other) noexcept
-        : ComponentBase("PipelineComponent"),
-          vertexShader(std::move(other.vertexShader)),
-          fragmentShader(std::move(other.fragmentShader)),
-          pipeline(std::move(other.pipeline))
+    void SetupPipeline()
     {
-        EventManager::Get().AddListener(Event::Type::AssetLoaded, this);
-    }
+        pipeline =
+            Renderer::Get().CreatePipelineState(
+                vertexShader->shader,
+                fragmentShader->shader
+            );
 
-    PipelineComponent(const PipelineComponent& other)
-        : ComponentBase("PipelineComponent"),
-          vertexShader(other.vertexShader),
-          fragmentShader(other.fragmentShader),
-          pipeline(other.pipeline)
-    {
-        EventManager::Get().AddListener(Event::Type::AssetLoaded, this);
+        variants.clear();
     }
 
-    ~PipelineComponent() override
+    struct Variant
     {
-        EventManager::Get().RemoveListener(Event::Type::AssetLoaded, this);
-    }
+        LLGL::PipelineState* pipeline{};
+
+        bool keywords = false; // The fragment shader was compiled with the material keywords
+        bool skinned = false; // The vertex shader reads the skinning buffer
+    };
 
-    void OnEvent(Event& event) override
+    // Added to the material variant for skinned meshes, the vertex shader is compiled with "SKINNED"
+    static constexpr uint32_t skinnedVariant = 1u << 31;
+
+    // Compiles the fragment shader with the keywords of a material variant (see MaterialAsset::GetVariant),
+    // must be called on the main thread before the variant is drawn
+    void SetupVariant(const uint32_t variant)
     {
-        if(event.GetType() == Event::Type::AssetLoaded) // Redundant
+        if(!pipeline || variants.contains(variant))
+            return;
+
+        const auto shader = Renderer::Get().GetShaderVariant(fragmentShader->shader, MaterialAsset::GetKeywords(variant));
+
+        auto vertex = vertexShader->shader;
+
+        if(variant & skinnedVariant)
         {
-            const auto& assetLoadedEvent = static_cast<AssetLoadedEvent&>(event);
+            // Warns once per shader if it doesn't support skinning
+            vertex = Renderer::Get().GetShaderVariant(
+                vertex, { "SKINNED" }, Renderer::Get().GetSkinnedVertexFormat().attributes, true
+            );
+
+            // Drawn in the bind pose, the same as the variant without skinning
+            if(vertex == vertexShader->shader)
+            {
+                SetupVariant(variant & ~skinnedVariant);
+
+                variants[variant] = variants[variant & ~skinnedVariant];
 
-            if(assetLoadedEvent.GetAsset() == vertexShader || assetLoadedEvent.GetAsset() == fragmentShader)
-                SetupPipeline();
+                return;
+            }
         }
+
+        variants[variant] =
+        {
+            Renderer::Get().CreatePipelineState(vertex, shader),
+            shader != fragmentShader->shader,
+            vertex != vertexShader->shader
+        };
     }
 
-    void SetupPipeline()
+    // Falls back to the pipeline without keywords if the variant wasn't set up
+    Variant GetVariant(const uint32_t variant) const
     {
-        pipeline =
-            Renderer::Get().CreatePipelineState(
-                vertexShader->shader,
-                fragmentShader->shader
-            );
+        const auto it = variants.find(variant);
+
+        return it != variants.end() ? it->second : Variant{ pipeline };
     }
 
     VertexShaderAssetPtr vertexShader;
     FragmentShaderAssetPtr fragmentShader;
 
     LLGL::PipelineState* pipeline{};
+
+    std::unordered_map<uint32_t, Variant> variants;
 };
 
 struct HierarchyComponent final : public ComponentBase
@@ -175,22 +207,18 @@ public:
     float bias = 0.00001f;
     float orthoExtent = 10.0f;
 
+    // Distance at which the light is faded out and culled. 0 derives it from the intensity,
+    // the scenes saved before it was added get that so they look the same
+    float range = 25.0f;
+
     bool shadowMap = false;
     bool orthographic = false;
 
+    // The largest tile the light can get in the shadow atlas, the actual one depends on its size on screen
     LLGL::Extent2D resolution;
 
-    LLGL::Texture* depth{};
-    LLGL::RenderTarget* renderTarget{};
-    LLGL::PipelineState* shadowMapPipeline{};
-
     // Make it a single light space matrix
     glm::mat4 projection{};
-
-private:
-    void CreateDepth(const LLGL::Extent2D& resolution);
-    void CreateRenderTarget(const LLGL::Extent2D& resolution);
-    void CreatePipeline();
 };
 
 struct ScriptComponent final : public ComponentBase
@@ -282,6 +310,55 @@ struct SoundComponent final : public ComponentBase
     SoundAssetPtr sound;
 
     bool attached = true;
+
+    // Runtime state, not serialized
+    bool virtualized = false; // Paused by the scene, keeps the playback cursor
+    uint32_t virtualizedStopCount = 0; // Sound::GetStopCount when it was paused, a stop after that is a real one
+
+    glm::vec3 lastPosition{ std::numeric_limits<float>::quiet_NaN() };
+    glm::vec3 lastRotation{};
+};
+
+// Plays the animations of the model in the MeshComponent, see AnimationManager.
+// The animation, speed, loop and playing are saved after the snapshot (see SceneLoader), the rest is runtime state
+struct AnimatorComponent final : public ComponentBase
+{
+    AnimatorComponent() : ComponentBase("AnimatorComponent") {}
+
+    // Crossfades from the current animation over fadeDuration seconds, 0 switches at once
+    void Play(const int32_t next, const float fadeDuration = 0.2f)
+    {
+        if(next == animation)
+            return;
+
+        previousAnimation = fadeDuration > 0.0f ? animation : -1;
+        previousTime = time;
+
+        animation = next;
+        time = 0.0f;
+
+        fade = fadeDuration > 0.0f ? 0.0f : 1.0f;
+        this->fadeDuration = fadeDuration;
+    }
+
+    int32_t animation = 0; // Index into AnimationAsset::animations
+
+    float time = 0.0f, speed = 1.0f;
+
+    bool loop = true, playing = true;
+
+    // The one being faded out, fade goes from 0 to 1
+    int32_t previousAnimation = -1;
+    float previousTime = 0.0f, fade = 1.0f, fadeDuration = 0.0f;
+
+    Pose pose, blendPose;
+
+    std::vector<glm::mat4> palette; // Empty until the first update, the mesh is drawn in the bind pose then
+
+    static constexpr uint32_t noPalette = ~0u;
+
+    // Where the palette starts in AnimationManager::GetPaletteBuffer this frame, noPalette if it isn't there
+    uint32_t paletteOffset = noPalette;
 };
 
 struct PrefabComponent final : public ComponentBase
@@ -73,7 +73,7 @@ struct BloomComponent final : public ComponentBase, public EventListener
     BloomComponent(BloomComponent&& other) noexcept;
     ~BloomComponent() override;
 
-    void SetupPostProcessing() const;
+    void SetupPostProcessing();
     void OnEvent(Event& event) override;
 
     template<class Archive>
@@ -93,8 +93,17 @@ struct BloomComponent final : public ComponentBase, public EventListener
         SetupPostProcessing();
     }
 
+    LLGL::Extent2D GetScaledResolution() const;
+
     float threshold = 1.0f, strength = 0.3f, resolutionScale = 8.0f;
 
+    // Progressive downsample/upsample over a mip chain that starts at half resolution,
+    // otherwise a separable blur at resolution / resolutionScale.
+    // Saved after the snapshot (see SceneLoader), the scenes saved before it keep the separable blur
+    bool mipChain = true;
+    int mipCount = 6; // More mips - wider bloom
+    float filterRadius = 1.0f; // Of the upsample tent filter, in texels
+
     LLGL::Extent2D resolution;
 
     LLGL::Sampler* sampler;
@@ -103,6 +112,8 @@ struct BloomComponent final : public ComponentBase, public EventListener
 
     std::array<PostProcessingPtr, 2> pingPong;
 
+    PostProcessingPtr downsample, upsample;
+
     std::function<void(LLGL::CommandBuffer*)> setThresholdUniforms;
 };
 
@@ -112,9 +123,11 @@ struct GTAOComponent final : public ComponentBase, public EventListener
     GTAOComponent(GTAOComponent&& other) noexcept;
     ~GTAOComponent() override;
 
-    void SetupPostProcessing() const;
+    void SetupPostProcessing();
     void OnEvent(Event& event) override;
 
+    LLGL::Extent2D GetScaledResolution() const;
+
     template<class Archive>
     void save(Archive& archive) const
     {
@@ -143,9 +156,22 @@ struct GTAOComponent final : public ComponentBase, public EventListener
     float thicknessMix = 0.2f;
     float maxStride = 8.0f;
 
+    // Rotates the sample directions every frame, accumulates the result with the reprojected history,
+    // then upsamples it to full resolution using the depth.
+    // Saved after the snapshot (see SceneLoader), the scenes saved before it stay without the history
+    bool temporal = true;
+    float historyWeight = 0.9f; // How much of the previous frames is kept
+
     LLGL::Extent2D resolution;
 
     PostProcessingPtr gtao, boxBlur;
+
+    std::array<PostProcessingPtr, 2> history; // r - occlusion, g - linear depth
+    PostProcessingPtr upsample;
+
+    glm::mat4 previousViewProjection{ 1.0f };
+    uint32_t frameIndex = 0;
+    bool historyValid = false;
 };
 
 struct SSRComponent final : public ComponentBase, public EventListener
@@ -157,6 +183,8 @@ struct SSRComponent final : public ComponentBase, public EventListener
     void SetupPostProcessing();
     void OnEvent(Event& event) override;
 
+    LLGL::Extent2D GetScaledResolution() const;
+
     template<class Archive>
     void save(Archive& archive) const
     {
@@ -174,16 +202,32 @@ struct SSRComponent final : public ComponentBase, public EventListener
         SetupPostProcessing();
     }
 
-    float resolutionScale = 1.0f;
+    float resolutionScale = 2.0f;
 
     int maxSteps = 100;
     int maxBinarySearchSteps = 5;
 
     float rayStep = 0.02;
 
+    // Traces the rays through the Hi-Z pyramid instead of marching them with a fixed step,
+    // then accumulates the reflections with the reprojected history.
+    // Saved after the snapshot (see SceneLoader), the scenes saved before it keep the fixed step march
+    bool hiZ = true;
+    float maxDistance = 50.0f;
+    float thickness = 0.5f; // Rays pass behind the surfaces that are further than that
+
+    bool temporal = true;
+    float historyWeight = 0.9f; // How much of the previous frames is kept
+
     LLGL::Extent2D resolution;
 
-    PostProcessingPtr ssr;
+    PostProcessingPtr ssr, hiZTrace;
+
+    std::array<PostProcessingPtr, 2> history;
+
+    glm::mat4 previousViewProjection{ 1.0f };
+    uint32_t frameIndex = 0;
+    bool historyValid = false;
 };
 
 }
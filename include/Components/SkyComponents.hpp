@@ -1,6 +1,8 @@
 #pragma once
 #include <ComponentBase.hpp>
 
+#include <optional>
+
 namespace lustra
 {
 
@@ -8,9 +10,15 @@ struct ProceduralSkyComponent : public ComponentBase
 {
     ProceduralSkyComponent(const LLGL::Extent2D& resolution = { 1024, 1024 });
     ProceduralSkyComponent(ProceduralSkyComponent&&);
+    ~ProceduralSkyComponent();
 
+    // Renders the sky with the current parameters, skips the disk cache since
+    // the parameters that are changed at runtime (e.g. the time of day) rarely repeat
     void Build();
 
+    // Continues the time-sliced build, called every frame by the scene
+    void Update();
+
     void MakeSetUniforms();
 
     template<class Archive>
@@ -27,12 +35,17 @@ struct ProceduralSkyComponent : public ComponentBase
     {
         archive(time, cirrus, cumulus, resolution);
 
-        Build();
+        BuildEnvironment(true);
     }
 
     float time = 40.0f, cirrus = 0.0f, cumulus = 0.0f;
     int flip = 0;
 
+    // Build spreads the work over the next frames and the current environment stays in use until
+    // the new one is complete. The irradiance is approximated with spherical harmonics,
+    // good for a smooth time of day. Saved after the snapshot (see SceneLoader)
+    bool timeSliced = false;
+
     EnvironmentAssetPtr asset;
 
     std::function<void(LLGL::CommandBuffer*)> setUniforms;
@@ -41,10 +54,20 @@ struct ProceduralSkyComponent : public ComponentBase
     LLGL::PipelineState* pipeline{};
 
 private:
+    // Only the skies from the constructor and the scene file are cached, their parameters are static
+    void BuildEnvironment(bool cache);
+
     void DefaultTextures() const;
+
+    void BeginBuild();
+
+private:
+    std::optional<PBRManager::IncrementalBuild> build;
+
+    bool rebuild = false; // Build was called while the previous one was in progress
 };
 
-struct HDRISkyComponent : public ComponentBase, public EventListener
+struct HDRISkyComponent : public ComponentBase
 {
 public:
     HDRISkyComponent(
@@ -55,7 +78,6 @@ public:
     ~HDRISkyComponent();
 
     void Build();
-    void OnEvent(Event& event) override;
 
     template<class Archive>
     void save(Archive& archive) const
@@ -86,6 +108,11 @@ public:
 private:
     void SetupSkyPipeline();
     void DefaultTextures() const;
+
+    void Subscribe();
+
+private:
+    EventBus::Subscription assetLoadedSubscription;
 };
 
 }
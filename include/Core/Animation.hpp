@@ -1,16 +1,57 @@
 #pragma once
+#include <Skeleton.hpp>
+
+#include <glm/gtc/quaternion.hpp>
 
 namespace lustra
 {
 
+// A clip resampled at sampleRate, every joint has a key on every frame. That way the keys are never
+// searched for and a frame of all the joints lies in one place:
+// - rotations are 16-bit normalized integers
+// - translations and scales are 16-bit fractions of their range in the clip
+// 20 bytes per joint per frame, the two frames around the time are interpolated
 class Animation
 {
 public:
     struct Keyframe
     {
-        float timestamp;
+        float timestamp; // Seconds
 
+        glm::vec3 translation{};
+        glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+        glm::vec3 scale{ 1.0f };
     };
+
+    static constexpr float sampleRate = 30.0f;
+
+public:
+    // tracks[joint][frame], every track has a keyframe on every frame, see sampleRate
+    Animation(std::string name, float duration, const std::vector<std::vector<Keyframe>>& tracks);
+
+    // Time is clamped to the duration, the pose gets as many joints as the tracks
+    void Sample(float time, Pose& pose) const;
+
+    const std::string& GetName() const;
+    float GetDuration() const;
+
+    size_t GetJointCount() const;
+    size_t GetFrameCount() const;
+
+private:
+    std::string name;
+
+    float duration = 0.0f;
+
+    size_t jointCount = 0, frameCount = 0;
+
+    // [frame][component][joint]
+    std::vector<int16_t> rotations;
+    std::vector<uint16_t> translations, scales;
+
+    // Dequantized as min + value * extent / 65535
+    glm::vec3 translationMin{}, translationExtent{};
+    glm::vec3 scaleMin{}, scaleExtent{};
 };
 
 }
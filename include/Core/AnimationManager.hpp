@@ -1,18 +1,53 @@
 #pragma once
+#include <Renderer.hpp>
 #include <Singleton.hpp>
 
+#include <span>
+#include <vector>
+
 namespace lustra
 {
 
-class Entity;
+struct AnimatorComponent;
+struct AnimationAsset;
 
+// Advances the animators and computes their skinning palettes.
+// Time moves for everyone, so a character that comes back into view is where it should be,
+// but only the visible ones are sampled, spread over the threads. Their palettes are packed
+// into one storage buffer with a single upload per frame, see AnimatorComponent::paletteOffset
 class AnimationManager final : public Singleton<AnimationManager>
 {
 public:
-    void Update(Entity& entity, float deltaTime);
+    struct Instance
+    {
+        AnimatorComponent* animator;
+
+        const AnimationAsset* animation;
+
+        bool visible; // In the camera frustum or in a shadow map
+    };
+
+public:
+    void Update(std::span<const Instance> instances, float deltaTime);
+
+    LLGL::Buffer* GetPaletteBuffer() const;
+
+private: // Singleton-related
+    AnimationManager() = default;
+
+    friend class Singleton<AnimationManager>;
+
+private:
+    static void Advance(AnimatorComponent& animator, const AnimationAsset& animation, float deltaTime);
+    static void Evaluate(AnimatorComponent& animator, const AnimationAsset& animation);
+
+    void Upload(std::span<const Instance> instances);
 
 private:
+    std::vector<glm::mat4> palettes; // Of the visible animators, one after another
 
+    LLGL::Buffer* paletteBuffer{};
+    uint64_t paletteCapacity = 0; // In matrices
 };
 
 }
@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace lustra
+{
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov's algorithm).
+// Every cell has its own sequence number, so producers only contend on a single
+// fetch-and-increment and never wait for each other
+template<class T>
+class ConcurrentQueue
+{
+public:
+    explicit ConcurrentQueue(size_t capacity = 1024)
+    {
+        size_t size = 2;
+
+        while(size < capacity)
+            size <<= 1;
+
+        mask = size - 1;
+        cells = std::make_unique<Cell[]>(size);
+
+        for(size_t i = 0; i < size; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~ConcurrentQueue()
+    {
+        while(TryConsume([](T&&) {}));
+    }
+
+    ConcurrentQueue(const ConcurrentQueue&) = delete;
+    ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+    // Returns false if the queue is full
+    template<class... Args>
+    bool TryPush(Args&&... args)
+    {
+        Cell* cell;
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            cell = &cells[position & mask];
+
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if(difference == 0)
+            {
+                if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(difference < 0)
+                return false;
+            else
+                position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+
+        new(cell->storage) T(std::forward<Args>(args)...);
+
+        cell->sequence.store(position + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Returns false if the queue is empty
+    bool TryPop(T& value)
+    {
+        return TryConsume([&](T&& popped) { value = std::move(popped); });
+    }
+
+    // Pops a single element and hands it to the function, doesn't require T to be default-constructible
+    template<class Function>
+    bool TryConsume(Function&& function)
+    {
+        Cell* cell;
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            cell = &cells[position & mask];
+
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+            if(difference == 0)
+            {
+                if(dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(difference < 0)
+                return false;
+            else
+                position = dequeuePosition.load(std::memory_order_relaxed);
+        }
+
+        auto stored = std::launder(reinterpret_cast<T*>(cell->storage));
+
+        function(std::move(*stored));
+        stored->~T();
+
+        cell->sequence.store(position + mask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    size_t GetCapacity() const
+    {
+        return mask + 1;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    static constexpr size_t cacheLineSize = 64;
+
+    size_t mask{};
+
+    std::unique_ptr<Cell[]> cells;
+
+    alignas(cacheLineSize) std::atomic<size_t> enqueuePosition{ 0 };
+    alignas(cacheLineSize) std::atomic<size_t> dequeuePosition{ 0 };
+};
+
+}
@@ -30,6 +30,26 @@ void load(Archive& archive, Extent2D& extent)
 namespace lustra
 {
 
+// Budget of the shadow map atlas, all sizes are in texels and should be powers of two
+struct ShadowAtlasConfig
+{
+    uint32_t size = 4096;
+    uint32_t maxShadows = 32;
+    uint32_t maxTileSize = 2048;
+    uint32_t minTileSize = 128;
+
+    template<class Archive>
+    void serialize(Archive& archive)
+    {
+        archive(
+            CEREAL_NVP(size),
+            CEREAL_NVP(maxShadows),
+            CEREAL_NVP(maxTileSize),
+            CEREAL_NVP(minTileSize)
+        );
+    }
+};
+
 struct Config
 {
     LLGL::Extent2D resolution{ 1280, 720 };
@@ -43,6 +63,13 @@ struct Config
     std::string imGuiFontPath;
     std::string imGuiLayoutPath;
 
+    ShadowAtlasConfig shadowAtlas;
+
+    // Linked shader programs, empty to always compile them from scratch
+    std::string pipelineCachePath = "cache/pipelines";
+    // Baked image based lighting, empty to always render it
+    std::string environmentCachePath = "cache/environments";
+
     std::filesystem::path configPath;
 
     void Save(const std::filesystem::path& path) const
@@ -85,6 +112,20 @@ struct Config
             CEREAL_NVP(imGuiFontPath),
             CEREAL_NVP(imGuiLayoutPath)
         );
+
+        // Configs written before the atlas existed don't have it, the defaults are used then
+        try
+        {
+            archive(CEREAL_NVP(shadowAtlas));
+        }
+        catch(const cereal::Exception&) {}
+
+        try
+        {
+            archive(CEREAL_NVP(pipelineCachePath));
+            archive(CEREAL_NVP(environmentCachePath));
+        }
+        catch(const cereal::Exception&) {}
     }
 };
 
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace lustra
+{
+
+// FNV-1a, unlike std::hash the result is the same between launches, so it can name files on disk
+class Hash
+{
+public:
+    Hash& Add(const void* data, const size_t size)
+    {
+        const auto bytes = static_cast<const uint8_t*>(data);
+
+        for(size_t i = 0; i < size; i++)
+        {
+            value ^= bytes[i];
+            value *= 1099511628211ull;
+        }
+
+        return *this;
+    }
+
+    template<class T> requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+    Hash& Add(const T value)
+    {
+        return Add(&value, sizeof(value));
+    }
+
+    // The size goes first, so { "ab", "c" } and { "a", "bc" } differ
+    Hash& Add(const std::string_view string)
+    {
+        Add(string.size());
+
+        return Add(string.data(), string.size());
+    }
+
+    Hash& Add(const char* string)
+    {
+        return Add(std::string_view(string ? string : ""));
+    }
+
+    uint64_t Get() const
+    {
+        return value;
+    }
+
+private:
+    uint64_t value = 14695981039346656037ull;
+};
+
+}
@@ -1,7 +1,12 @@
 #pragma once
 #include <Singleton.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 // Jesus Christ, ANOTHER Windows compatibility bullshit.
@@ -20,16 +25,52 @@ class Multithreading final : public Singleton<Multithreading>
 public:
     using Job = std::pair<std::function<void()>, std::function<void()>>;
 
+    ~Multithreading() override;
+
     void Update();
 
     void AddJob(const Job& job);
 
     size_t GetJobsNum() const;
 
+    // How many chunks ParallelFor splits count into, at most one per hardware thread
+    static size_t GetChunkCount(size_t count, size_t minChunkSize = 16);
+
+    // Splits [0, count) into chunks of at least minChunkSize that run on the worker threads.
+    // Returns when all of them are done, the calling thread runs the first chunk
+    static void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& function, size_t minChunkSize = 16);
+
+    // Same as ParallelFor, but also passes the index of the chunk, less than GetChunkCount()
+    static void ParallelForChunks(
+        size_t count,
+        const std::function<void(size_t chunk, size_t begin, size_t end)>& function,
+        size_t minChunkSize = 16
+    );
+
+private: // Singleton-related
+    Multithreading();
+
+    friend class Singleton<Multithreading>;
+
+private:
+    void RunWorker();
+
+    // Runs one of the queued chunks on the calling thread, false if there were none
+    bool RunTask();
+
 private:
     using ManagedJob = std::pair<std::future<void>, std::function<void()>>;
 
     std::vector<ManagedJob> jobs;
-};
 
+    // Started once for ParallelFor. The jobs keep their own threads, a loading job could
+    // take seconds and hold back the chunks that are waited for every frame
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    bool stop = false;
+};
 }
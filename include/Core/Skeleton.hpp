@@ -0,0 +1,51 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lustra
+{
+
+// Local transforms of the joints. Every component is a separate array, so sampling and blending
+// are plain loops over contiguous floats that the compiler turns into SIMD code
+struct Pose
+{
+    void Resize(size_t jointCount);
+
+    size_t GetJointCount() const;
+
+    // Lerps to the other pose, the rotations are nlerped along the shortest path
+    void Blend(const Pose& other, float weight);
+
+    std::array<std::vector<float>, 3> translation, scale;
+    std::array<std::vector<float>, 4> rotation; // x, y, z, w
+};
+
+struct Skeleton
+{
+    struct Joint
+    {
+        std::string name;
+
+        int32_t parent = -1; // Parents go before their children
+
+        glm::mat4 inverseBind{ 1.0f };
+    };
+
+    // -1 if there's no such joint
+    int32_t Find(std::string_view name) const;
+
+    // Model space joint transforms multiplied by the inverse bind matrices, what the vertex shader needs
+    void ComputePalette(const Pose& pose, std::vector<glm::mat4>& palette) const;
+
+    std::vector<Joint> joints;
+
+    Pose restPose; // The joints the animations don't move stay there
+
+    glm::mat4 globalInverse{ 1.0f }; // Of the root node
+};
+
+}
@@ -0,0 +1,245 @@
+#pragma once
+#include <ConcurrentQueue.hpp>
+#include <Singleton.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace lustra
+{
+
+// Typed counterpart of the EventManager:
+// - every event type gets a sequential id on first use, so a dispatch is an array index, not a hash lookup
+// - handlers of one type are stored contiguously and receive a span of events instead of one virtual call per event
+// - Post() is lock-free and can be called from any thread, posted events are delivered in batches on Flush()
+class EventBus final : public Singleton<EventBus>
+{
+public:
+    template<class T>
+    using Handler = std::function<void(std::span<const T>)>;
+
+    struct Subscription
+    {
+        uint32_t typeId = invalidId;
+        uint32_t handlerId = invalidId;
+
+        bool IsValid() const { return typeId != invalidId; }
+    };
+
+public:
+    ~EventBus() override;
+
+    template<class T>
+    Subscription Subscribe(Handler<T> handler)
+    {
+        return { TypeId<T>(), GetChannel<T>().Add(std::move(handler)) };
+    }
+
+    void Unsubscribe(Subscription& subscription);
+
+    // Immediate delivery, main thread only
+    template<class T>
+    void Publish(const T& event)
+    {
+        GetChannel<T>().Deliver(std::span<const T>(&event, 1));
+    }
+
+    // Immediate delivery of events that were already collected by the caller, main thread only
+    template<class T>
+    void PublishBatch(std::span<const T> events)
+    {
+        GetChannel<T>().Deliver(events);
+    }
+
+    // Deferred delivery, safe to call from any thread
+    template<class T>
+    void Post(T event)
+    {
+        GetChannel<T>().Enqueue(std::move(event));
+    }
+
+    // Delivers everything that was posted since the last call, main thread only
+    void Flush();
+
+public:
+    template<class T>
+    static uint32_t TypeId()
+    {
+        static const uint32_t id = NextTypeId();
+
+        return id;
+    }
+
+private:
+    static constexpr uint32_t invalidId = ~0u;
+    static constexpr uint32_t maxEventTypes = 64;
+    static constexpr size_t queueCapacity = 4096;
+
+    static uint32_t NextTypeId();
+
+private:
+    class ChannelBase
+    {
+    public:
+        virtual ~ChannelBase() = default;
+
+        virtual void Flush() = 0;
+        virtual void Remove(uint32_t handlerId) = 0;
+    };
+
+    template<class T>
+    class Channel final : public ChannelBase
+    {
+    public:
+        Channel() : queue(queueCapacity) {}
+
+        uint32_t Add(Handler<T> handler)
+        {
+            const auto id = nextHandlerId++;
+
+            if(dispatching)
+                pending.push_back({ id, true, std::move(handler) });
+            else
+                handlers.push_back({ id, true, std::move(handler) });
+
+            return id;
+        }
+
+        void Remove(const uint32_t handlerId) override
+        {
+            // Don't destroy the handler here, it might be the one that is running right now
+            for(auto& entry : handlers)
+                if(entry.id == handlerId)
+                {
+                    entry.alive = false;
+                    removed = true;
+                }
+
+            std::erase_if(pending, [&](const auto& entry) { return entry.id == handlerId; });
+
+            if(!dispatching)
+                Compact();
+        }
+
+        void Deliver(std::span<const T> events)
+        {
+            if(events.empty())
+                return;
+
+            const bool nested = dispatching;
+
+            dispatching = true;
+
+            for(size_t i = 0; i < handlers.size(); i++)
+                if(handlers[i].alive)
+                    handlers[i].handler(events);
+
+            dispatching = nested;
+
+            if(!dispatching)
+                Compact();
+        }
+
+        void Enqueue(T&& event)
+        {
+            if(!queue.TryPush(std::move(event)))
+            {
+                // The ring is full, don't lose the event
+                std::lock_guard lock(overflowMutex);
+
+                overflow.push_back(std::move(event));
+                hasOverflow.store(true, std::memory_order_release);
+            }
+        }
+
+        void Flush() override
+        {
+            batch.clear();
+
+            while(queue.TryConsume([&](T&& event) { batch.push_back(std::move(event)); }));
+
+            if(hasOverflow.load(std::memory_order_acquire))
+            {
+                std::lock_guard lock(overflowMutex);
+
+                std::move(overflow.begin(), overflow.end(), std::back_inserter(batch));
+
+                overflow.clear();
+                hasOverflow.store(false, std::memory_order_relaxed);
+            }
+
+            Deliver(batch);
+        }
+
+    private:
+        void Compact()
+        {
+            if(removed)
+            {
+                std::erase_if(handlers, [](const auto& entry) { return !entry.alive; });
+                removed = false;
+            }
+
+            if(!pending.empty())
+            {
+                std::move(pending.begin(), pending.end(), std::back_inserter(handlers));
+                pending.clear();
+            }
+        }
+
+    private:
+        bool dispatching = false;
+        bool removed = false;
+
+        uint32_t nextHandlerId = 0;
+
+        struct Entry
+        {
+            uint32_t id;
+            bool alive;
+
+            Handler<T> handler;
+        };
+
+        std::vector<Entry> handlers, pending;
+
+        std::vector<T> batch;
+
+        ConcurrentQueue<T> queue;
+
+        std::mutex overflowMutex;
+        std::atomic<bool> hasOverflow = false;
+        std::vector<T> overflow;
+    };
+
+private:
+    template<class T>
+    Channel<T>& GetChannel()
+    {
+        const auto id = TypeId<T>();
+
+        auto channel = channels[id].load(std::memory_order_acquire);
+
+        if(!channel)
+        {
+            auto newChannel = new Channel<T>();
+
+            if(channels[id].compare_exchange_strong(channel, newChannel, std::memory_order_acq_rel))
+                channel = newChannel;
+            else
+                delete newChannel; // Someone else was faster
+        }
+
+        return *static_cast<Channel<T>*>(channel);
+    }
+
+private:
+    std::array<std::atomic<ChannelBase*>, maxEventTypes> channels{};
+};
+
+}
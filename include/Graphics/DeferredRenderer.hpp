@@ -1,6 +1,7 @@
 #pragma once
 #include <Mesh.hpp>
 #include <RendererBase.hpp>
+#include <EventBus.hpp>
 #include <EventManager.hpp>
 #include <TextureAsset.hpp>
 #include <AssetManager.hpp>
@@ -27,7 +28,6 @@ public:
     LLGL::RenderTarget* GetPrimaryRenderTarget() override;
     LLGL::Texture* GetDepth() override;
 
-    LLGL::Texture* GetPosition() const;
     LLGL::Texture* GetAlbedo() const;
     LLGL::Texture* GetNormal() const;
     LLGL::Texture* GetCombined() const;
@@ -36,6 +36,10 @@ public:
 private:
     DeferredRenderer();
 
+    void CreateGBuffer(const LLGL::Extent2D& resolution);
+
+    void OnAssetLoaded(std::span<const AssetLoadedEvent> events);
+
     friend class Singleton<DeferredRenderer>;
 
 private:
@@ -43,7 +47,6 @@ private:
 
     LLGL::PipelineLayoutDescriptor layoutDesc;
 
-    LLGL::Texture* gBufferPosition;
     LLGL::Texture* gBufferAlbedo;
     LLGL::Texture* gBufferNormal;
     LLGL::Texture* gBufferCombined;
@@ -55,6 +58,8 @@ private:
 
     MeshPtr rect;
     LLGL::PipelineState* rectPipeline;
+
+    EventBus::Subscription assetLoadedSubscription;
 };
 
 }
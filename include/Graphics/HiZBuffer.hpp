@@ -0,0 +1,50 @@
+#pragma once
+#include <Mesh.hpp>
+#include <Renderer.hpp>
+#include <Singleton.hpp>
+
+#include <vector>
+
+namespace lustra
+{
+
+// Min/max depth pyramid of the G-buffer, rebuilt once per frame:
+// - level 0 is the depth buffer itself, every next level covers 2x2 texels of the previous one
+// - r is the closest depth under the texel, rays can skip the whole texel while they're in front of it
+// - g is the farthest depth under the texel, anything whose closest depth is behind it is occluded
+// Every level is rendered into its own texture and copied into the pyramid, so a mip is never sampled while it's attached
+class HiZBuffer final : public Singleton<HiZBuffer>
+{
+public:
+    // Recreates the pyramid if the resolution of the depth buffer changed
+    void Build(LLGL::Texture* depth);
+
+    LLGL::Texture* GetTexture() const;
+    uint32_t GetLevelCount() const;
+    LLGL::Extent2D GetResolution() const;
+
+private: // Singleton-related
+    HiZBuffer();
+
+    friend class Singleton<HiZBuffer>;
+
+private:
+    void Create(const LLGL::Extent2D& resolution);
+    void CreatePipeline();
+
+    void CopyLevel(LLGL::CommandBuffer* commandBuffer, uint32_t level) const;
+
+private:
+    LLGL::Extent2D resolution;
+    uint32_t levelCount = 0;
+
+    LLGL::Texture* texture{};
+
+    std::vector<LLGL::Texture*> scratch; // One single-mip texture per level
+    std::vector<LLGL::RenderTarget*> levels;
+
+    MeshPtr rect;
+    LLGL::PipelineState* pipeline{};
+};
+
+}
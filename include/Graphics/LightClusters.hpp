@@ -0,0 +1,99 @@
+#pragma once
+#include <Renderer.hpp>
+#include <Singleton.hpp>
+
+#include <span>
+#include <vector>
+
+namespace lustra
+{
+
+// Assigns lights to a view-space froxel grid on the CPU:
+// - x and y split the screen into tiles, z is split exponentially between the near and far planes
+// - every cluster gets a range in a compact light index list, so the lighting pass
+//   only iterates over the lights that can actually reach the pixel
+// All scenes share the same storage buffers, they are rebuilt every frame
+class LightClusters final : public Singleton<LightClusters>
+{
+public:
+    static constexpr uint32_t gridX = 16;
+    static constexpr uint32_t gridY = 9;
+    static constexpr uint32_t gridZ = 24;
+    static constexpr uint32_t clusterCount = gridX * gridY * gridZ;
+
+    struct Light
+    {
+        // Storage buffer padding (std430) //
+        // | //
+        // V //
+        alignas(16) int shadow; // Index in the shadow buffer, -1 if the light doesn't cast shadows
+        alignas(16) glm::vec3 position;
+        alignas(16) glm::vec3 direction;
+        alignas(16) glm::vec3 color;
+
+        float intensity, cutoff, outerCutoff;
+        float radius; // The light doesn't affect anything further than that, infinite ones go into every cluster
+    };
+
+    struct Cluster
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+public:
+    void Build(
+        std::span<const Light> lights,
+        const glm::mat4& view,
+        const glm::mat4& projection,
+        float near,
+        float far
+    );
+
+    // Writes the lights, the clusters and the index list, grows the buffers if needed
+    void Upload(std::span<const Light> lights);
+
+    // slice = log(depth) * scale - bias
+    float GetSliceScale() const;
+    float GetSliceBias() const;
+
+    size_t GetIndexCount() const;
+
+    LLGL::Buffer* GetLightBuffer() const;
+    LLGL::Buffer* GetClusterBuffer() const;
+    LLGL::Buffer* GetIndexBuffer() const;
+
+private: // Singleton-related
+    LightClusters();
+
+    friend class Singleton<LightClusters>;
+
+private:
+    static constexpr uint64_t initialLights = 256;
+    static constexpr uint64_t initialIndices = 16384;
+
+    static void Reserve(LLGL::Buffer*& buffer, uint64_t& capacity, uint64_t count, uint32_t stride);
+
+    uint32_t GetSlice(float depth) const;
+
+private:
+    float near = 0.1f, far = 1000.0f;
+    float sliceScale = 0.0f, sliceBias = 0.0f;
+
+    std::vector<Cluster> clusters;
+    std::vector<uint32_t> indices;
+
+    // (cluster, light) pairs, reused every frame
+    std::vector<std::pair<uint32_t, uint32_t>> assignments;
+
+    LLGL::Buffer* lightBuffer{};
+    LLGL::Buffer* clusterBuffer{};
+    LLGL::Buffer* indexBuffer{};
+
+    uint64_t lightCapacity = 0;
+    uint64_t indexCapacity = 0;
+};
+
+static_assert(sizeof(LightClusters::Light) == 80, "LightClusters::Light must match the std430 layout of the shader");
+
+}
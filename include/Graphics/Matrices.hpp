@@ -15,8 +15,16 @@ public:
         glm::mat4 model;
         glm::mat4 view;
         glm::mat4 projection;
+
+        // Set by the mesh that is drawn (see Mesh::BindBuffers), position = position * scale + offset.
+        // w of the offset is 1 when the normals are octahedral-encoded
+        glm::vec4 positionScale = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+        glm::vec4 positionOffset = glm::vec4(0.0f);
     };
 
+    // Of a skinning palette, the skeletons with more joints aren't animated (see ModelLoader)
+    static constexpr uint32_t maxJoints = 128;
+
     Matrices();
 
     void PushMatrix();
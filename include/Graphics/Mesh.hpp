@@ -1,6 +1,8 @@
 #pragma once
 #include <Utils.hpp>
 
+#include <array>
+
 namespace lustra
 {
 
@@ -11,37 +13,108 @@ struct Vertex
     glm::vec2 coords;
 };
 
+// Up to 4 joints per vertex, the weights are normalized so they add up to 255
+struct VertexSkin
+{
+    std::array<uint8_t, 4> joints{};
+    std::array<uint8_t, 4> weights{};
+};
+
 class Mesh
 {
+public:
+    struct Bounds
+    {
+        glm::vec3 min{}, max{};
+    };
+
+    // A simplified version of the mesh, shares the vertices with the full detail
+    struct Lod
+    {
+        std::vector<uint32_t> indices;
+
+        float error = 0.0f; // Relative to the size of the bounds
+    };
+
 public:
     Mesh() = default;
-    Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, bool setupBuffers = true);
+    // A compressed mesh takes 16 bytes per vertex instead of 32, see CompressedVertex. It's only
+    // compressed if the texture coordinates fit into half floats without losing too much
+    Mesh(
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        bool setupBuffers = true,
+        bool compress = false
+    );
 
     void SetupBuffers();
+    // Meshes don't release their buffers on destruction, the renderer may be gone by then
+    void ReleaseBuffers();
 
     void CreateCube();
     void CreatePlane();
 
-    void BindBuffers(LLGL::CommandBuffer* commandBuffer, bool bindMatrices = true) const;
+    // positionsOnly binds a stream with nothing but the positions, for the depth-only passes
+    void BindBuffers(LLGL::CommandBuffer* commandBuffer, bool bindMatrices = true, bool positionsOnly = false) const;
+
+    // 0 is the full detail
+    void Draw(LLGL::CommandBuffer* commandBuffer, size_t lod = 0) const;
 
-    void Draw(LLGL::CommandBuffer* commandBuffer) const;
+    // Must be set before SetupBuffers(), all the levels go into one index buffer
+    void SetLods(std::vector<Lod> lods);
+    // Must be set before SetupBuffers() as well, one per vertex. Skinned meshes aren't compressed
+    void SetSkin(std::vector<VertexSkin> skin);
+
+    // Including the full detail
+    size_t GetLodCount() const;
+    float GetLodError(size_t lod) const;
 
     std::vector<Vertex> GetVertices() const;
-    std::vector<uint32_t> GetIndices() const;
+    // Of a LOD, 0 and the levels past the last one are the full detail
+    std::vector<uint32_t> GetIndices(size_t lod = 0) const;
+
+    // Local space, computed in SetupBuffers()
+    Bounds GetBounds() const;
+
+    bool IsCompressed() const;
+    bool IsSkinned() const;
+
+private:
+    // Dequantized by the vertex shader with the bounds, see Matrices::Binding
+    struct CompressedVertex
+    {
+        std::array<uint16_t, 4> position; // Normalized to the bounds, w is padding
+        std::array<int16_t, 2> normal;    // Octahedral
+        std::array<uint16_t, 2> coords;   // Half floats
+    };
 
 private:
     void CreateVertexBuffer();
+    void CreateCompressedVertexBuffers();
+    void CreateSkinnedVertexBuffer();
     void CreateIndexBuffer();
 
-private:
-    LLGL::VertexFormat vertexFormat;
+    void ComputeBounds();
+
+    bool CanCompress() const;
 
+private:
     LLGL::Buffer* vertexBuffer{};
+    LLGL::Buffer* positionBuffer{}; // Only for compressed meshes, the others bind the whole vertices
     LLGL::Buffer* indexBuffer{};
     LLGL::Buffer* matricesBuffer{};
 
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+
+    std::vector<VertexSkin> skin;
+
+    std::vector<Lod> lods;
+    std::vector<std::pair<uint32_t, uint32_t>> lodRanges; // First index and index count in the index buffer
+
+    Bounds bounds;
+
+    bool compress = false, compressed = false;
 };
 
 using MeshPtr = std::shared_ptr<Mesh>;
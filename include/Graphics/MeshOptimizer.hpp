@@ -0,0 +1,92 @@
+#pragma once
+#include <Mesh.hpp>
+
+#include <vector>
+
+namespace lustra
+{
+
+// Import-time reordering of the mesh data, see "Fast Triangle Reordering for Vertex Locality
+// and Reduced Overdraw" (Sander, Nehab, Barczak):
+// - the triangles are ordered for the post-transform vertex cache (Tipsify)
+// - the cache-friendly clusters are split further and sorted so the ones facing outwards are drawn first
+// - the vertices are put in the order the triangles first use them
+// - a chain of LODs is made with quadric error edge collapses (Garland, Heckbert)
+// The vertices are expected to be welded already (aiProcess_JoinIdenticalVertices)
+class MeshOptimizer
+{
+public:
+    struct Statistics
+    {
+        size_t triangles = 0;
+        size_t vertices = 0, optimizedVertices = 0;
+        size_t misses = 0, optimizedMisses = 0; // Of a FIFO cache with cacheSize entries
+        size_t lods = 0; // Counted by the caller, Optimize doesn't make them
+
+        // Average cache miss ratio, transformed vertices per triangle
+        float GetACMR() const;
+        float GetOptimizedACMR() const;
+
+        Statistics& operator+=(const Statistics& other);
+    };
+
+    static constexpr uint32_t cacheSize = 16;
+
+public:
+    // The skin, if there's one, is reordered along with the vertices
+    static Statistics Optimize(
+        std::vector<Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        std::vector<VertexSkin>* skin = nullptr
+    );
+
+    static size_t CountCacheMisses(const std::vector<uint32_t>& indices, size_t vertexCount);
+
+    // Returns the first triangle of every cluster, a cluster starts where the cache is effectively flushed
+    static std::vector<size_t> OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    // threshold is how much worse than its hard cluster the ACMR of a split cluster may get
+    static void OptimizeOverdraw(
+        std::vector<uint32_t>& indices,
+        const std::vector<Vertex>& vertices,
+        const std::vector<size_t>& hardClusters,
+        float threshold = 1.05f
+    );
+
+    // Drops the vertices no triangle uses
+    static void OptimizeVertexFetch(
+        std::vector<Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        std::vector<VertexSkin>* skin = nullptr
+    );
+
+    // Collapses edges onto existing vertices until there are at most targetIndexCount indices left or the next
+    // collapse would move the surface by more than maxError (relative to the size of the mesh).
+    // Borders and UV seams stay where they are. error is the largest error of the result
+    static std::vector<uint32_t> Simplify(
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t targetIndexCount,
+        float maxError,
+        float& error
+    );
+
+    // Halves the triangles every level until maxLods levels are made or the error bound stops it.
+    // Call after Optimize, the LODs are ordered for the vertex cache as well
+    static std::vector<Mesh::Lod> GenerateLods(
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t maxLods = 4,
+        float maxError = 0.05f
+    );
+
+private:
+    static std::vector<size_t> SplitClusters(
+        const std::vector<uint32_t>& indices,
+        size_t vertexCount,
+        const std::vector<size_t>& hardClusters,
+        float threshold
+    );
+};
+
+}
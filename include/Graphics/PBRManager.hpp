@@ -5,6 +5,9 @@
 #include <ModelAsset.hpp>
 #include <TextureAsset.hpp>
 
+#include <filesystem>
+#include <iosfwd>
+
 namespace lustra
 {
 
@@ -12,20 +15,78 @@ namespace lustra
 class PBRManager final : public Singleton<PBRManager>
 {
 public:
+    // State of a time-sliced build, the textures are its own until it's complete
+    struct IncrementalBuild
+    {
+        LLGL::Extent2D resolution;
+        TextureAssetPtr environmentMap;
+
+        LLGL::PipelineState* convertPipeline{};
+        std::function<void(LLGL::CommandBuffer*)> setConvertUniforms;
+
+        LLGL::Texture* cubeMap{};
+        LLGL::Texture* irradiance{};
+        LLGL::Texture* prefiltered{};
+
+        // Of the previous step, it might have been recorded into a frame that wasn't submitted yet
+        std::vector<LLGL::RenderTarget*> renderTargets;
+
+        uint32_t step = 0;
+    };
+
+public:
+    // cacheKey identifies the source and the parameters of the environment (e.g. the file and its time stamp),
+    // the result is stored on disk under it and loaded instead of rendering the next time. 0 turns it off.
+    // Only pass it for the parameters that don't change at runtime, the cache drops the least recently used files past its limit
     EnvironmentAssetPtr Build(
         const LLGL::Extent2D& resolution,
         const TextureAssetPtr& environmentMap,
         EnvironmentAssetPtr environmentAsset = nullptr,
         LLGL::PipelineState* customConvertPipeline = nullptr,
+        const std::function<void(LLGL::CommandBuffer*)>& setConvertUniforms = nullptr,
+        uint64_t cacheKey = 0
+    );
+
+    // Same as Build, but nothing is rendered until Step is called. The disk cache is skipped,
+    // this is meant for environments that keep changing (e.g. the time of day)
+    IncrementalBuild BeginBuild(
+        const LLGL::Extent2D& resolution,
+        const TextureAssetPtr& environmentMap,
+        LLGL::PipelineState* customConvertPipeline = nullptr,
         const std::function<void(LLGL::CommandBuffer*)>& setConvertUniforms = nullptr
     );
 
+    // Renders one face of the cube map per call, then the irradiance, then one mip level of the
+    // prefiltered map. The irradiance is projected onto spherical harmonics instead of being convolved,
+    // which takes a fraction of the time. Can be called inside a frame.
+    // Returns true once the textures are complete, they belong to the caller then
+    bool Step(IncrementalBuild& build);
+
+    // Releases everything an unfinished build has created
+    void Cancel(IncrementalBuild& build) const;
+
+    // Where the environments and the BRDF LUT are baked to, an empty path turns the cache off.
+    // Static, so setting it doesn't construct the manager before the assets are set up
+    static void SetCacheDirectory(const std::filesystem::path& path);
+
 private: // Singleton-related
     PBRManager();
 
     friend class Singleton<PBRManager>;
 
 private:
+    // The matrices must already be set up except the view
+    void RenderFace(
+        const std::unordered_map<uint32_t, LLGL::Resource*>& resources,
+        LLGL::RenderTarget* renderTarget,
+        int face,
+        LLGL::PipelineState* pipeline,
+        const std::function<void(LLGL::CommandBuffer*)>& setUniforms = nullptr
+    );
+
+    // Into the 9x1 texture, from the cube map that is about to become the environment
+    void ProjectSH(LLGL::Texture* cubeMap, LLGL::Sampler* sampler) const;
+
     void RenderCubeMap(
         const std::unordered_map<uint32_t, LLGL::Resource*>& resources,
         LLGL::Texture* cubeMap,
@@ -39,36 +100,70 @@ private:
         LLGL::PipelineState* pipeline
     );
 
+    void RenderEnvironment(
+        const LLGL::Extent2D& resolution,
+        const TextureAssetPtr& environmentMap,
+        LLGL::PipelineState* customConvertPipeline,
+        const std::function<void(LLGL::CommandBuffer*)>& setConvertUniforms
+    );
+
     void RenderBRDF();
 
+    void SetupBRDF();
+
+    // The cube maps must already exist with the resolution the key was built with
+    bool LoadEnvironment(uint64_t key, const LLGL::Extent2D& resolution) const;
+    void StoreEnvironment(uint64_t key, const LLGL::Extent2D& resolution) const;
+
+    // Removes the least recently used files until the cache fits into its size limit
+    static void EvictCache(const std::filesystem::path& keep);
+
+    // All array layers (cube map faces) of a mip level at once
+    static bool ReadMipLevel(std::istream& stream, LLGL::Texture* texture, uint32_t mipLevel);
+    static void WriteMipLevel(std::ostream& stream, LLGL::Texture* texture, uint32_t mipLevel);
+
+    static std::filesystem::path GetCachePath(uint64_t key);
+
     void SetupConvertPipeline();
     void SetupIrradiancePipeline();
     void SetupPrefilteredPipeline();
     void SetupBRDFPipeline();
+    void SetupSHPipelines();
 
     void CreateCubemaps(const LLGL::Extent2D& resolution);
+    void CreateSHTexture();
+
+    static LLGL::Texture* CreateCubeMap(const LLGL::Extent2D& resolution);
     void CreateRenderTargets(const LLGL::Extent2D& resolution, LLGL::Texture* cubeMap, int mipLevel = 0);
 
     void CreateBRDFTexture(const LLGL::Extent2D& resolution);
     void CreateBRDFRenderTarget(const LLGL::Extent2D& resolution);
 
     void ReleaseCubeMaps() const;
-    void ReleaseRenderTargets() const;
+    void ReleaseRenderTargets();
 
 private:
     LLGL::Texture* cubeMap{};
     LLGL::Texture* irradiance{};
     LLGL::Texture* prefiltered{};
     LLGL::Texture* brdf{};
+    LLGL::Texture* shCoefficients{};
 
     LLGL::PipelineState* pipelineConvert{};
     LLGL::PipelineState* pipelineIrradiance{};
     LLGL::PipelineState* pipelinePrefiltered{};
     LLGL::PipelineState* pipelineBRDF{};
+    LLGL::PipelineState* pipelineSHProject{};
+    LLGL::PipelineState* pipelineIrradianceSH{};
 
     LLGL::RenderTarget* brdfRenderTarget{};
+    LLGL::RenderTarget* shRenderTarget{};
+
+    inline static std::filesystem::path cacheDirectory;
+
+    uint64_t shadersKey = 0; // Contents of the convolution shaders, editing them invalidates the cache
 
-    std::array<LLGL::RenderTarget*, 6> renderTargets;
+    std::array<LLGL::RenderTarget*, 6> renderTargets{};
 
     std::array<glm::mat4, 6> views =
     {
@@ -1,5 +1,6 @@
 #pragma once
 #include <AssetManager.hpp>
+#include <EventBus.hpp>
 #include <EventManager.hpp>
 #include <Mesh.hpp>
 #include <Renderer.hpp>
@@ -37,20 +38,33 @@ public:
         bool bindMatrices = false
     );
 
+    // Same as Apply, but only records the pass into a command buffer that is already being written
+    void Record(
+        const std::unordered_map<uint32_t, LLGL::Resource*>& resources,
+        const std::function<void(LLGL::CommandBuffer*)>& setUniforms,
+        LLGL::RenderTarget* renderTarget = nullptr,
+        bool bindMatrices = false
+    );
+
     LLGL::Texture* GetFrame() const;
     LLGL::RenderTarget* GetRenderTarget() const;
 
+private:
+    void OnAssetLoaded(std::span<const AssetLoadedEvent> events);
+
 protected:
     LLGL::TextureDescriptor frameDesc;
 
-    LLGL::Texture* frame;
-    LLGL::RenderTarget* renderTarget;
+    LLGL::Texture* frame{};
+    LLGL::RenderTarget* renderTarget{};
 
     MeshPtr rect;
     LLGL::PipelineLayoutDescriptor layoutDesc;
     VertexShaderAssetPtr vertexShader;
     FragmentShaderAssetPtr fragmentShader;
     LLGL::PipelineState* rectPipeline;
+
+    EventBus::Subscription assetLoadedSubscription;
 };
 
 using PostProcessingPtr = std::shared_ptr<PostProcessing>;
@@ -0,0 +1,108 @@
+#pragma once
+#include <Renderer.hpp>
+#include <Singleton.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace lustra
+{
+
+// Declarative graph of the full-screen passes that run after the geometry pass:
+// - passes declare the textures they read and write, the ones that contribute neither to the output
+//   nor to an imported texture (e.g. a history buffer) are culled
+// - transient textures only live from the first pass that writes them to the last one that reads them,
+//   textures with the same description share the memory when their lifetimes don't overlap
+// - all passes are recorded into one command buffer and submitted once
+// Passes and resources are forgotten after Execute, the transient textures stay in the pool
+// while the next frame keeps asking for them, so resizing needs no special handling
+class RenderGraph final : public Singleton<RenderGraph>
+{
+public:
+    using Handle = uint32_t;
+
+    struct TextureDesc
+    {
+        LLGL::Extent2D resolution;
+        LLGL::Format format = LLGL::Format::RGBA16Float;
+
+        bool mipMaps = false; // Generated after every pass that writes the texture
+
+        bool operator==(const TextureDesc& other) const;
+    };
+
+public:
+    // The render target is only needed if a pass writes the texture.
+    // Texture can be null if it's only written, e.g. the swap chain
+    Handle Import(LLGL::Texture* texture, LLGL::RenderTarget* renderTarget = nullptr);
+    Handle Create(const TextureDesc& desc);
+
+    // Passes run in the order they're added, the resources must be declared before.
+    // execute records the pass with Renderer::RenderPass or PostProcessing::Record
+    void AddPass(std::vector<Handle> reads, std::vector<Handle> writes, std::function<void()> execute);
+
+    void Execute(Handle output);
+
+    // Only valid while the graph is executed
+    LLGL::Texture* GetTexture(Handle handle) const;
+    LLGL::RenderTarget* GetRenderTarget(Handle handle) const;
+
+    size_t GetPoolSize() const;
+
+private: // Singleton-related
+    RenderGraph() = default;
+
+    friend class Singleton<RenderGraph>;
+
+private:
+    struct Resource
+    {
+        TextureDesc desc;
+
+        LLGL::Texture* texture{};
+        LLGL::RenderTarget* renderTarget{};
+
+        bool imported = false;
+
+        // Indices of the first and the last passes that use the resource, culled passes don't count
+        int firstPass = -1, lastPass = -1;
+        int pooled = -1;
+    };
+
+    struct Pass
+    {
+        std::vector<Handle> reads, writes;
+        std::function<void()> execute;
+
+        bool culled = false;
+    };
+
+    struct PooledTexture
+    {
+        TextureDesc desc;
+
+        LLGL::Texture* texture;
+        LLGL::RenderTarget* renderTarget;
+
+        bool busy = false; // Some resource lives in it right now
+        bool used = false; // During this frame
+    };
+
+    void Cull(Handle output);
+    void ComputeLifetimes();
+
+    int Acquire(const TextureDesc& desc);
+
+    // Forgets the passes and the resources, releases the pooled textures the frame didn't use
+    void Reset();
+
+    static PooledTexture CreateTexture(const TextureDesc& desc);
+
+private:
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+
+    std::vector<PooledTexture> pool;
+};
+
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <EventManager.hpp>
 #include <Singleton.hpp>
 #include <Utils.hpp>
 
@@ -7,6 +8,7 @@
 #include <filesystem>
 #include <functional>
 #include <memory>
+#include <type_traits>
 #include <unordered_map>
 
 namespace lustra
@@ -15,7 +17,7 @@ namespace lustra
 template<class T>
 concept LLGLResource = requires { std::is_base_of<T, LLGL::Resource>(); };
 
-class Renderer final : public Singleton<Renderer>
+class Renderer final : public Singleton<Renderer>, public EventListener
 {
 public: // Public methods
     void Init();
@@ -23,7 +25,12 @@ public: // Public methods
     void InitSwapChain(const LLGL::Extent2D& resolution, bool fullscreen = false, int samples = 1);
     void InitSwapChain(const std::shared_ptr<LLGL::Surface>& surface);
 
-    void Begin(); // Start writing to the command buffer
+    // Everything between these two is recorded into one command buffer that is submitted once.
+    // Begin/End/Submit pairs inside the frame only mark where the first render pass clears its target
+    void BeginFrame();
+    void EndFrame();
+
+    void Begin(bool clearFirstPass = true); // Start writing to the command buffer. The first render pass with a pipeline clears its target
     void End() const; // End writing to the command buffer
 
     void RenderPass(
@@ -34,40 +41,90 @@ public: // Public methods
         LLGL::RenderTarget* renderTarget = nullptr
     );
 
+    // Splits [0, count) into chunks that are recorded with Multithreading::ParallelFor, each into its own
+    // secondary command buffer, which are then executed in order on the primary one. Inside record, RenderPass
+    // writes to the chunk's command buffer and GetMatrices returns a copy of the matrices,
+    // so record must not touch anything else that is shared. Must be called between Begin and End
+    void RecordParallel(size_t count, const std::function<void(size_t begin, size_t end)>& record, size_t minChunkSize = 16);
+
     void Submit() const;
     void Present() const;
 
     void ClearRenderTarget(LLGL::RenderTarget* renderTarget = nullptr, bool begin = true);
 
-    void GenerateMips(LLGL::Texture* texture);
+    void GenerateMips(LLGL::Texture* texture, bool begin = true);
 
     template<LLGLResource T>
-    void Release(T* resource) { renderSystem->Release(*resource); }
+    void Release(T* resource)
+    {
+        if constexpr(std::is_same_v<T, LLGL::Shader>)
+        {
+            ReleaseShaderVariants(resource);
+
+            shaderHashes.erase(resource);
+            shaderSources.erase(resource);
+        }
+
+        renderSystem->Release(*resource);
+    }
 
     void Unload();
 
+    void OnEvent(Event& event) override;
+
     void WriteTexture(LLGL::Texture& texture, const LLGL::TextureRegion& textureRegion, const LLGL::ImageView& srcImageView) const;
+    void ReadTexture(LLGL::Texture& texture, const LLGL::TextureRegion& textureRegion, const LLGL::MutableImageView& dstImageView) const; // Stalls until the GPU is done with the texture
+    void WriteBuffer(LLGL::Buffer& buffer, uint64_t offset, const void* data, uint64_t size) const; // Not limited to 64KB unlike CommandBuffer::UpdateBuffer
 
     void SetViewportResolution(const LLGL::Extent2D& resolution);
 
+    // Doesn't touch the render system, so it can be called from any thread
+    static std::string ReadShaderSource(const std::filesystem::path& path);
+
+    // Linked programs are stored there and loaded on the next launch instead of being linked again,
+    // an empty path turns it off
+    void SetPipelineCacheDirectory(const std::filesystem::path& path);
+
     void PrintRendererInfo() const;
 
     LLGL::Extent2D GetViewportResolution() const;
 
     LLGL::Buffer* CreateBuffer(const LLGL::BufferDescriptor& bufferDesc, const void* initialData = nullptr) const;
     LLGL::Buffer* CreateBuffer(const std::string& name, const LLGL::BufferDescriptor& bufferDesc, const void* initialData = nullptr);
-    LLGL::Shader* CreateShader(const LLGL::ShaderType& type, const std::filesystem::path& path, const std::vector<LLGL::VertexAttribute>& attributes = {}) const;
+    LLGL::Shader* CreateShader(const LLGL::ShaderType& type, const std::filesystem::path& path, const std::vector<LLGL::VertexAttribute>& attributes = {});
+    // The name is only used in the log and as a part of the pipeline cache key
+    LLGL::Shader* CreateShaderFromSource(const LLGL::ShaderType& type, const std::string& source, const std::string& name, const std::vector<LLGL::VertexAttribute>& attributes = {});
+
+    // The shader compiled again with "#define <keyword>" for every keyword, e.g. "ALBEDO_TEXTURE" or "DIFFUSE_METHOD 2".
+    // Variants are compiled on the first request and cached by the source and the keywords.
+    // Returns the shader itself if it doesn't mention any of the keywords or wasn't created by the Renderer,
+    // a required keyword logs a warning then, once per shader.
+    // attributes replace the vertex attributes of the shader if a keyword adds inputs, e.g. "SKINNED".
+    // The variants are released with their shader
+    LLGL::Shader* GetShaderVariant(
+        LLGL::Shader* shader,
+        const std::vector<std::string>& keywords,
+        const std::vector<LLGL::VertexAttribute>& attributes = {},
+        bool required = false
+    );
+
+    // Of the source and the vertex attributes, the same between launches. 0 for shaders not created by the Renderer
+    uint64_t GetShaderHash(const LLGL::Shader* shader) const;
     LLGL::Texture* CreateTexture(const LLGL::TextureDescriptor& textureDesc, const LLGL::ImageView* initialImage = nullptr) const;
     LLGL::Sampler* CreateSampler(const LLGL::SamplerDescriptor& samplerDesc) const;
     LLGL::RenderTarget* CreateRenderTarget(const LLGL::Extent2D& resolution, const std::vector<LLGL::AttachmentDescriptor>& colorAttachments, LLGL::Texture* depthTexture = nullptr) const;
 
+    // Pipelines are cached by the contents of their descriptors and shaders, layouts are shared between them.
+    // The returned pipeline may be used elsewhere, so it must not be released
     LLGL::PipelineState* CreatePipelineState(LLGL::Shader* vertexShader, LLGL::Shader* fragmentShader);
-    LLGL::PipelineState* CreatePipelineState(const LLGL::PipelineLayoutDescriptor& layoutDesc, LLGL::GraphicsPipelineDescriptor pipelineDesc) const;
+    LLGL::PipelineState* CreatePipelineState(const LLGL::PipelineLayoutDescriptor& layoutDesc, LLGL::GraphicsPipelineDescriptor pipelineDesc);
     LLGL::PipelineState* CreateRenderTargetPipeline(const LLGL::RenderTarget* renderTarget) const;
 
     LLGL::SwapChain* GetSwapChain() const;
     LLGL::Window* GetWindow() const;
     LLGL::VertexFormat GetDefaultVertexFormat() const;
+    // The default one followed by 4 joint indices and 4 weights, see Mesh::SetSkin
+    LLGL::VertexFormat GetSkinnedVertexFormat() const;
 
     LLGL::Buffer* GetMatricesBuffer() const;
     std::shared_ptr<Matrices> GetMatrices() const;
@@ -88,9 +145,41 @@ private: // Private methods
 
     void SetupBuffers();
 
+    LLGL::CommandBuffer* GetSecondaryCommandBuffer(size_t index);
+
+    void ReleaseShaderVariants(const LLGL::Shader* shader);
+
+    LLGL::PipelineState* LoadPipelineState(const LLGL::GraphicsPipelineDescriptor& pipelineDesc, uint64_t key) const;
+
+    static uint64_t HashShader(const LLGL::ShaderDescriptor& shaderDesc, const std::string& name, const std::string& source);
+    static uint64_t HashPipelineLayout(const LLGL::PipelineLayoutDescriptor& layoutDesc);
+    // persistent is set to false if the key can't be reproduced on the next launch
+    uint64_t HashPipelineState(const LLGL::GraphicsPipelineDescriptor& pipelineDesc, uint64_t layoutKey, bool& persistent) const;
+
 private: // Private members
+    struct ShaderSource
+    {
+        LLGL::ShaderType type;
+
+        std::string name, source;
+        std::vector<LLGL::VertexAttribute> attributes;
+    };
+
+    // State of a RecordParallel worker thread
+    struct Worker
+    {
+        LLGL::CommandBuffer* commandBuffer;
+        std::shared_ptr<Matrices> matrices;
+
+        uint64_t renderPassCounter;
+    };
+
+    static thread_local Worker* worker;
+
     uint64_t renderPassCounter = 0;
 
+    bool frameStarted = false;
+
     LLGL::Extent2D viewportResolution;
 
     LLGL::RenderSystemPtr renderSystem;
@@ -99,13 +188,22 @@ private: // Private members
     LLGL::CommandBuffer* commandBuffer{};
     LLGL::CommandQueue* commandQueue{};
 
-    LLGL::VertexFormat defaultVertexFormat;
+    std::vector<LLGL::CommandBuffer*> secondaryCommandBuffers;
+
+    LLGL::VertexFormat defaultVertexFormat, skinnedVertexFormat;
 
     LLGL::Buffer* matricesBuffer{};
     std::shared_ptr<Matrices> matrices;
 
     std::unordered_map<std::string, LLGL::Buffer*> globalBuffers;
     std::unordered_map<uint64_t, LLGL::PipelineState*> pipelineCache;
+    std::unordered_map<uint64_t, LLGL::PipelineLayout*> pipelineLayoutCache;
+    std::unordered_map<const LLGL::Shader*, uint64_t> shaderHashes; // Contents of the shaders created with CreateShader
+    std::unordered_map<const LLGL::Shader*, ShaderSource> shaderSources; // To compile their variants
+    std::unordered_map<uint64_t, LLGL::Shader*> shaderVariants; // The shader itself if it doesn't mention the keywords
+    std::unordered_map<const LLGL::Shader*, std::vector<uint64_t>> shaderVariantKeys; // Of every shader that has variants
+
+    std::filesystem::path pipelineCacheDirectory;
 };
 
 }
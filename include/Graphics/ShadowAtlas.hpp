@@ -0,0 +1,124 @@
+#pragma once
+#include <Config.hpp>
+#include <Renderer.hpp>
+#include <Singleton.hpp>
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace lustra
+{
+
+// All shadow maps are tiles of one depth texture:
+// - tiles are power-of-two squares, allocated from a quadtree so they can be split and merged back
+// - a light keeps its tile between frames as long as its size doesn't change,
+//   the tile is only re-rendered when it's marked dirty
+// - when the atlas is full, the least important lights are left without a shadow
+class ShadowAtlas final : public Singleton<ShadowAtlas>
+{
+public:
+    struct Shadow
+    {
+        glm::mat4 lightSpaceMatrix;
+        glm::vec4 atlasRect; // xy - offset, zw - scale, in texture coordinates
+
+        alignas(16) float bias;
+
+        float splitDepth; // View space depth the shadow reaches, only used by cascades
+        int cascadeCount; // Set on the first cascade of the light, 1 if there are no cascades
+    };
+
+    struct Request
+    {
+        uint32_t key; // Anything that identifies the light between frames
+        uint32_t size;
+
+        float importance;
+    };
+
+    struct Tile
+    {
+        uint32_t x, y, size;
+        uint32_t requestedSize; // Bigger than size if the atlas was too full for it
+
+        glm::mat4 lightSpaceMatrix; // The one it was rendered with
+
+        bool dirty = true;
+    };
+
+public:
+    void SetConfig(const ShadowAtlasConfig& config);
+
+    // Assigns tiles to the most important requests and frees the tiles of the lights that weren't requested.
+    // A light that already has a tile keeps it unless it asks for a bigger one, or shrinks by more than twice.
+    // A light that got a smaller tile than it asked for moves to a bigger one once there's room
+    void Allocate(std::span<Request> requests);
+
+    // Marks every tile as dirty
+    void Invalidate();
+
+    // The tiles are only valid for the scene that rendered them, switching to another one invalidates them
+    void SetOwner(const void* owner);
+
+    // Writes the shadows into the storage buffer, it has room for config.maxShadows entries
+    void Upload(std::span<const Shadow> shadows);
+
+    Tile* GetTile(uint32_t key);
+    glm::vec4 GetRect(const Tile& tile) const;
+
+    // Restricts the viewport and the scissor to the tile, call after the pipeline is set
+    static void SetTileViewport(LLGL::CommandBuffer* commandBuffer, const Tile& tile);
+
+    const ShadowAtlasConfig& GetConfig() const;
+
+    LLGL::Texture* GetTexture();
+    LLGL::RenderTarget* GetRenderTarget();
+    LLGL::PipelineState* GetPipeline();
+    // depth.vert with "SKINNED", AnimationManager::GetPaletteBuffer() is resource 1 and uniform 0 is the palette offset
+    LLGL::PipelineState* GetSkinnedPipeline();
+    LLGL::Buffer* GetShadowBuffer();
+
+private: // Singleton-related
+    ShadowAtlas() = default;
+
+    friend class Singleton<ShadowAtlas>;
+
+private:
+    struct Node
+    {
+        uint32_t x, y;
+    };
+
+    void Create();
+    LLGL::PipelineState* CreatePipeline(bool skinned) const;
+
+    void Reset();
+
+    bool AllocateNode(uint32_t size, Node& node);
+    void FreeNode(Node node, uint32_t size);
+
+    uint32_t GetLevel(uint32_t size) const;
+
+private:
+    ShadowAtlasConfig config;
+
+    const void* owner{};
+
+    // Free nodes of every level, level 0 is the whole atlas
+    std::vector<std::vector<Node>> freeNodes;
+
+    std::unordered_map<uint32_t, Tile> tiles;
+    std::vector<uint32_t> requested; // Reused every frame
+
+    LLGL::Texture* texture{};
+    LLGL::RenderTarget* renderTarget{};
+    LLGL::PipelineState* pipeline{};
+    LLGL::PipelineState* skinnedPipeline{};
+
+    LLGL::Buffer* shadowBuffer{};
+};
+
+static_assert(sizeof(ShadowAtlas::Shadow) == 96, "ShadowAtlas::Shadow must match the std430 layout of the shader");
+
+}
@@ -105,6 +105,9 @@ inline void DrawComponentUI(MeshRendererComponent& component, entt::entity entit
 
     if(ImGui::Button("Add Material"))
         component.materials.push_back(component.materials.back());
+
+    ImGui::DragFloat("LOD Threshold", &component.lodThreshold, 0.05f, 0.0f, 32.0f);
+    ImGui::DragFloat("Shadow LOD Bias", &component.shadowLodBias, 0.05f, 1.0f, 16.0f);
 }
 
 inline void DrawComponentUI(PipelineComponent& component, entt::entity entity)
@@ -156,17 +159,16 @@ inline void DrawComponentUI(LightComponent& component, entt::entity entity)
     ImGui::DragFloat("Intensity", &component.intensity, 0.05f, 0.0f, 100.0f);
     ImGui::DragFloat("Cutoff", &component.cutoff, 0.05f, 0.0f, 360.0f);
     ImGui::DragFloat("Outer Cutoff", &component.outerCutoff, 0.05f, 0.0f, 360.0f);
+    ImGui::DragFloat("Range", &component.range, 0.05f, 0.0f, 1000.0f);
 
-    if(ImGui::Checkbox("Shadow map", &component.shadowMap))
-        if(!component.renderTarget)
-            component.SetupShadowMap(component.resolution);
+    ImGui::Checkbox("Shadow map", &component.shadowMap);
 
     ImGui::Checkbox("Orthographic", &component.orthographic);
     ImGui::DragFloat("Ortho Extent", &component.orthoExtent, 0.05f, 0.0f, 200.0f);
 
     static constexpr uint32_t min = 128, max = 8192;
 
-    ImGui::DragScalarN("Resolution", ImGuiDataType_U32, &component.resolution.width, 2, 1.0f, &min, &max);
+    ImGui::DragScalarN("Max Resolution", ImGuiDataType_U32, &component.resolution.width, 2, 1.0f, &min, &max);
     ImGui::DragFloat("Bias", &component.bias, 0.0001f, 0.0f, 1.0f);
 
     if(ImGui::Button("Setup Shadow Map"))
@@ -309,7 +311,15 @@ inline void DrawComponentUI(BloomComponent& component, entt::entity entity)
 {
     ImGui::DragFloat("Threshold", &component.threshold, 0.01f, 0.0f, 10.0f);
     ImGui::DragFloat("Strength", &component.strength, 0.01f, 0.0f, 10.0f);
-    ImGui::DragFloat("Resolution Scale##Bloom", &component.resolutionScale, 0.1f, 1.0f, 10.0f);
+    ImGui::Checkbox("Mip Chain", &component.mipChain);
+
+    if(component.mipChain)
+    {
+        ImGui::DragInt("Mip Count", &component.mipCount, 1, 1, 12);
+        ImGui::DragFloat("Filter Radius", &component.filterRadius, 0.01f, 0.0f, 4.0f);
+    }
+    else
+        ImGui::DragFloat("Resolution Scale##Bloom", &component.resolutionScale, 0.1f, 1.0f, 10.0f);
 
     ImGui::Separator();
 
@@ -328,6 +338,11 @@ inline void DrawComponentUI(GTAOComponent& component, entt::entity entity)
     ImGui::DragFloat("Thickness Mix", &component.thicknessMix, 0.01f, 0.0f, 1.0f);
     ImGui::DragFloat("Max Stride", &component.maxStride, 0.1f, 0.0f, 100.0f);
 
+    ImGui::Checkbox("Temporal", &component.temporal);
+
+    if(component.temporal)
+        ImGui::DragFloat("History Weight", &component.historyWeight, 0.01f, 0.0f, 0.99f);
+
     ImGui::Separator();
 
     if(ImGui::Button("Update##GTAO"))
@@ -338,8 +353,24 @@ inline void DrawComponentUI(SSRComponent& component, entt::entity entity)
 {
     ImGui::DragFloat("Resolution Scale##SSR", &component.resolutionScale, 0.1f, 1.0f, 10.0f);
     ImGui::DragInt("Max Steps", &component.maxSteps, 1, 1, 10000);
-    ImGui::DragInt("Max Binary Search Steps", &component.maxBinarySearchSteps, 1, 0, 1000);
-    ImGui::DragFloat("Ray Step", &component.rayStep, 0.001f, 0.0f, 1.0f);
+
+    ImGui::Checkbox("Hi-Z", &component.hiZ);
+
+    if(component.hiZ)
+    {
+        ImGui::DragFloat("Max Distance", &component.maxDistance, 0.1f, 0.0f, 1000.0f);
+        ImGui::DragFloat("Thickness", &component.thickness, 0.01f, 0.0f, 100.0f);
+    }
+    else
+    {
+        ImGui::DragInt("Max Binary Search Steps", &component.maxBinarySearchSteps, 1, 0, 1000);
+        ImGui::DragFloat("Ray Step", &component.rayStep, 0.001f, 0.0f, 1.0f);
+    }
+
+    ImGui::Checkbox("Temporal##SSR", &component.temporal);
+
+    if(component.temporal)
+        ImGui::DragFloat("History Weight##SSR", &component.historyWeight, 0.01f, 0.0f, 0.99f);
 
     ImGui::Separator();
 
@@ -352,6 +383,7 @@ inline void DrawComponentUI(ProceduralSkyComponent& component, entt::entity enti
     ImGui::DragFloat("Time", &component.time, 0.1f, 0.0f, 1000.0f);
     ImGui::DragFloat("Cirrus", &component.cirrus, 0.001f, 0.0f, 1.0f);
     ImGui::DragFloat("Cumulus", &component.cumulus, 0.001f, 0.0f, 1.0f);
+    ImGui::Checkbox("Time-sliced", &component.timeSliced);
 
     static constexpr uint32_t min = 128, max = 8192;
 
@@ -703,6 +735,26 @@ inline void DrawComponentUI(SoundComponent& component, entt::entity entity)
     }
 }
 
+inline void DrawComponentUI(AnimatorComponent& component, entt::entity entity)
+{
+    static float fadeDuration = 0.2f;
+
+    int animation = component.animation;
+
+    if(ImGui::InputInt("Animation", &animation))
+        component.Play(std::max(animation, 0), fadeDuration);
+
+    ImGui::DragFloat("Fade Duration", &fadeDuration, 0.01f, 0.0f, 5.0f);
+
+    ImGui::DragFloat("Time", &component.time, 0.01f, 0.0f, 1000.0f);
+    ImGui::DragFloat("Speed", &component.speed, 0.01f, -10.0f, 10.0f);
+
+    ImGui::Checkbox("Loop", &component.loop);
+    ImGui::Checkbox("Playing", &component.playing);
+
+    ImGui::Text("Joints: %zu", component.palette.size());
+}
+
 // Jesus Christ what is that
 template<class T>
 struct HasComponentUI
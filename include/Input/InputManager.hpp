@@ -3,26 +3,124 @@
 #include <Keyboard.hpp>
 #include <Mouse.hpp>
 
+#include <array>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace lustra
 {
 
+struct InputEvent
+{
+    enum class Device : uint8_t
+    {
+        Keyboard,
+        Mouse
+    };
+
+    enum class Action : uint8_t
+    {
+        Released = GLFW_RELEASE,
+        Pressed = GLFW_PRESS,
+        Repeated = GLFW_REPEAT
+    };
+
+    Device device;
+    Action action;
+
+    int code; // Keyboard::Key or Mouse::Button
+
+    double time; // glfwGetTime()
+};
+
+// Key and button states are fed by GLFW callbacks, actions are interned
+// into sequential ids so a query is a single array lookup. String
+// overloads are kept for convenience and resolve the id on every call
 class InputManager final : public Singleton<InputManager>
 {
 public:
+    using ActionId = uint32_t;
+
+    static constexpr ActionId invalidAction = ~0u;
+    static constexpr size_t eventBufferSize = 256;
+
+public:
+    // Latches the edges that happened since the last call, once per frame
     void Update();
 
+    // Returns the existing id if the action is already registered
+    ActionId RegisterAction(const std::string& action);
+    ActionId GetActionId(const std::string& action) const;
+
+    void MapAction(ActionId action, Keyboard::Key key);
+    void MapAction(ActionId action, Mouse::Button button);
     void MapAction(const std::string& action, Keyboard::Key key);
     void MapAction(const std::string& action, Mouse::Button button);
 
-    bool IsActionPressed(const std::string& action);
+    bool IsActionPressed(ActionId action) const;
+    bool IsActionJustPressed(ActionId action) const;
+    bool IsActionJustReleased(ActionId action) const;
+
+    bool IsActionPressed(const std::string& action) const;
+    bool IsActionJustPressed(const std::string& action) const;
+    bool IsActionJustReleased(const std::string& action) const;
+
+    bool IsKeyDown(Keyboard::Key key) const;
+    bool IsButtonDown(Mouse::Button button) const;
+
+    // Visits every event recorded since the cursor and advances it.
+    // If the consumer fell behind by more than eventBufferSize, the oldest events are skipped
+    template<class Function>
+    void ReadEvents(uint64_t& cursor, Function&& function) const
+    {
+        if(eventsWritten - cursor > eventBufferSize)
+            cursor = eventsWritten - eventBufferSize;
+
+        for(; cursor < eventsWritten; cursor++)
+            function(events[cursor % eventBufferSize]);
+    }
+
+    uint64_t GetEventCursor() const;
+
+public:
+    // Called from the GLFW callbacks
+    void OnKey(int key, int action);
+    void OnButton(int button, int action);
 
 private:
-    std::unordered_map<std::string, std::vector<Keyboard::Key>> keyboardMapping;
-    std::unordered_map<std::string, std::vector<Mouse::Button>> mouseMapping;
+    struct ActionState
+    {
+        uint16_t held = 0; // Number of bound inputs that are down
+
+        bool pressed = false;
+        bool justPressed = false;
+        bool justReleased = false;
+
+        // Set by callbacks, moved into justPressed/justReleased on Update()
+        bool pressedLatch = false;
+        bool releasedLatch = false;
+    };
+
+    static constexpr size_t keyCount = static_cast<size_t>(Keyboard::Key::Last) + 1;
+    static constexpr size_t buttonCount = static_cast<size_t>(Mouse::Button::Last) + 1;
+
+    void OnInput(const std::vector<ActionId>& actions, bool down);
+    void PushEvent(InputEvent::Device device, int code, int action);
+
+private:
+    std::unordered_map<std::string, ActionId> actionIds;
+
+    std::vector<ActionState> actionStates;
+
+    std::array<std::vector<ActionId>, keyCount> keyActions;
+    std::array<std::vector<ActionId>, buttonCount> buttonActions;
+
+    std::array<bool, keyCount> keyStates{};
+    std::array<bool, buttonCount> buttonStates{};
 
-    std::unordered_map<std::string, bool> actionStates;
+    std::array<InputEvent, eventBufferSize> events{};
+    uint64_t eventsWritten = 0;
 };
 
 }
@@ -130,6 +130,8 @@ enum class Key
     Last = GLFW_KEY_LAST
 };
 
+void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
 bool IsKeyPressed(Key key);
 bool IsKeyReleased(Key key);
 bool IsKeyRepeated(Key key);
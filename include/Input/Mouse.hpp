@@ -26,6 +26,7 @@ enum class Button
 };
 
 void ScrollCallback(GLFWwindow* window, double x, double y);
+void ButtonCallback(GLFWwindow* window, int button, int action, int mods);
 
 void SetCursorVisible(bool visible = true);
 
@@ -1,18 +1,33 @@
 #pragma once
 #include <JoltInclude.hpp>
-#include <EventManager.hpp>
-#include <Multithreading.hpp>
+#include <Event.hpp>
 
 #include <glm/vec3.hpp>
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
 namespace lustra
 {
 
 class CollisionEvent final : public Event
 {
 public:
-    CollisionEvent(JPH::Body* body1, JPH::Body* body2, const JPH::ContactManifold& manifold)
-        : Event(Type::Collision), body1(body1), body2(body2)
+    enum class State
+    {
+        Added,
+        Persisted,
+        Removed
+    };
+
+public:
+    // Called on a physics thread, copies only what's needed from the manifold
+    CollisionEvent(const JPH::Body& body1, const JPH::Body& body2, const JPH::ContactManifold& manifold, const State state)
+        : Event(Type::Collision), state(state), bodyId1(body1.GetID()), bodyId2(body2.GetID())
     {
         JPH::RVec3 point1, point2;
 
@@ -31,9 +46,19 @@ public:
         penetrationDepth = manifold.mPenetrationDepth;
     }
 
+    // Jolt doesn't provide a manifold for removed contacts
+    CollisionEvent(const JPH::BodyID& bodyId1, const JPH::BodyID& bodyId2)
+        : Event(Type::Collision), state(State::Removed), bodyId1(bodyId1), bodyId2(bodyId2) {}
+
+    State GetState() const { return state; }
+
+    // Can be null if the body was destroyed before the event was delivered
     JPH::Body* GetBody1() const { return body1; }
     JPH::Body* GetBody2() const { return body2; }
 
+    const JPH::BodyID& GetBodyID1() const { return bodyId1; }
+    const JPH::BodyID& GetBodyID2() const { return bodyId2; }
+
     glm::vec3 GetContactPosition1() const { return contactWorldPosition1; }
     glm::vec3 GetContactPosition2() const { return contactWorldPosition2; }
 
@@ -42,63 +67,96 @@ public:
     float GetPenetration() const { return penetrationDepth; }
 
 private:
-    JPH::Body* body1;
-    JPH::Body* body2;
+    State state;
+
+    JPH::BodyID bodyId1;
+    JPH::BodyID bodyId2;
+
+    JPH::Body* body1{};
+    JPH::Body* body2{};
+
+    glm::vec3 contactWorldPosition1{};
+    glm::vec3 contactWorldPosition2{};
 
-    glm::vec3 contactWorldPosition1;
-    glm::vec3 contactWorldPosition2;
+    glm::vec3 worldNormal{};
 
-    glm::vec3 worldNormal;
+    float penetrationDepth{};
 
-    float penetrationDepth;
+private:
+    friend class CollisionListener;
 };
 
+// Contact callbacks are invoked on Jolt's worker threads, so every thread
+// appends to its own buffer without any locking. The buffers are collected
+// on the main thread once per physics step and published as a single batch
+// of CollisionEvent through the EventBus, grouped by state
 class CollisionListener final : public JPH::ContactListener
 {
 public:
-    virtual JPH::ValidateResult OnContactValidate(
+    CollisionListener();
+
+    JPH::ValidateResult OnContactValidate(
         const JPH::Body& body1,
         const JPH::Body& body2,
         JPH::RVec3Arg baseOffset,
         const JPH::CollideShapeResult& result
-    ) override
-    {
-        return JPH::ValidateResult::AcceptAllContactsForThisBodyPair;
-    }
+    ) override;
 
-    virtual void OnContactAdded(
+    void OnContactAdded(
         const JPH::Body& body1,
         const JPH::Body& body2,
         const JPH::ContactManifold& manifold,
         JPH::ContactSettings& settings
-    ) override
-    {
-        ProcessCollision(body1, body2, manifold);
-    }
+    ) override;
 
-private:
-    static void ProcessCollision(
+    void OnContactPersisted(
         const JPH::Body& body1,
         const JPH::Body& body2,
-        const JPH::ContactManifold& manifold
-    )
-    {
-        Multithreading::Get().AddJob(
-            {
-                nullptr,
-                [&]() {
-                    EventManager::Get().Dispatch(
-                        std::make_unique<CollisionEvent>(
-                            const_cast<JPH::Body*>(&body1),
-                            const_cast<JPH::Body*>(&body2),
-                            manifold
-                        )
-                    );
-                }
-            }
-        );
-    }
+        const JPH::ContactManifold& manifold,
+        JPH::ContactSettings& settings
+    ) override;
 
-};
+    void OnContactRemoved(const JPH::SubShapeIDPair& subShapePair) override;
+
+    // Main thread only, after the physics step has finished
+    void Flush(const JPH::BodyLockInterface& bodyLockInterface);
+
+    // Filters must not be changed while the physics system is updating
+    // Bit N of the mask enables contacts that involve a body in object layer N, layers from 32 on are never reported
+    void SetLayerMask(uint32_t mask);
+    // Persisted contacts are reported every step for as long as bodies touch, so they're opt-in
+    void SetReportPersisted(bool report);
+
+    // If any body is watched, only contacts that involve a watched body are reported
+    void WatchBody(const JPH::BodyID& bodyId);
+    void UnwatchBody(const JPH::BodyID& bodyId);
+    void ClearWatchedBodies();
+
+    uint32_t GetLayerMask() const;
+    bool IsReportingPersisted() const;
+
+private:
+    using Buffer = std::array<std::vector<CollisionEvent>, 3>;
 
+    Buffer& GetThreadBuffer();
+
+    bool Accept(const JPH::Body& body1, const JPH::Body& body2) const;
+    bool IsWatched(const JPH::BodyID& bodyId1, const JPH::BodyID& bodyId2) const;
+
+private:
+    uint32_t layerMask = ~0u;
+    bool reportPersisted = false;
+
+    std::unordered_set<uint32_t> watchedBodies;
+
+private:
+    // Distinguishes listener instances in the thread-local cache
+    uint64_t generation;
+
+    std::mutex buffersMutex; // Only taken when a thread reports its first contact
+    std::vector<std::unique_ptr<Buffer>> buffers;
+
+    std::vector<CollisionEvent> batch;
 };
+
+}
@@ -24,6 +24,8 @@ public:
     JPH::PhysicsSystem& GetPhysicsSystem() const;
     JPH::BodyInterface& GetBodyInterface() const;
 
+    CollisionListener& GetCollisionListener() const;
+
 private:
     PhysicsManager();
 
@@ -2,11 +2,18 @@
 #include <AssetManager.hpp>
 #include <Components.hpp>
 #include <DeferredRenderer.hpp>
+#include <HiZBuffer.hpp>
 #include <InputManager.hpp>
+#include <LightClusters.hpp>
+#include <RenderGraph.hpp>
 #include <Renderer.hpp>
+#include <ShadowAtlas.hpp>
 
 #include <entt/entt.hpp>
 
+#include <array>
+#include <map>
+
 namespace lustra
 {
 
@@ -48,35 +55,60 @@ public:
     entt::registry& GetRegistry();
 
 private:
+    void OnAssetLoaded(std::span<const AssetLoadedEvent> events);
+    void OnCollision(std::span<const CollisionEvent> events);
+
     void StartScript(const ScriptComponent& script, const Entity& entity);
     static void UpdateScript(const ScriptComponent& script, Entity entity, float deltaTime);
 
-    void SetupLightsBuffer();
-    void SetupShadowsBuffer();
     void UpdateLightsBuffer();
     void UpdateShadowsBuffer();
 
     void UpdateRigidBodies();
     void UpdateSounds();
+    void UpdateSkies();
 
     void SetupCamera();
     void SetupLights();
     void SetupShadows();
+    void SetupCascades(size_t lightIndex, const LightComponent& light);
+    void UpdateShadowCasters();
+    void UpdateStaticBatches();
+    void UpdateAnimations();
 
     void RenderMeshes();
     void RenderToShadowMap();
     void RenderSky(LLGL::RenderTarget* renderTarget);
 
+    // animator is null for the meshes without one, skinned meshes are drawn in the bind pose then
     static void MeshRenderPass(
         const MeshComponent& mesh,
         const MeshRendererComponent& meshRenderer,
         const PipelineComponent& pipeline,
+        const AnimatorComponent* animator,
+        LLGL::RenderTarget* renderTarget
+    );
+    static void SubmeshRenderPass(
+        const Mesh& mesh,
+        size_t lod,
+        const MaterialAssetPtr& material,
+        const PipelineComponent& pipeline,
+        const AnimatorComponent* animator,
         LLGL::RenderTarget* renderTarget
     );
+    // The material of a submesh, the default one if the renderer has fewer materials than the model has meshes
+    static MaterialAssetPtr GetMaterial(const MeshRendererComponent& meshRenderer, size_t index);
+
     static void ShadowRenderPass(
-        const LightComponent& light,
-        const MeshComponent& mesh
+        const ModelAsset& model,
+        const std::vector<uint32_t>& lods,
+        const AnimatorComponent* animator,
+        const ShadowAtlas::Tile& tile
     );
+
+    // Whether the palette of the animator was uploaded this frame and can be used to draw the mesh,
+    // see PipelineComponent::skinnedVariant
+    static bool IsSkinned(const Mesh& mesh, const AnimatorComponent* animator);
     static void ProceduralSkyRenderPass(
         const MeshComponent& mesh,
         const ProceduralSkyComponent& sky,
@@ -88,13 +120,27 @@ private:
         LLGL::RenderTarget* renderTarget
     );
 
-    void RenderResult(LLGL::RenderTarget* renderTarget = Renderer::Get().GetSwapChain());
+    // Only records the passes, the command buffer must be already started
+    void RenderResult(LLGL::RenderTarget* renderTarget, LLGL::Texture* occlusion);
 
+    // Builds the render graph of the frame: GTAO -> lighting -> SSR -> bloom -> tonemapping
     void ApplyPostProcessing(LLGL::RenderTarget* renderTarget);
 
-    std::pair<LLGL::Texture*, float> ApplyBloom(LLGL::Texture* frame);
-    LLGL::Texture* ApplyGTAO();
-    LLGL::Texture* ApplySSR(LLGL::Texture* frame);
+    // Each of them adds its passes to the render graph and returns the handle of the result
+    std::pair<RenderGraph::Handle, float> AddBloomPasses(RenderGraph::Handle frame);
+    static RenderGraph::Handle AddBloomMipChainPasses(const BloomComponent& bloom, RenderGraph::Handle threshold);
+    RenderGraph::Handle AddGTAOPasses();
+    RenderGraph::Handle AddSSRPasses(RenderGraph::Handle frame);
+
+    static uint32_t GetShadowKey(entt::entity entity, uint32_t cascade);
+
+    static Mesh::Bounds GetWorldBounds(const ModelAsset& model, const glm::mat4& transform);
+    // The bind pose doesn't bound the animations, so the bounds are grown by animatedBoundsPadding
+    static Mesh::Bounds GetAnimatedBounds(const ModelAsset& model, const glm::mat4& transform);
+    static bool IsInFrustum(const Mesh::Bounds& bounds, const glm::mat4& viewProjection);
+
+    // The coarsest LOD whose error projected on the screen stays under threshold pixels, current is the last pick
+    uint32_t SelectLod(const Mesh& mesh, const glm::mat4& worldTransform, float threshold, uint32_t current) const;
 
 private:
     bool isRunning = false;
@@ -105,34 +151,146 @@ private:
 
     glm::vec3 cameraPosition{}; // Only for shaders
 
+    // Going to a coarser LOD needs the error this much under the threshold, so the ones at the boundary don't flicker
+    static constexpr float lodHysteresis = 0.25f;
+
+private:
+    std::vector<LightClusters::Light> lights;
+    std::vector<entt::entity> lightEntities; // Same order as lights
+
+    std::vector<ShadowAtlas::Shadow> shadows;
+
 private:
-    struct Light
+    // Directional lights split the camera frustum into cascades, each of them gets its own tile
+    static constexpr uint32_t cascadeCount = 4;
+    static constexpr float cascadeSplitLambda = 0.75f; // 0 - uniform splits, 1 - logarithmic
+    static constexpr float maxShadowDistance = 200.0f;
+    static constexpr float casterExtrusion = 200.0f; // Casters between the light and the cascade
+
+    struct ShadowLight
     {
-        // Uniform buffer padding //
-        // | //
-        // V //
-        alignas(16) int shadowMap;
-        alignas(16) glm::vec3 position;
-        alignas(16) glm::vec3 direction;
-        alignas(16) glm::vec3 color;
-
-        float intensity, cutoff, outerCutoff;
+        entt::entity entity;
+        size_t lightIndex;
+
+        uint32_t key;
+        int cascade = -1;
+        int shadow = -1; // Index in shadows, -1 if it didn't get a tile
+
+        glm::mat4 view, projection;
+        glm::mat4 lightSpaceMatrix;
+
+        // Bounding sphere of the cascade's part of the camera frustum
+        glm::vec3 center{};
+        float radius = 0.0f;
+
+        float splitDepth;
+        float bias;
     };
 
-    struct Shadow
+    static void FitCascade(ShadowLight& shadowLight, const glm::vec3& direction, uint32_t tileSize);
+
+    struct ShadowCaster
     {
-        glm::mat4 lightSpaceMatrix;
+        glm::mat4 worldTransform;
+        Mesh::Bounds bounds; // World space
+
+        const ModelAsset* model;
+
+        std::vector<uint32_t> lods; // Per submesh, picked with the shadow bias of the mesh renderer
+
+        const AnimatorComponent* animator; // Null if there's none
+
+        uint64_t frame; // Last frame it was seen
+    };
+
+    std::vector<ShadowLight> shadowLights;
+    std::vector<ShadowAtlas::Request> shadowRequests;
+
+    std::unordered_map<entt::entity, ShadowCaster> shadowCasters;
+    std::vector<Mesh::Bounds> changedCasterBounds; // Old and new bounds of the casters that moved, appeared or disappeared
+
+    uint64_t shadowFrame = 0;
+
+private:
+    // Static geometry (no rigid body, no script) is merged into world space meshes, one per shader pair,
+    // material and grid cell, so the cells can be culled on their own. An entity that changes leaves its
+    // batches and is drawn on its own until it stays the same for staticBatchDelay frames.
+    // LOD N of a batch is LOD N of every member (or the last one it has), picked for the whole batch
+    static constexpr float staticBatchCellSize = 32.0f;
+    static constexpr uint64_t staticBatchDelay = 30;
+
+    struct StaticBatchKey
+    {
+        const VertexShaderAsset* vertexShader;
+        const FragmentShaderAsset* fragmentShader;
+        const MaterialAsset* material;
+
+        std::array<int32_t, 3> cell;
+
+        auto operator<=>(const StaticBatchKey& other) const = default;
+    };
+
+    struct StaticBatch
+    {
+        std::vector<std::pair<entt::entity, size_t>> members; // Entity and submesh
+
+        MeshPtr mesh; // World space, the bounds of the batch are its bounds
 
-        alignas(16) float bias;
+        MaterialAssetPtr material;
+        PipelineComponent pipeline;
+
+        float lodThreshold = 0.0f; // The lowest one of the members
+        uint32_t lod = 0;
+
+        bool dirty = true;
     };
 
-    std::vector<Light> lights;
-    std::vector<Shadow> shadows;
+    struct StaticEntity
+    {
+        uint64_t signature; // Everything that ends up in the batch: transform, model, materials, shaders
+
+        uint64_t changedFrame; // The signature stayed the same since then
+        uint64_t frame; // Last frame it was seen
 
-    std::array<LLGL::Texture*, 4> shadowSamplers{};
+        std::vector<StaticBatchKey> batches; // Empty if it's drawn on its own
+    };
 
-    LLGL::Buffer* lightsBuffer{};
-    LLGL::Buffer* shadowsBuffer{};
+    static uint64_t GetStaticSignature(
+        const MeshComponent& mesh,
+        const MeshRendererComponent& meshRenderer,
+        const PipelineComponent& pipeline,
+        const glm::mat4& worldTransform
+    );
+
+    void AddToStaticBatches(entt::entity entity, StaticEntity& staticEntity, const glm::mat4& worldTransform);
+    void RemoveFromStaticBatches(entt::entity entity, StaticEntity& staticEntity);
+    void RebuildStaticBatch(StaticBatch& batch);
+
+    std::unordered_map<entt::entity, StaticEntity> staticEntities;
+    std::map<StaticBatchKey, StaticBatch> staticBatches;
+
+    uint64_t staticFrame = 0;
+
+private:
+    // Of the size of the bind pose bounds on every side, enough for a character that swings its arms
+    static constexpr float animatedBoundsPadding = 0.5f;
+
+    float animationDeltaTime = 0.0f; // Accumulated by Update, the animators advance by it in Draw
+
+private:
+    struct AudibleSound
+    {
+        entt::entity entity;
+
+        int priority;
+        float distance;
+    };
+
+    std::vector<AudibleSound> audibleSounds; // Reused every frame
+
+private:
+    EventBus::Subscription assetLoadedSubscription;
+    EventBus::Subscription collisionSubscription;
 
 private:
     entt::registry registry{};
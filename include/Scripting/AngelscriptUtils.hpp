@@ -314,6 +314,26 @@ inline RayCastResult CastRay(const glm::vec3& origin, const glm::vec3& direction
     return ret;
 }
 
+inline void SetCollisionLayerMask(const uint32_t mask)
+{
+    PhysicsManager::Get().GetCollisionListener().SetLayerMask(mask);
+}
+
+inline void SetReportPersistedCollisions(const bool report)
+{
+    PhysicsManager::Get().GetCollisionListener().SetReportPersisted(report);
+}
+
+inline void WatchCollisions(const JPH::Body* body)
+{
+    PhysicsManager::Get().GetCollisionListener().WatchBody(body->GetID());
+}
+
+inline void UnwatchCollisions(const JPH::Body* body)
+{
+    PhysicsManager::Get().GetCollisionListener().UnwatchBody(body->GetID());
+}
+
 inline void MapAction(const std::string& action, const Keyboard::Key key)
 {
     InputManager::Get().MapAction(action, key);
@@ -324,11 +344,51 @@ inline void MapAction(const std::string& action, const Mouse::Button button)
     InputManager::Get().MapAction(action, button);
 }
 
+inline void MapActionById(const InputManager::ActionId action, const Keyboard::Key key)
+{
+    InputManager::Get().MapAction(action, key);
+}
+
+inline void MapActionById(const InputManager::ActionId action, const Mouse::Button button)
+{
+    InputManager::Get().MapAction(action, button);
+}
+
+inline InputManager::ActionId RegisterAction(const std::string& action)
+{
+    return InputManager::Get().RegisterAction(action);
+}
+
 inline bool IsActionPressed(const std::string& action)
 {
     return InputManager::Get().IsActionPressed(action);
 }
 
+inline bool IsActionJustPressed(const std::string& action)
+{
+    return InputManager::Get().IsActionJustPressed(action);
+}
+
+inline bool IsActionJustReleased(const std::string& action)
+{
+    return InputManager::Get().IsActionJustReleased(action);
+}
+
+inline bool IsActionPressedById(const InputManager::ActionId action)
+{
+    return InputManager::Get().IsActionPressed(action);
+}
+
+inline bool IsActionJustPressedById(const InputManager::ActionId action)
+{
+    return InputManager::Get().IsActionJustPressed(action);
+}
+
+inline bool IsActionJustReleasedById(const InputManager::ActionId action)
+{
+    return InputManager::Get().IsActionJustReleased(action);
+}
+
 template<class T>
 std::shared_ptr<T> Load(
     const std::string& path,
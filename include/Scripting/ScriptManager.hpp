@@ -24,6 +24,15 @@ public:
         uint32_t moduleIndex = 0
     ) const;
 
+    // Resolves the function once and calls it count times, setArgs receives the call index
+    void ExecuteFunction(
+        const ScriptAssetPtr& script,
+        std::string_view declaration,
+        size_t count,
+        const std::function<void(asIScriptContext*, size_t)>& setArgs,
+        uint32_t moduleIndex = 0
+    ) const;
+
     void AddScript(const ScriptAssetPtr& script);
     void RemoveScript(const ScriptAssetPtr& script);
 
@@ -117,6 +126,7 @@ private:
     void RegisterScriptComponent() const;
     void RegisterBodyComponent() const;
     void RegisterSoundComponent() const;
+    void RegisterAnimatorComponent() const;
 
     void RegisterProceduralSkyComponent() const;
     void RegisterHDRISkyComponent() const;
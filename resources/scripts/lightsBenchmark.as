@@ -0,0 +1,62 @@
+// Light culling benchmark
+// Put an entity named "BenchmarkLight" with a TransformComponent and a LightComponent
+// into the scene and attach this script to any other entity.
+// The light gets cloned lightCount times and scattered over the area, the clones orbit around their spawn points
+Entity self;
+Scene@ scene;
+
+uint lightCount = 2048;
+
+float areaSize = 100.0f;
+float height = 1.0f;
+float intensity = 1.0f;
+float range = 2.0f; // The lights are culled and faded out at this distance
+
+array<TransformComponent@> transforms;
+array<glm::vec3> origins;
+array<float> phases;
+
+float time = 0.0f;
+
+void Start()
+{
+    Entity original = scene.GetEntity("BenchmarkLight");
+
+    Random::SetSeed(1337);
+
+    for(uint i = 0; i < lightCount; i++)
+    {
+        Entity light = scene.CloneEntity(original);
+
+        auto@ lightComponent = light.GetLightComponent();
+        lightComponent.color = glm::vec3(Random::Value(), Random::Value(), Random::Value());
+        lightComponent.intensity = intensity;
+        lightComponent.range = range;
+        lightComponent.shadowMap = false;
+
+        auto@ transform = light.GetTransformComponent();
+        transform.position = glm::vec3(
+            Random::Range(-areaSize, areaSize),
+            height,
+            Random::Range(-areaSize, areaSize)
+        );
+
+        transforms.insertLast(transform);
+        origins.insertLast(transform.position);
+        phases.insertLast(Random::Range(0.0f, 6.28318f));
+    }
+
+    Log::Write(format("Spawned {} lights\n", lightCount));
+}
+
+void Update(float deltaTime)
+{
+    time += deltaTime;
+
+    for(uint i = 0; i < transforms.length(); i++)
+    {
+        float angle = time + phases[i];
+
+        transforms[i].position = origins[i] + glm::vec3(cos(angle), 0.0f, sin(angle)) * 2.0f;
+    }
+}
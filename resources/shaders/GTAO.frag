@@ -24,6 +24,10 @@ uniform float falloff = 7.5;
 uniform float thicknessMix = 0.2;
 uniform float maxStride = 8;
 
+// Change every frame when the result is accumulated over time
+uniform float temporalRotation = 0.0;
+uniform float temporalOffset = 0.0;
+
 // Used to get vector from camera to pixel
 float aspect = 1.0;
 
@@ -137,7 +141,7 @@ void main()
 	vec3 v = normalize(-ray);
 	
 	// Calculate slice direction from pixel's position
-	float dirAngle = (PI / 16.0) * (((int(gl_FragCoord.x) + int(gl_FragCoord.y) & 3) << 2) + (int(gl_FragCoord.x) & 3));
+	float dirAngle = (PI / 16.0) * (((int(gl_FragCoord.x) + int(gl_FragCoord.y) & 3) << 2) + (int(gl_FragCoord.x) & 3)) + temporalRotation;
 	vec2 aoDir = dirMult * vec2(sin(dirAngle), cos(dirAngle));
 	
 	// Project world space normal to the slice plane
@@ -153,7 +157,7 @@ void main()
 	float c1 = -1.0;
 	float c2 = -1.0;
 	
-	vec2 texCoordsBase = texCoords + aoDir * (0.25 * ((int(gl_FragCoord.y) - int(gl_FragCoord.x)) & 3) - 0.375);
+	vec2 texCoordsBase = texCoords + aoDir * (fract(0.25 * ((int(gl_FragCoord.y) - int(gl_FragCoord.x)) & 3) + temporalOffset) - 0.375);
 	
 	const float minMip = 0.0;
 	const float maxMip = 3.0;
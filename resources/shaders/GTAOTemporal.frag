@@ -0,0 +1,77 @@
+#version 460 core
+
+// This frame's occlusion
+uniform sampler2D frame;
+// Accumulated occlusion and its linear depth
+uniform sampler2D history;
+uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+uniform mat4 previousViewProjection;
+
+uniform float far;
+uniform float near;
+
+uniform float historyWeight = 0.9;
+uniform bool historyValid;
+
+in vec2 coord;
+
+out vec4 fragColor;
+
+// Relative depth difference at which the history is considered to belong to another surface
+const float depthTolerance = 0.05;
+
+float LinearizeDepth(float d)
+{
+    float z = 2.0 * d - 1.0;
+    return 2.0 * near * far / (far + near - z * (far - near));
+}
+
+void main()
+{
+    float depth = textureLod(gDepth, coord, 0.0).r;
+    float linearDepth = LinearizeDepth(depth);
+
+    float current = texture(frame, coord).r;
+
+    // The history is clamped to the neighbourhood of the current frame, so it can't ghost
+    vec2 texelSize = 1.0 / textureSize(frame, 0);
+
+    float minOcclusion = current;
+    float maxOcclusion = current;
+
+    for(int x = -1; x <= 1; x++)
+    {
+        for(int y = -1; y <= 1; y++)
+        {
+            float neighbour = texture(frame, coord + vec2(x, y) * texelSize).r;
+
+            minOcclusion = min(minOcclusion, neighbour);
+            maxOcclusion = max(maxOcclusion, neighbour);
+        }
+    }
+
+    float result = current;
+
+    if(historyValid && depth < 1.0)
+    {
+        vec4 worldPosition = inverseViewProjection * vec4(coord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+        worldPosition /= worldPosition.w;
+
+        vec4 previousClip = previousViewProjection * worldPosition;
+        vec2 previousCoord = previousClip.xy / previousClip.w * 0.5 + 0.5;
+
+        if(all(greaterThanEqual(previousCoord, vec2(0.0))) && all(lessThanEqual(previousCoord, vec2(1.0))))
+        {
+            vec2 previous = texture(history, previousCoord).rg;
+
+            // clip.w is the linear depth the point had in the previous frame,
+            // if the history is at another depth, the point was occluded
+            if(abs(previous.g - previousClip.w) < depthTolerance * previousClip.w)
+                result = mix(current, clamp(previous.r, minOcclusion, maxOcclusion), historyWeight);
+        }
+    }
+
+    fragColor = vec4(result, linearDepth, 0.0, 1.0);
+}
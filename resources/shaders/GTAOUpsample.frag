@@ -0,0 +1,51 @@
+#version 460 core
+
+// Low resolution occlusion and its linear depth
+uniform sampler2D frame;
+uniform sampler2D gDepth;
+
+uniform float far;
+uniform float near;
+
+in vec2 coord;
+
+out vec4 fragColor;
+
+float LinearizeDepth(float d)
+{
+    float z = 2.0 * d - 1.0;
+    return 2.0 * near * far / (far + near - z * (far - near));
+}
+
+// Bilinear upsample where the texels at a different depth barely contribute,
+// so the occlusion doesn't bleed over the edges of the objects
+void main()
+{
+    float depth = LinearizeDepth(textureLod(gDepth, coord, 0.0).r);
+
+    ivec2 size = textureSize(frame, 0);
+
+    vec2 position = coord * vec2(size) - 0.5;
+    vec2 base = floor(position);
+    vec2 fraction = position - base;
+
+    float result = 0.0;
+    float totalWeight = 0.0;
+
+    for(int i = 0; i < 4; i++)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+
+        vec2 texel = texelFetch(frame, clamp(ivec2(base) + offset, ivec2(0), size - 1), 0).rg;
+
+        float bilinear = (offset.x == 1 ? fraction.x : 1.0 - fraction.x)
+                       * (offset.y == 1 ? fraction.y : 1.0 - fraction.y);
+
+        float weight = bilinear / (0.001 + abs(texel.g - depth) / depth);
+
+        result += texel.r * weight;
+        totalWeight += weight;
+    }
+
+    fragColor = vec4(vec3(result / max(totalWeight, 0.0001)), 1.0);
+}
@@ -0,0 +1,70 @@
+#version 460 core
+
+const float PI = 3.14159265359;
+
+uniform samplerCubeArray skybox;
+
+// Mip level with about faceSize texels per face, the low frequencies don't need more
+uniform float lod;
+
+out vec4 fragColor;
+
+const int faceSize = 16;
+
+vec3 FaceDirection(int face, vec2 uv)
+{
+    switch(face)
+    {
+        case 0: return vec3(1.0, -uv.y, -uv.x);
+        case 1: return vec3(-1.0, -uv.y, uv.x);
+        case 2: return vec3(uv.x, 1.0, uv.y);
+        case 3: return vec3(uv.x, -1.0, -uv.y);
+        case 4: return vec3(uv.x, -uv.y, 1.0);
+        default: return vec3(-uv.x, -uv.y, -1.0);
+    }
+}
+
+// Real spherical harmonics up to the second band
+float Basis(int index, vec3 dir)
+{
+    switch(index)
+    {
+        case 0: return 0.282095;
+        case 1: return 0.488603 * dir.y;
+        case 2: return 0.488603 * dir.z;
+        case 3: return 0.488603 * dir.x;
+        case 4: return 1.092548 * dir.x * dir.y;
+        case 5: return 1.092548 * dir.y * dir.z;
+        case 6: return 0.315392 * (3.0 * dir.z * dir.z - 1.0);
+        case 7: return 1.092548 * dir.x * dir.z;
+        default: return 0.546274 * (dir.x * dir.x - dir.y * dir.y);
+    }
+}
+
+// Every texel of the 9x1 target is one coefficient, projected over all texels of the cube map
+void main()
+{
+    int index = int(gl_FragCoord.x);
+
+    vec3 coefficient = vec3(0.0);
+
+    for(int face = 0; face < 6; face++)
+    {
+        for(int y = 0; y < faceSize; y++)
+        {
+            for(int x = 0; x < faceSize; x++)
+            {
+                vec2 uv = (vec2(x, y) + 0.5) / float(faceSize) * 2.0 - 1.0;
+
+                // Solid angle of the texel, the ones in the corners of a face cover less of the sphere
+                float weight = 4.0 / (float(faceSize * faceSize) * pow(1.0 + dot(uv, uv), 1.5));
+
+                vec3 dir = normalize(FaceDirection(face, uv));
+
+                coefficient += textureLod(skybox, vec4(dir, 0.0), lod).rgb * Basis(index, dir) * weight;
+            }
+        }
+    }
+
+    fragColor = vec4(coefficient, 1.0);
+}
@@ -23,6 +23,19 @@ const float depthBias = 0.5;
 
 vec2 uv;
 
+// Octahedral normal encoding, see "A Survey of Efficient Representations for Independent Unit Vectors"
+vec3 DecodeNormal(vec2 encoded)
+{
+    encoded = encoded * 2.0 - 1.0;
+
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    float t = clamp(-normal.z, 0.0, 1.0);
+    normal.xy += vec2(normal.x >= 0.0 ? -t : t, normal.y >= 0.0 ? -t : t);
+
+    return normalize(normal);
+}
+
 vec3 ViewPosFromDepth(vec2 uv)
 {
     vec4 clipPos = vec4(uv * 2.0 - 1.0, textureLod(depth, uv, 4.0).r * 2.0 - 1.0, 1.0);
@@ -105,7 +118,7 @@ void main()
 
     vec3 pos = ViewPosFromDepth(coord);
 
-    vec3 normal = normalize(mat3(view) * texture(gNormal, coord).xyz);
+    vec3 normal = normalize(mat3(view) * DecodeNormal(texture(gNormal, coord).rg));
          normal *= vec3(-1.0, 1.0, -1.0);
 
     vec3 viewDir = normalize(pos);
@@ -0,0 +1,169 @@
+#version 460 core
+
+layout(std140) uniform matrices
+{
+    mat4 model, view, projection;
+};
+
+uniform sampler2D gNormal;
+uniform sampler2D gCombined;
+// r - closest depth under the texel, g - farthest depth
+uniform sampler2D hiZ;
+uniform sampler2D frame;
+
+uniform int maxSteps = 64;
+uniform int levelCount = 1;
+
+uniform float maxDistance = 50.0;
+uniform float thickness = 0.5;
+
+// Changes every frame, the temporal pass averages the different ray origins out
+uniform float jitter = 0.0;
+
+in vec2 coord;
+
+out vec4 fragColor;
+
+const float depthBias = 0.5;
+
+// Octahedral normal encoding, see "A Survey of Efficient Representations for Independent Unit Vectors"
+vec3 DecodeNormal(vec2 encoded)
+{
+    encoded = encoded * 2.0 - 1.0;
+
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    float t = clamp(-normal.z, 0.0, 1.0);
+    normal.xy += vec2(normal.x >= 0.0 ? -t : t, normal.y >= 0.0 ? -t : t);
+
+    return normalize(normal);
+}
+
+vec3 ViewPosFromDepth(vec2 uv, float depth)
+{
+    vec4 clipPos = vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 viewPos = inverse(projection) * clipPos;
+
+    return viewPos.xyz / viewPos.w;
+}
+
+// xy - texture coordinates, z - depth
+vec3 ScreenPos(vec3 viewPos)
+{
+    vec4 clip = projection * vec4(viewPos, 1.0);
+
+    return clip.xyz / clip.w * 0.5 + 0.5;
+}
+
+float LinearDepth(float depth)
+{
+    return -ViewPosFromDepth(vec2(0.5), depth).z;
+}
+
+// Ray parameter at which the ray leaves the cell, slightly pushed into the next one
+float CellExit(vec3 origin, vec3 dir, vec2 cell, vec2 cellCount)
+{
+    vec2 border = (cell + step(vec2(0.0), dir.xy) + sign(dir.xy) * 0.005) / cellCount;
+    vec2 t = (border - origin.xy) / dir.xy;
+
+    return min(t.x, t.y);
+}
+
+// Screen space ray from origin to origin + dir, see "Hi-Z Screen-Space Cone-Traced Reflections" (GPU Pro 5).
+// While the ray is in front of the closest depth of a cell, the whole cell is skipped and the
+// next one is checked one level higher, otherwise the ray goes down to a finer level
+bool Trace(vec3 origin, vec3 dir, out vec3 hit)
+{
+    dir.xy = mix(dir.xy, vec2(1e-5), lessThan(abs(dir.xy), vec2(1e-5)));
+
+    vec2 fullSize = vec2(textureSize(hiZ, 0));
+
+    // Leave the pixel the ray starts at, otherwise it hits itself
+    float t = CellExit(origin, dir, floor(origin.xy * fullSize), fullSize) * (1.0 + jitter);
+
+    int level = 0;
+
+    for(int i = 0; i < maxSteps && level >= 0; i++)
+    {
+        vec3 position = origin + dir * t;
+
+        if(t >= 1.0 || any(lessThan(position.xy, vec2(0.0))) || any(greaterThanEqual(position.xy, vec2(1.0))))
+            return false;
+
+        vec2 cellCount = vec2(textureSize(hiZ, level));
+        vec2 cell = floor(position.xy * cellCount);
+
+        float closest = texelFetch(hiZ, ivec2(cell), level).r;
+        float exit = CellExit(origin, dir, cell, cellCount);
+
+        if(position.z < closest)
+        {
+            // Either the ray reaches the closest depth inside the cell, or it skips the cell entirely
+            float tDepth = dir.z > 0.0 ? (closest - origin.z) / dir.z : exit;
+
+            if(tDepth < exit)
+            {
+                t = tDepth;
+                level--;
+            }
+            else
+            {
+                t = exit;
+                level = min(level + 1, levelCount - 1);
+            }
+        }
+        else if(level == 0 && LinearDepth(position.z) - LinearDepth(closest) > thickness)
+            t = exit; // Passes behind a thin object
+        else
+            level--;
+    }
+
+    hit = origin + dir * t;
+
+    return level < 0;
+}
+
+void main()
+{
+    float depth = texelFetch(hiZ, ivec2(coord * textureSize(hiZ, 0)), 0).r;
+
+    if(depth == 1.0)
+        discard;
+
+    vec4 combined = texture(gCombined, coord);
+
+    if(combined.x == 0.0 && combined.y >= 0.9)
+        discard;
+
+    vec3 pos = ViewPosFromDepth(coord, depth);
+
+    vec3 normal = normalize(mat3(view) * DecodeNormal(texture(gNormal, coord).rg));
+         normal *= vec3(-1.0, 1.0, -1.0);
+
+    vec3 viewDir = normalize(pos);
+    vec3 reflected = normalize(reflect(viewDir, normal));
+
+    // The projection flips behind the near plane, so the ray has to end before it
+    float near = LinearDepth(0.0);
+    float rayLength = maxDistance;
+
+    if(reflected.z > 0.0)
+        rayLength = min(rayLength, (-near - pos.z) / reflected.z * 0.99);
+
+    vec3 origin = vec3(coord, depth);
+    vec3 end = ScreenPos(pos + reflected * rayLength);
+
+    vec3 hit;
+
+    if(rayLength <= 0.0 || !Trace(origin, end - origin, hit) || LinearDepth(hit.z) < depthBias)
+    {
+        fragColor = vec4(0.0);
+        return;
+    }
+
+    // Fade the reflections that are about to run out of the ray
+    float travelled = length(hit.xy - origin.xy) / max(length(end.xy - origin.xy), 1e-5);
+    float fade = 1.0 - smoothstep(0.8, 1.0, travelled);
+
+    fragColor = vec4(texture(frame, hit.xy).rgb * fade, fade);
+}
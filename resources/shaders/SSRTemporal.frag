@@ -0,0 +1,63 @@
+#version 460 core
+
+// This frame's reflections
+uniform sampler2D frame;
+// Accumulated reflections
+uniform sampler2D history;
+uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+uniform mat4 previousViewProjection;
+
+uniform float historyWeight = 0.9;
+uniform bool historyValid;
+
+in vec2 coord;
+
+out vec4 fragColor;
+
+void main()
+{
+    float depth = textureLod(gDepth, coord, 0.0).r;
+
+    vec4 current = textureLod(frame, coord, 0.0);
+
+    // The history is clamped to the neighbourhood of the current frame, so it can't ghost
+    vec2 texelSize = 1.0 / textureSize(frame, 0);
+
+    vec4 minColor = current;
+    vec4 maxColor = current;
+
+    for(int x = -1; x <= 1; x++)
+    {
+        for(int y = -1; y <= 1; y++)
+        {
+            vec4 neighbour = textureLod(frame, coord + vec2(x, y) * texelSize, 0.0);
+
+            minColor = min(minColor, neighbour);
+            maxColor = max(maxColor, neighbour);
+        }
+    }
+
+    vec4 result = current;
+
+    if(historyValid && depth < 1.0)
+    {
+        // Reprojected with the depth of the reflecting surface, which is close enough for glossy
+        // reflections, the clamp takes care of the rest
+        vec4 worldPosition = inverseViewProjection * vec4(coord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+        worldPosition /= worldPosition.w;
+
+        vec4 previousClip = previousViewProjection * worldPosition;
+        vec2 previousCoord = previousClip.xy / previousClip.w * 0.5 + 0.5;
+
+        if(all(greaterThanEqual(previousCoord, vec2(0.0))) && all(lessThanEqual(previousCoord, vec2(1.0))))
+        {
+            vec4 previous = textureLod(history, previousCoord, 0.0);
+
+            result = mix(current, clamp(previous, minColor, maxColor), historyWeight);
+        }
+    }
+
+    fragColor = result;
+}
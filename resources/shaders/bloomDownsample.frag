@@ -0,0 +1,59 @@
+#version 460 core
+
+// 13-tap downsample from "Next Generation Post Processing in Call of Duty: Advanced Warfare"
+uniform sampler2D frame;
+
+// Weights the first downsample by luminance to keep single bright pixels from flickering
+uniform bool karisAverage;
+
+in vec2 coord;
+
+out vec4 fragColor;
+
+float KarisWeight(vec3 color)
+{
+    return 1.0 / (1.0 + dot(color, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+void main()
+{
+    vec2 texelSize = 1.0 / textureSize(frame, 0);
+
+    vec3 A = texture(frame, coord + texelSize * vec2(-2.0, -2.0)).rgb;
+    vec3 B = texture(frame, coord + texelSize * vec2(0.0, -2.0)).rgb;
+    vec3 C = texture(frame, coord + texelSize * vec2(2.0, -2.0)).rgb;
+    vec3 D = texture(frame, coord + texelSize * vec2(-1.0, -1.0)).rgb;
+    vec3 E = texture(frame, coord + texelSize * vec2(1.0, -1.0)).rgb;
+    vec3 F = texture(frame, coord + texelSize * vec2(-2.0, 0.0)).rgb;
+    vec3 G = texture(frame, coord).rgb;
+    vec3 H = texture(frame, coord + texelSize * vec2(2.0, 0.0)).rgb;
+    vec3 I = texture(frame, coord + texelSize * vec2(-1.0, 1.0)).rgb;
+    vec3 J = texture(frame, coord + texelSize * vec2(1.0, 1.0)).rgb;
+    vec3 K = texture(frame, coord + texelSize * vec2(-2.0, 2.0)).rgb;
+    vec3 L = texture(frame, coord + texelSize * vec2(0.0, 2.0)).rgb;
+    vec3 M = texture(frame, coord + texelSize * vec2(2.0, 2.0)).rgb;
+
+    // Five overlapping 2x2 boxes, the center one has half of the weight
+    vec3 boxes[5] = vec3[](
+        (D + E + I + J) * 0.25,
+        (A + B + F + G) * 0.25,
+        (B + C + G + H) * 0.25,
+        (F + G + K + L) * 0.25,
+        (G + H + L + M) * 0.25
+    );
+
+    const float boxWeights[5] = float[](0.5, 0.125, 0.125, 0.125, 0.125);
+
+    vec3 result = vec3(0.0);
+    float totalWeight = 0.0;
+
+    for(int i = 0; i < 5; i++)
+    {
+        float weight = boxWeights[i] * (karisAverage ? KarisWeight(boxes[i]) : 1.0);
+
+        result += boxes[i] * weight;
+        totalWeight += weight;
+    }
+
+    fragColor = vec4(max(result / totalWeight, vec3(0.0001)), 1.0);
+}
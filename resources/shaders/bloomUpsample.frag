@@ -0,0 +1,34 @@
+#version 460 core
+
+// The lower mip, upsampled with a 3x3 tent filter
+uniform sampler2D frame;
+// The same level of the downsample chain
+uniform sampler2D current;
+
+uniform float filterRadius = 1.0;
+uniform float weight = 1.0;
+
+in vec2 coord;
+
+out vec4 fragColor;
+
+void main()
+{
+    vec2 offset = filterRadius / textureSize(frame, 0);
+
+    vec3 result = texture(frame, coord).rgb * 4.0;
+
+    result += (texture(frame, coord + vec2(-offset.x, 0.0)).rgb
+             + texture(frame, coord + vec2(offset.x, 0.0)).rgb
+             + texture(frame, coord + vec2(0.0, -offset.y)).rgb
+             + texture(frame, coord + vec2(0.0, offset.y)).rgb) * 2.0;
+
+    result += texture(frame, coord + vec2(-offset.x, -offset.y)).rgb
+            + texture(frame, coord + vec2(offset.x, -offset.y)).rgb
+            + texture(frame, coord + vec2(-offset.x, offset.y)).rgb
+            + texture(frame, coord + vec2(offset.x, offset.y)).rgb;
+
+    result /= 16.0;
+
+    fragColor = vec4((texture(current, coord).rgb + result) * weight, 1.0);
+}
@@ -1,11 +1,7 @@
 #version 460 core
 
-uniform int albedoType;
-uniform int normalType;
-uniform int metallicType;
-uniform int roughnessType;
-uniform int aoType;
-uniform int emissionType;
+// Material variants, a keyword is defined if the property is a texture:
+// ALBEDO_TEXTURE, NORMAL_TEXTURE, METALLIC_TEXTURE, ROUGHNESS_TEXTURE, AO_TEXTURE, EMISSION_TEXTURE
 
 uniform sampler2D albedoTexture;
 uniform sampler2D normalTexture;
@@ -25,44 +21,66 @@ in vec3 mNormal;
 in mat3 TBN;
 in vec2 coord;
 
-layout(location = 0) out vec4 gPosition;
-layout(location = 1) out vec4 gAlbedo;
-layout(location = 2) out vec4 gNormal;
-layout(location = 3) out vec4 gCombined;
-layout(location = 4) out vec4 gEmission;
+// The position is reconstructed from the depth
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec2 gNormal;
+layout(location = 2) out vec4 gCombined;
+layout(location = 3) out vec4 gEmission;
 
-void main()
+// Octahedral normal encoding, see "A Survey of Efficient Representations for Independent Unit Vectors"
+vec2 EncodeNormal(vec3 normal)
 {
-	float metallic = metallicValue;
-	float roughness = roughnessValue;
-	float ao = 1.0;
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
 
-	gPosition = vec4(mPosition, 1.0);
+	vec2 encoded = normal.z >= 0.0
+		? normal.xy
+		: (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
 
-	if(albedoType == 0)
-		gAlbedo = albedoValue;
-	else
-		gAlbedo = texture(albedoTexture, coord);
+	return encoded * 0.5 + 0.5;
+}
+
+void main()
+{
+#ifdef ALBEDO_TEXTURE
+	gAlbedo = texture(albedoTexture, coord);
+#else
+	gAlbedo = albedoValue;
+#endif
 
 	if(gAlbedo.a < 0.5)
 		discard;
 
-	if(normalType == 0)
-		gNormal = vec4(mNormal, 1.0);
-	else
-		gNormal = vec4(normalize(TBN * normalize(texture(normalTexture, coord).xyz * 2.0 - 1.0)), 1.0);
-
-	if(metallicType == 1)
-		metallic = texture(metallicTexture, coord).b;
-	if(roughnessType == 1)
-		roughness = texture(roughnessTexture, coord).g;
-	if(aoType == 1)
-		ao = texture(aoTexture, coord).r;
-
-	if(emissionType == 0)
-		gEmission = vec4(emissionValue * emissionStrength, 1.0);
-	else
-		gEmission = vec4(texture(emissionTexture, coord).rgb * emissionStrength, 1.0);
+	gAlbedo.a = 1.0; // The first target is blended
+
+#ifdef NORMAL_TEXTURE
+	gNormal = EncodeNormal(normalize(TBN * normalize(texture(normalTexture, coord).xyz * 2.0 - 1.0)));
+#else
+	gNormal = EncodeNormal(normalize(mNormal));
+#endif
+
+#ifdef METALLIC_TEXTURE
+	float metallic = texture(metallicTexture, coord).b;
+#else
+	float metallic = metallicValue;
+#endif
+
+#ifdef ROUGHNESS_TEXTURE
+	float roughness = texture(roughnessTexture, coord).g;
+#else
+	float roughness = roughnessValue;
+#endif
+
+#ifdef AO_TEXTURE
+	float ao = texture(aoTexture, coord).r;
+#else
+	float ao = 1.0;
+#endif
+
+#ifdef EMISSION_TEXTURE
+	gEmission = vec4(texture(emissionTexture, coord).rgb * emissionStrength, 1.0);
+#else
+	gEmission = vec4(emissionValue * emissionStrength, 1.0);
+#endif
 
 	gCombined = vec4(metallic, roughness, ao, 1.0);
 }
@@ -3,11 +3,35 @@
 layout(std140) uniform matrices
 {
     mat4 model, view, projection;
+    vec4 positionScale, positionOffset;
 };
 
 in vec3 position;
 
+#ifdef SKINNED
+layout(std430) readonly buffer skinning
+{
+    mat4 palettes[];
+};
+
+uniform int paletteOffset;
+
+in uvec4 jointIndices;
+in vec4 jointWeights;
+#endif
+
 void main()
 {
-	gl_Position = projection * view * model * vec4(position, 1.0f);
+    vec4 localPosition = vec4(position * positionScale.xyz + positionOffset.xyz, 1.0f);
+
+#ifdef SKINNED
+    uvec4 joints = jointIndices + uint(paletteOffset);
+
+    localPosition = (palettes[joints.x] * jointWeights.x
+                   + palettes[joints.y] * jointWeights.y
+                   + palettes[joints.z] * jointWeights.z
+                   + palettes[joints.w] * jointWeights.w) * localPosition;
+#endif
+
+	gl_Position = projection * view * model * localPosition;
 }
@@ -0,0 +1,48 @@
+#version 460 core
+
+uniform sampler2D depth;
+// Previous level of the pyramid, r - closest depth, g - farthest depth
+uniform sampler2D hiZ;
+
+uniform int level;
+
+in vec2 coord;
+
+out vec4 fragColor;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    if(level == 0)
+    {
+        float d = texelFetch(depth, texel, 0).r;
+
+        fragColor = vec4(d, d, 0.0, 1.0);
+        return;
+    }
+
+    ivec2 previousSize = textureSize(hiZ, 0);
+    ivec2 size = max(previousSize / 2, ivec2(1));
+
+    // With an odd previous size the last texel also covers the row or column that is left over
+    ivec2 extent = ivec2(2) + ivec2(
+        (previousSize.x & 1) == 1 && texel.x == size.x - 1 ? 1 : 0,
+        (previousSize.y & 1) == 1 && texel.y == size.y - 1 ? 1 : 0
+    );
+
+    vec2 minMax = vec2(1.0, 0.0);
+
+    for(int x = 0; x < extent.x; x++)
+    {
+        for(int y = 0; y < extent.y; y++)
+        {
+            ivec2 previous = min(texel * 2 + ivec2(x, y), previousSize - 1);
+            vec2 sampled = texelFetch(hiZ, previous, 0).rg;
+
+            minMax = vec2(min(minMax.x, sampled.x), max(minMax.y, sampled.y));
+        }
+    }
+
+    fragColor = vec4(minMax, 0.0, 1.0);
+}
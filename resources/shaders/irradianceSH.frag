@@ -0,0 +1,36 @@
+#version 460 core
+
+// 9x1, made by SHProject.frag
+uniform sampler2D coefficients;
+
+in vec3 vertex;
+
+out vec4 fragColor;
+
+// Convolution with the cosine lobe is a scale per band, see "An Efficient Representation
+// for Irradiance Environment Maps" (Ramamoorthi, Hanrahan). Divided by PI like irradiance.frag
+const float band0 = 1.0;
+const float band1 = 2.0 / 3.0;
+const float band2 = 0.25;
+
+void main()
+{
+    vec3 n = normalize(vertex);
+
+    vec3 c[9];
+
+    for(int i = 0; i < 9; i++)
+        c[i] = texelFetch(coefficients, ivec2(i, 0), 0).rgb;
+
+    vec3 irradiance = c[0] * 0.282095 * band0;
+
+    irradiance += (c[1] * n.y + c[2] * n.z + c[3] * n.x) * 0.488603 * band1;
+
+    irradiance += (c[4] * 1.092548 * n.x * n.y
+                 + c[5] * 1.092548 * n.y * n.z
+                 + c[6] * 0.315392 * (3.0 * n.z * n.z - 1.0)
+                 + c[7] * 1.092548 * n.x * n.z
+                 + c[8] * 0.546274 * (n.x * n.x - n.y * n.y)) * band2;
+
+    fragColor = vec4(max(irradiance, vec3(0.0)), 1.0);
+}
@@ -4,14 +4,17 @@
 #define OREN_NAYAR_DIFFUSE 1
 #define BURLEY_DIFFUSE 2
 
-#define DIFFUSE_METHOD BURLEY_DIFFUSE
+// Can be selected with a shader variant keyword, e.g. "DIFFUSE_METHOD 0"
+#ifndef DIFFUSE_METHOD
+    #define DIFFUSE_METHOD BURLEY_DIFFUSE
+#endif
 
 const float PI = 3.14159265359;
 
 const float maxReflectionLod = 8.0;
 
-const int maxLights = 128;
-const int maxShadows = 4;
+// Must match LightClusters::gridX/Y/Z
+const uvec3 clusterGrid = uvec3(16, 9, 24);
 
 const vec3 F0 = vec3(0.04);
 
@@ -24,42 +27,62 @@ struct Light
     vec3 color;
 
     float intensity, cutoff, outerCutoff;
+    float radius;
 };
 
 struct Shadow
 {
     mat4 lightSpaceMatrix;
+    vec4 atlasRect; // xy - offset, zw - scale
 
     float bias;
+
+    float splitDepth; // View space depth the shadow reaches
+    int cascadeCount; // Only valid for the first shadow of the light
 };
 
-layout(std140) uniform lightBuffer
+layout(std430) readonly buffer lightBuffer
 {
-    Light lights[maxLights];
+    Light lights[];
 };
 
-layout(std140) uniform shadowBuffer
+// x - offset in lightIndices, y - number of lights
+layout(std430) readonly buffer clusterBuffer
 {
-    Shadow shadows[maxShadows];
+    uvec2 clusters[];
 };
 
-uniform sampler2DShadow shadowMaps[maxShadows];
+layout(std430) readonly buffer lightIndexBuffer
+{
+    uint lightIndices[];
+};
 
-uniform vec3 cameraPosition;
+layout(std430) readonly buffer shadowBuffer
+{
+    Shadow shadows[];
+};
+
+uniform sampler2DShadow shadowAtlas;
 
-uniform int numLights;
-uniform int numShadows;
+uniform vec3 cameraPosition;
 
 uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 inverseView;
+uniform mat4 inverseProjection;
+
+// slice = log(depth) * clusterScale - clusterBias
+uniform float clusterScale;
+uniform float clusterBias;
 
 uniform samplerCubeArray irradiance;
 uniform samplerCubeArray prefiltered;
 
-uniform sampler2D gPosition;
 uniform sampler2D gAlbedo;
 uniform sampler2D gNormal;
 uniform sampler2D gCombined;
 uniform sampler2D gEmission;
+uniform sampler2D gDepth;
 
 uniform sampler2D gtao;
 uniform sampler2D brdf;
@@ -68,6 +91,26 @@ in vec2 coord;
 
 out vec4 fragColor;
 
+// Octahedral normal encoding, see "A Survey of Efficient Representations for Independent Unit Vectors"
+vec3 DecodeNormal(vec2 encoded)
+{
+    encoded = encoded * 2.0 - 1.0;
+
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    float t = clamp(-normal.z, 0.0, 1.0);
+    normal.xy += vec2(normal.x >= 0.0 ? -t : t, normal.y >= 0.0 ? -t : t);
+
+    return normalize(normal);
+}
+
+vec3 ViewPosFromDepth(vec2 uv, float depth)
+{
+    vec4 viewPos = inverseProjection * vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+
+    return viewPos.xyz / viewPos.w;
+}
+
 vec3 FresnelSchlick(float cosTheta, vec3 F0)
 {
     return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
@@ -126,27 +169,28 @@ float CalculateShadow(int index, vec4 position)
     vec3 projCoords = lightSpacePosition.xyz / lightSpacePosition.w;
     projCoords = projCoords * vec3(0.5, -0.5, 0.5) + 0.5;
 
-    if(projCoords.z > 1.0)
+    if(projCoords.z > 1.0 || any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0))))
         return 0.0;
 
     projCoords.z -= shadows[index].bias;
 
-    return 1.0 - texture(shadowMaps[index], projCoords);
-}
+    // Keep the filter footprint inside the tile
+    vec4 rect = shadows[index].atlasRect;
+    vec2 halfTexel = 0.5 / vec2(textureSize(shadowAtlas, 0));
 
-float CalculateShadows(vec4 position)
-{
-    float ret = 0.0;
+    projCoords.xy = clamp(rect.xy + projCoords.xy * rect.zw, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel);
 
-    for(int i = 0; i < numShadows; i++)
-    {
-        float tmp = CalculateShadow(i, position);
+    return 1.0 - texture(shadowAtlas, projCoords);
+}
 
-        if(ret < tmp)
-            ret = tmp;
-    }
+// Cascades of a directional light go in a row, the nearest one that reaches the depth is used
+int SelectCascade(int first, float depth)
+{
+    for(int i = 0; i < shadows[first].cascadeCount; i++)
+        if(depth <= shadows[first + i].splitDepth)
+            return first + i;
 
-    return ret;
+    return -1;
 }
 
 // https://github.com/glslify/glsl-diffuse-oren-nayar
@@ -196,6 +240,13 @@ vec3 CalculateLight(int index, vec3 worldPosition, vec3 V, vec3 N, vec3 albedo,
     float dist = length(lights[index].position - worldPosition);
     float attenuation = 1.0 / clamp(dist * 0.1, 0.0, 100.0); // Need a more flexible method
 
+    // Fade out towards the radius the light was culled with, directional lights have none
+    if(!isinf(lights[index].radius))
+    {
+        float falloff = clamp(1.0 - pow(dist / lights[index].radius, 4.0), 0.0, 1.0);
+        attenuation *= falloff * falloff;
+    }
+
     vec3 radiance = lights[index].color * lights[index].intensity * intensity * attenuation;
 
     float NDF = DistributionGGX(N, H, roughness);
@@ -233,32 +284,58 @@ vec3 CalculateLight(int index, vec3 worldPosition, vec3 V, vec3 N, vec3 albedo,
 #endif
 }
 
+uint GetCluster(vec3 viewPosition)
+{
+    vec4 clip = projection * vec4(viewPosition, 1.0);
+    vec2 tile = (clip.xy / clip.w) * 0.5 + 0.5;
+
+    uvec3 cluster = uvec3(
+        uvec2(clamp(tile * vec2(clusterGrid.xy), vec2(0.0), vec2(clusterGrid.xy) - 1.0)),
+        uint(clamp(log(-viewPosition.z) * clusterScale - clusterBias, 0.0, float(clusterGrid.z - 1)))
+    );
+
+    return cluster.x + cluster.y * clusterGrid.x + cluster.z * clusterGrid.x * clusterGrid.y;
+}
+
 void CalculateLights(
-    inout vec3 totalLighting, inout vec3 totalNoShadow,
+    inout vec3 totalLighting, inout float shadow,
 
-    vec3 worldPosition, vec3 V, vec3 N, vec3 albedo, float metallic, float roughness
+    vec3 viewPosition, vec3 worldPosition, vec3 V, vec3 N, vec3 albedo, float metallic, float roughness
 )
 {
-    for(int i = 0; i < numLights; i++)
+    uvec2 cluster = clusters[GetCluster(viewPosition)];
+
+    for(uint j = 0; j < cluster.y; j++)
     {
+        int i = int(lightIndices[cluster.x + j]);
+
         vec3 res = CalculateLight(i, worldPosition, V, N, albedo, metallic, roughness);
 
-        if(lights[i].shadow == 1)
-            totalLighting += res;
-        else
-            totalNoShadow += res;
+        int shadowIndex = lights[i].shadow >= 0 ? SelectCascade(lights[i].shadow, -viewPosition.z) : -1;
+
+        if(shadowIndex >= 0)
+        {
+            float lightShadow = CalculateShadow(shadowIndex, vec4(worldPosition, 1.0));
+
+            res *= 1.0 - lightShadow;
+            shadow = max(shadow, lightShadow);
+        }
+
+        totalLighting += res;
     }
 }
 
 void main()
 {
-    vec4 posSample = inverse(view) * texture(gPosition, coord);
-    if(posSample.w <= 0.001)
+    float depth = texture(gDepth, coord).r;
+    if(depth == 1.0)
         discard;
 
-    vec3 worldPosition = posSample.xyz;
+    vec4 viewPosition = vec4(ViewPosFromDepth(coord, depth), 1.0);
+
+    vec3 worldPosition = (inverseView * viewPosition).xyz;
     vec3 albedo = texture(gAlbedo, coord).rgb;
-    vec3 normal = normalize(texture(gNormal, coord).xyz);
+    vec3 normal = DecodeNormal(texture(gNormal, coord).rg);
     vec3 combined = texture(gCombined, coord).rgb;
     vec3 emission = texture(gEmission, coord).rgb;
 
@@ -272,11 +349,9 @@ void main()
     float NdotV = clamp(dot(normal, V), 0.0, 0.99);
 
     vec3 totalLighting = vec3(0.0);
-    vec3 totalNoShadow = vec3(0.0);
-
-    CalculateLights(totalLighting, totalNoShadow, worldPosition, V, normal, albedo, metallic, roughness);
+    float shadow = 0.0;
 
-    float shadow = CalculateShadows(vec4(worldPosition, 1.0));
+    CalculateLights(totalLighting, shadow, viewPosition.xyz, worldPosition, V, normal, albedo, metallic, roughness);
 
     vec3 F = FresnelSchlickRoughness(NdotV, mix(F0, albedo, metallic), roughness);
 
@@ -292,7 +367,7 @@ void main()
 
     vec3 ambient = (kD * diffuse + specular);
 
-    vec3 finalColor = (((ambient + totalLighting) * (1.0 - shadow)) + totalNoShadow + emission + (ambient / 5.0) * shadow) * ao;
+    vec3 finalColor = ((ambient * (1.0 - shadow)) + totalLighting + emission + (ambient / 5.0) * shadow) * ao;
 
     fragColor = vec4(finalColor, 1.0);
 }
@@ -29,11 +29,23 @@ in vec3 mNormal;
 in mat3 TBN;
 in vec2 coord;
 
-layout(location = 0) out vec4 gPosition;
-layout(location = 1) out vec4 gAlbedo;
-layout(location = 2) out vec4 gNormal;
-layout(location = 3) out vec4 gCombined;
-layout(location = 4) out vec4 gEmission;
+// The position is reconstructed from the depth
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec2 gNormal;
+layout(location = 2) out vec4 gCombined;
+layout(location = 3) out vec4 gEmission;
+
+// Octahedral normal encoding, see "A Survey of Efficient Representations for Independent Unit Vectors"
+vec2 EncodeNormal(vec3 normal)
+{
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+
+    vec2 encoded = normal.z >= 0.0
+        ? normal.xy
+        : (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+
+    return encoded * 0.5 + 0.5;
+}
 
 float checkerPattern(vec2 uv, float scale)
 {
@@ -53,8 +65,6 @@ void main()
     float roughness = roughnessValue;
     float ao = 1.0;
 
-    gPosition = vec4(mPosition, 1.0);
-    
     vec2 wrappedCoord = fract(coord);
     if(albedoType == 0)
 	{
@@ -66,6 +76,8 @@ void main()
     else
         gAlbedo = texture(albedoTexture, wrappedCoord);
 
+    gAlbedo.a = 1.0; // The first target is blended
+
     if(normalType == 0)
 	{
         vec3 distortedNormal = mNormal;
@@ -78,12 +90,12 @@ void main()
         if(len > 0.0)
             distortedNormal /= len;
 			
-        gNormal = vec4(distortedNormal, 1.0);
+        gNormal = EncodeNormal(distortedNormal);
     }
     else
 	{
         vec3 normalMap = texture(normalTexture, wrappedCoord).xyz * 2.0 - 1.0;
-        gNormal = vec4(normalize(TBN * normalize(normalMap)), 1.0);
+        gNormal = EncodeNormal(normalize(TBN * normalize(normalMap)));
     }
     
     if(metallicType == 1)
@@ -3,12 +3,37 @@
 layout(std140) uniform matrices
 {
     mat4 model, view, projection;
+    // Dequantization of compressed meshes, w of the offset is 1 when the normals are octahedral
+    vec4 positionScale, positionOffset;
 };
 
 in vec3 position;
 in vec3 normal;
 in vec2 texCoord;
 
+#ifdef SKINNED
+// The palettes of all the visible animators, this one starts at paletteOffset
+layout(std430) readonly buffer skinning
+{
+    mat4 palettes[];
+};
+
+uniform int paletteOffset;
+
+in uvec4 jointIndices;
+in vec4 jointWeights;
+
+mat4 GetSkinMatrix()
+{
+    uvec4 joints = jointIndices + uint(paletteOffset);
+
+    return palettes[joints.x] * jointWeights.x
+         + palettes[joints.y] * jointWeights.y
+         + palettes[joints.z] * jointWeights.z
+         + palettes[joints.w] * jointWeights.w;
+}
+#endif
+
 out vec3 mPosition;
 out vec3 mNormal;
 out mat3 TBN;
@@ -17,17 +42,40 @@ out vec2 coord;
 uniform vec2 uvScale = vec2(1.0);
 uniform vec2 uvOffset = vec2(0.0);
 
+vec3 DecodeNormal(vec3 encoded)
+{
+    if(positionOffset.w == 0.0)
+        return encoded;
+
+    vec3 normal = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    float t = clamp(-normal.z, 0.0, 1.0);
+    normal.xy += vec2(normal.x >= 0.0 ? -t : t, normal.y >= 0.0 ? -t : t);
+
+    return normalize(normal);
+}
+
 void main()
 {
-    mPosition = (view * model * vec4(position, 1.0)).xyz;
-    mNormal = normalize(mat3(model) * normal);
+    vec3 localPosition = position * positionScale.xyz + positionOffset.xyz;
+    vec3 localNormal = DecodeNormal(normal);
+
+#ifdef SKINNED
+    mat4 skin = GetSkinMatrix();
+
+    localPosition = (skin * vec4(localPosition, 1.0)).xyz;
+    localNormal = mat3(skin) * localNormal;
+#endif
+
+    mPosition = (view * model * vec4(localPosition, 1.0)).xyz;
+    mNormal = normalize(mat3(model) * localNormal);
     coord = (texCoord + uvOffset) * uvScale;
 
-    vec3 tangent = cross(mNormal, vec3(0.5, 0.5, 0.5));
-    vec3 T = normalize(mat3(model) * tangent);
+    // Built from the world space normal alone, so the static batches (already in world space) get the same basis
+    vec3 T = normalize(cross(mNormal, vec3(0.5, 0.5, 0.5)));
     vec3 N = mNormal;
     vec3 B = cross(N, T);
     TBN = mat3(T, B, N);
     
-	gl_Position = projection * view * model * vec4(position, 1.0);
+	gl_Position = projection * view * model * vec4(localPosition, 1.0);
 }
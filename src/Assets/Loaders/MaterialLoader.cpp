@@ -3,7 +3,7 @@
 #include <Serialize.hpp>
 #include <MaterialLoader.hpp>
 #include <AssetManager.hpp>
-#include <EventManager.hpp>
+#include <EventBus.hpp>
 
 #include <fstream>
 
@@ -45,7 +45,7 @@ AssetPtr MaterialLoader::Load(
 
     material->loaded = true;
 
-    EventManager::Get().Dispatch(std::make_unique<AssetLoadedEvent>(material));
+    EventBus::Get().Publish(AssetLoadedEvent(material));
 
     return material;
 }
@@ -1,10 +1,110 @@
 #include <ModelLoader.hpp>
 #include <Multithreading.hpp>
-#include <EventManager.hpp>
+#include <EventBus.hpp>
+#include <Matrices.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
 
 namespace lustra
 {
 
+static glm::mat4 ToGlm(const aiMatrix4x4& matrix)
+{
+    // Assimp matrices are row-major
+    return glm::transpose(glm::make_mat4(&matrix.a1));
+}
+
+static glm::vec3 ToGlm(const aiVector3D& vector)
+{
+    return { vector.x, vector.y, vector.z };
+}
+
+static glm::quat ToGlm(const aiQuaternion& quaternion)
+{
+    return { quaternion.w, quaternion.x, quaternion.y, quaternion.z };
+}
+
+static glm::vec3 Mix(const glm::vec3& a, const glm::vec3& b, const float alpha)
+{
+    return glm::mix(a, b, alpha);
+}
+
+static glm::quat Mix(const glm::quat& a, const glm::quat& b, const float alpha)
+{
+    return glm::slerp(a, b, alpha);
+}
+
+// aiVectorKey or aiQuatKey, time is in ticks
+template<class Key>
+static auto InterpolateKeys(const Key* keys, const unsigned int count, const double time)
+{
+    const auto next = std::upper_bound(keys, keys + count, time, [](const double t, const Key& key)
+    {
+        return t < key.mTime;
+    });
+
+    if(next == keys)
+        return ToGlm(keys[0].mValue);
+
+    if(next == keys + count)
+        return ToGlm(keys[count - 1].mValue);
+
+    const auto& previous = *(next - 1);
+    const auto alpha = static_cast<float>((time - previous.mTime) / (next->mTime - previous.mTime));
+
+    return Mix(ToGlm(previous.mValue), ToGlm(next->mValue), alpha);
+}
+
+// A node is a joint if it's a bone or any of its descendants is
+static bool CollectJoints(
+    const aiNode* node,
+    const std::unordered_map<std::string, glm::mat4>& bones,
+    std::unordered_set<const aiNode*>& joints
+)
+{
+    bool joint = bones.contains(node->mName.C_Str());
+
+    for(uint32_t i = 0; i < node->mNumChildren; i++)
+        if(CollectJoints(node->mChildren[i], bones, joints))
+            joint = true;
+
+    if(joint)
+        joints.insert(node);
+
+    return joint;
+}
+
+// Depth first, so the parents go before their children
+static void AddJoints(
+    const aiNode* node,
+    const int32_t parent,
+    const std::unordered_map<std::string, glm::mat4>& bones,
+    const std::unordered_set<const aiNode*>& joints,
+    Skeleton& skeleton,
+    std::vector<Animation::Keyframe>& restPose
+)
+{
+    if(!joints.contains(node))
+        return;
+
+    const auto index = static_cast<int32_t>(skeleton.joints.size());
+    const auto bone = bones.find(node->mName.C_Str());
+
+    skeleton.joints.push_back({ node->mName.C_Str(), parent, bone != bones.end() ? bone->second : glm::mat4(1.0f) });
+
+    aiVector3D scale, translation;
+    aiQuaternion rotation;
+
+    node->mTransformation.Decompose(scale, rotation, translation);
+
+    restPose.push_back({ 0.0f, ToGlm(translation), ToGlm(rotation), ToGlm(scale) });
+
+    for(uint32_t i = 0; i < node->mNumChildren; i++)
+        AddJoints(node->mChildren[i], index, bones, joints, skeleton, restPose);
+}
+
 AssetPtr ModelLoader::Load(
     const std::filesystem::path& path,
     const AssetPtr existing,
@@ -39,12 +139,15 @@ AssetPtr ModelLoader::Load(
         modelAsset->meshes = modelAsset->temporaryMeshes;
         modelAsset->temporaryMeshes.clear();
 
+        modelAsset->animation = modelAsset->temporaryAnimation;
+        modelAsset->temporaryAnimation.reset();
+
         for(const auto& mesh : modelAsset->meshes)
             mesh->SetupBuffers();
 
         modelAsset->loaded = true;
 
-        EventManager::Get().Dispatch(std::make_unique<AssetLoadedEvent>(modelAsset));
+        EventBus::Get().Publish(AssetLoadedEvent(modelAsset));
     };
 
     if(async)
@@ -66,10 +169,11 @@ void ModelLoader::LoadDefaultData()
 
 void ModelLoader::ImportModel(const std::filesystem::path& path, const ModelAssetPtr& modelAsset)
 {
-    constexpr auto flags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenBoundingBoxes | aiProcess_LimitBoneWeights;
+    constexpr auto flags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenBoundingBoxes
+                         | aiProcess_LimitBoneWeights | aiProcess_JoinIdenticalVertices;
 
     Assimp::Importer importer;
-    importer.SetPropertyInteger(AI_CONFIG_PP_LBW_MAX_WEIGHTS, 1);
+    importer.SetPropertyInteger(AI_CONFIG_PP_LBW_MAX_WEIGHTS, 4); // As many as VertexSkin has
 
     const auto scene = importer.ReadFile(path.string(), flags);
 
@@ -86,25 +190,50 @@ void ModelLoader::ImportModel(const std::filesystem::path& path, const ModelAsse
     modelAsset->meshes.reserve(scene->mNumMeshes);
     modelAsset->temporaryMeshes.reserve(scene->mNumMeshes);
 
-    ProcessNode(scene->mRootNode, scene, modelAsset);
+    MeshOptimizer::Statistics statistics;
+
+    modelAsset->temporaryAnimation = ProcessAnimations(scene);
+
+    const auto skeleton = modelAsset->temporaryAnimation ? &modelAsset->temporaryAnimation->skeleton : nullptr;
+
+    ProcessNode(scene->mRootNode, scene, modelAsset, skeleton, statistics);
 
     LLGL::Log::Printf(
         LLGL::Log::ColorFlags::Bold | LLGL::Log::ColorFlags::Green,
         "Model \"%s\" loaded.\n",
         path.string().c_str()
     );
+
+    LLGL::Log::Printf(
+        "Optimized: ACMR %.3f -> %.3f, %zu -> %zu vertices, %zu triangles, %zu LODs\n",
+        statistics.GetACMR(), statistics.GetOptimizedACMR(),
+        statistics.vertices, statistics.optimizedVertices,
+        statistics.triangles, statistics.lods
+    );
+
+    if(skeleton)
+        LLGL::Log::Printf(
+            "Skinned: %zu joints, %zu animations\n",
+            skeleton->joints.size(), modelAsset->temporaryAnimation->animations.size()
+        );
 }
 
-void ModelLoader::ProcessNode(const aiNode* node, const aiScene* scene, const ModelAssetPtr& modelAsset)
+void ModelLoader::ProcessNode(
+    const aiNode* node,
+    const aiScene* scene,
+    const ModelAssetPtr& modelAsset,
+    const Skeleton* skeleton,
+    MeshOptimizer::Statistics& statistics
+)
 {
     for(uint32_t i = 0; i < node->mNumMeshes; i++)
-        modelAsset->temporaryMeshes.push_back(ProcessMesh(scene->mMeshes[node->mMeshes[i]], scene));
+        modelAsset->temporaryMeshes.push_back(ProcessMesh(scene->mMeshes[node->mMeshes[i]], scene, skeleton, statistics));
 
     for(unsigned int i = 0; i < scene->mNumMaterials; i++)
         ProcessMaterial(scene->mMaterials[i], modelAsset);
 
     for(uint32_t i = 0; i < node->mNumChildren; i++)
-        ProcessNode(node->mChildren[i], scene, modelAsset);
+        ProcessNode(node->mChildren[i], scene, modelAsset, skeleton, statistics);
 }
 
 void ModelLoader::ProcessMaterial(aiMaterial* material, const ModelAssetPtr& modelAsset)
@@ -112,10 +241,15 @@ void ModelLoader::ProcessMaterial(aiMaterial* material, const ModelAssetPtr& mod
     // TODO ...
 }
 
-MeshPtr ModelLoader::ProcessMesh(const aiMesh* mesh, const aiScene* scene)
+MeshPtr ModelLoader::ProcessMesh(
+    const aiMesh* mesh,
+    const aiScene* scene,
+    const Skeleton* skeleton,
+    MeshOptimizer::Statistics& statistics
+)
 {
     std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    std::vector<uint32_t> indices;
 
     for(unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
@@ -140,7 +274,199 @@ MeshPtr ModelLoader::ProcessMesh(const aiMesh* mesh, const aiScene* scene)
             indices.push_back(face.mIndices[j]);
     }
 
-    return std::make_shared<Mesh>(vertices, indices, false);
+    std::vector<VertexSkin> skin;
+
+    if(skeleton && mesh->HasBones())
+    {
+        skin.resize(mesh->mNumVertices);
+
+        std::vector<glm::vec4> weights(mesh->mNumVertices, glm::vec4(0.0f));
+
+        for(uint32_t i = 0; i < mesh->mNumBones; i++)
+        {
+            const auto bone = mesh->mBones[i];
+            const auto joint = skeleton->Find(bone->mName.C_Str());
+
+            if(joint < 0)
+                continue;
+
+            // The weakest influence is replaced if there are more than 4
+            for(uint32_t j = 0; j < bone->mNumWeights; j++)
+            {
+                const auto& [vertexId, weight] = bone->mWeights[j];
+
+                auto& vertexWeights = weights[vertexId];
+
+                int slot = 0;
+
+                for(int k = 1; k < 4; k++)
+                    if(vertexWeights[k] < vertexWeights[slot])
+                        slot = k;
+
+                if(weight > vertexWeights[slot])
+                {
+                    vertexWeights[slot] = weight;
+                    skin[vertexId].joints[slot] = static_cast<uint8_t>(joint);
+                }
+            }
+        }
+
+        for(size_t i = 0; i < skin.size(); i++)
+        {
+            const auto sum = weights[i].x + weights[i].y + weights[i].z + weights[i].w;
+
+            // Follows the root if nothing moves it
+            if(sum <= 0.0f)
+            {
+                skin[i] = { { 0, 0, 0, 0 }, { 255, 0, 0, 0 } };
+                continue;
+            }
+
+            int total = 0, strongest = 0;
+
+            for(int k = 0; k < 4; k++)
+            {
+                skin[i].weights[k] = static_cast<uint8_t>(std::lround(weights[i][k] / sum * 255.0f));
+                total += skin[i].weights[k];
+
+                if(weights[i][k] > weights[i][strongest])
+                    strongest = k;
+            }
+
+            // Rounding mustn't make the vertex shrink or grow
+            skin[i].weights[strongest] = static_cast<uint8_t>(skin[i].weights[strongest] + 255 - total);
+        }
+    }
+
+    std::vector<Mesh::Lod> lods;
+
+    // Meshes with lines or points would have to be split by primitive type first
+    if(mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+    {
+        statistics += MeshOptimizer::Optimize(vertices, indices, skin.empty() ? nullptr : &skin);
+
+        lods = MeshOptimizer::GenerateLods(vertices, indices);
+        statistics.lods += lods.size();
+    }
+
+    auto result = std::make_shared<Mesh>(vertices, indices, false, true);
+    result->SetLods(std::move(lods));
+    result->SetSkin(std::move(skin));
+
+    return result;
+}
+
+AnimationAssetPtr ModelLoader::ProcessAnimations(const aiScene* scene)
+{
+    std::unordered_map<std::string, glm::mat4> bones; // Inverse bind matrices
+
+    for(uint32_t i = 0; i < scene->mNumMeshes; i++)
+        for(uint32_t j = 0; j < scene->mMeshes[i]->mNumBones; j++)
+        {
+            const auto bone = scene->mMeshes[i]->mBones[j];
+
+            bones[bone->mName.C_Str()] = ToGlm(bone->mOffsetMatrix);
+        }
+
+    if(bones.empty())
+        return nullptr;
+
+    std::unordered_set<const aiNode*> joints;
+
+    CollectJoints(scene->mRootNode, bones, joints);
+
+    auto asset = std::make_shared<AnimationAsset>();
+    auto& skeleton = asset->skeleton;
+
+    std::vector<Animation::Keyframe> restPose;
+
+    AddJoints(scene->mRootNode, -1, bones, joints, skeleton, restPose);
+
+    if(skeleton.joints.size() > Matrices::maxJoints)
+    {
+        LLGL::Log::Errorf(
+            LLGL::Log::ColorFlags::StdError,
+            "Skeleton has %zu joints, only %u are supported, the model won't be animated\n",
+            skeleton.joints.size(), Matrices::maxJoints
+        );
+
+        return nullptr;
+    }
+
+    skeleton.globalInverse = glm::inverse(ToGlm(scene->mRootNode->mTransformation));
+
+    skeleton.restPose.Resize(restPose.size());
+
+    for(size_t i = 0; i < restPose.size(); i++)
+    {
+        for(int c = 0; c < 3; c++)
+        {
+            skeleton.restPose.translation[c][i] = restPose[i].translation[c];
+            skeleton.restPose.scale[c][i] = restPose[i].scale[c];
+        }
+
+        for(int c = 0; c < 4; c++)
+            skeleton.restPose.rotation[c][i] = restPose[i].rotation[c];
+    }
+
+    for(uint32_t i = 0; i < scene->mNumAnimations; i++)
+        asset->animations.push_back(ProcessAnimation(scene->mAnimations[i], skeleton));
+
+    return asset;
+}
+
+Animation ModelLoader::ProcessAnimation(const aiAnimation* animation, const Skeleton& skeleton)
+{
+    const auto ticksPerSecond = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : 25.0;
+    const auto duration = static_cast<float>(animation->mDuration / ticksPerSecond);
+    const auto frameCount = static_cast<size_t>(std::ceil(duration * Animation::sampleRate)) + 1;
+
+    std::vector<const aiNodeAnim*> channels(skeleton.joints.size(), nullptr);
+
+    for(uint32_t i = 0; i < animation->mNumChannels; i++)
+    {
+        const auto joint = skeleton.Find(animation->mChannels[i]->mNodeName.C_Str());
+
+        if(joint >= 0)
+            channels[joint] = animation->mChannels[i];
+    }
+
+    std::vector<std::vector<Animation::Keyframe>> tracks(skeleton.joints.size());
+
+    for(size_t joint = 0; joint < tracks.size(); joint++)
+    {
+        const auto& rest = skeleton.restPose;
+        const auto channel = channels[joint];
+
+        tracks[joint].reserve(frameCount);
+
+        for(size_t frame = 0; frame < frameCount; frame++)
+        {
+            Animation::Keyframe keyframe =
+            {
+                .timestamp = std::min(static_cast<float>(frame) / Animation::sampleRate, duration),
+                .translation = { rest.translation[0][joint], rest.translation[1][joint], rest.translation[2][joint] },
+                .rotation = { rest.rotation[3][joint], rest.rotation[0][joint], rest.rotation[1][joint], rest.rotation[2][joint] },
+                .scale = { rest.scale[0][joint], rest.scale[1][joint], rest.scale[2][joint] }
+            };
+
+            if(channel)
+            {
+                const auto ticks = keyframe.timestamp * ticksPerSecond;
+
+                if(channel->mNumPositionKeys)
+                    keyframe.translation = InterpolateKeys(channel->mPositionKeys, channel->mNumPositionKeys, ticks);
+                if(channel->mNumRotationKeys)
+                    keyframe.rotation = InterpolateKeys(channel->mRotationKeys, channel->mNumRotationKeys, ticks);
+                if(channel->mNumScalingKeys)
+                    keyframe.scale = InterpolateKeys(channel->mScalingKeys, channel->mNumScalingKeys, ticks);
+            }
+
+            tracks[joint].push_back(keyframe);
+        }
+    }
+
+    return { animation->mName.C_Str(), duration, tracks };
 }
 
 }
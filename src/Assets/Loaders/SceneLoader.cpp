@@ -1,5 +1,6 @@
 #include <Serialize.hpp>
 #include <SceneLoader.hpp>
+#include <EventBus.hpp>
 
 #include <cereal/types/string.hpp>
 #include <cereal/archives/json.hpp>
@@ -40,7 +41,7 @@ AssetPtr SceneLoader::Load(
 
     asset->loaded = true;
 
-    EventManager::Get().Dispatch(std::make_unique<AssetLoadedEvent>(asset));
+    EventBus::Get().Publish(AssetLoadedEvent(asset));
 
     LLGL::Log::Printf(
         LLGL::Log::ColorFlags::Bold | LLGL::Log::ColorFlags::Green,
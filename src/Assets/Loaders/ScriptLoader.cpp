@@ -1,5 +1,5 @@
 #include <ScriptLoader.hpp>
-#include <EventManager.hpp>
+#include <EventBus.hpp>
 
 namespace lustra
 {
@@ -16,7 +16,7 @@ AssetPtr ScriptLoader::Load(
 
     asset->loaded = true;
 
-    EventManager::Get().Dispatch(std::make_unique<AssetLoadedEvent>(asset));
+    EventBus::Get().Publish(AssetLoadedEvent(asset));
 
     return asset;
 }
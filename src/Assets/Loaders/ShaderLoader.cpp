@@ -1,57 +1,93 @@
 #include <ShaderLoader.hpp>
-#include <EventManager.hpp>
+#include <EventBus.hpp>
+#include <Multithreading.hpp>
 
 namespace lustra
 {
 
-AssetPtr VertexShaderLoader::Load(
+// The first load is synchronous, the callers build their pipelines right after Load.
+// On reload the source is read on a worker thread and compiled on the main one, the previous
+// shader keeps being used until then and stays if the new one doesn't compile
+template<class T>
+static AssetPtr LoadShader(
+    const LLGL::ShaderType type,
     const std::filesystem::path& path,
-    const AssetPtr existing,
-    bool async
+    const AssetPtr& existing,
+    const bool async
 )
 {
-    auto shader = Renderer::Get().CreateShader(LLGL::ShaderType::Vertex, path);
+    if(!existing)
+    {
+        auto asset = std::make_shared<T>(Renderer::Get().CreateShader(type, path));
+
+        asset->loaded = true;
+
+        EventBus::Get().Publish(AssetLoadedEvent(asset));
+
+        return asset;
+    }
+
+    auto asset = std::static_pointer_cast<T>(existing);
+    auto source = std::make_shared<std::string>();
 
-    auto asset = existing
-        ? std::static_pointer_cast<VertexShaderAsset>(existing)
-        : std::make_shared<VertexShaderAsset>(shader);
+    auto read = [source, path]()
+    {
+        *source = Renderer::ReadShaderSource(path);
+    };
 
-    if(existing)
+    auto compile = [asset, source, path, type]()
     {
+        if(source->empty())
+            return;
+
+        const auto shader = Renderer::Get().CreateShaderFromSource(type, *source, path.filename().string());
+
+        if(const LLGL::Report* report = shader->GetReport(); report && report->HasErrors())
+        {
+            LLGL::Log::Errorf(
+                LLGL::Log::ColorFlags::StdError,
+                "Keeping the previous version of %s\n",
+                path.filename().string().c_str()
+            );
+
+            Renderer::Get().Release(shader);
+
+            return;
+        }
+
         Renderer::Get().Release(asset->shader);
         asset->shader = shader;
-    }
 
-    asset->loaded = true;
+        EventBus::Get().Publish(AssetLoadedEvent(asset));
+    };
 
-    EventManager::Get().Dispatch(std::make_unique<AssetLoadedEvent>(asset));
+    if(async)
+        Multithreading::Get().AddJob({ read, compile });
+    else
+    {
+        read();
+        compile();
+    }
 
     return asset;
 }
 
-AssetPtr FragmentShaderLoader::Load(
+AssetPtr VertexShaderLoader::Load(
     const std::filesystem::path& path,
     const AssetPtr existing,
     bool async
 )
 {
-    auto shader = Renderer::Get().CreateShader(LLGL::ShaderType::Fragment, path);
-
-    auto asset = existing
-        ? std::static_pointer_cast<FragmentShaderAsset>(existing)
-        : std::make_shared<FragmentShaderAsset>(shader);
-
-    if(existing)
-    {
-        Renderer::Get().Release(asset->shader);
-        asset->shader = shader;
-    }
-
-    asset->loaded = true;
-
-    EventManager::Get().Dispatch(std::make_unique<AssetLoadedEvent>(asset));
+    return LoadShader<VertexShaderAsset>(LLGL::ShaderType::Vertex, path, existing, async);
+}
 
-    return asset;
+AssetPtr FragmentShaderLoader::Load(
+    const std::filesystem::path& path,
+    const AssetPtr existing,
+    bool async
+)
+{
+    return LoadShader<FragmentShaderAsset>(LLGL::ShaderType::Fragment, path, existing, async);
 }
 
 }
@@ -1,5 +1,5 @@
 #include <TextureLoader.hpp>
-#include <EventManager.hpp>
+#include <EventBus.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -90,7 +90,7 @@ AssetPtr TextureLoader::Load(
 
             textureAsset->loaded = true;
 
-            EventManager::Get().Dispatch(std::make_unique<AssetLoadedEvent>(textureAsset));
+            EventBus::Get().Publish(AssetLoadedEvent(textureAsset));
         }
 
         stbi_image_free(const_cast<void*>(textureAsset->imageView.data));
@@ -1,11 +1,15 @@
 #include <AudioManager.hpp>
 #include <LLGL/Log.h>
 
+#include <algorithm>
+
 namespace lustra
 {
 
 AudioManager::~AudioManager()
 {
+    voices.clear();
+
     ma_engine_uninit(&engine);
 }
 
@@ -27,6 +31,10 @@ void AudioManager::Init()
 
 void AudioManager::RemoveSound(Sound& sound)
 {
+    StopInstances(sound);
+
+    sources.erase(sound.GetHandle());
+
     ma_sound_uninit(sound.GetSound().get());
 }
 
@@ -42,16 +50,29 @@ Sound AudioManager::LoadSound(const std::filesystem::path& path)
         return {};
     }
 
+    std::error_code error;
+    const auto fileSize = std::filesystem::file_size(path, error);
+
+    // Long music and ambience is streamed instead of being fully decoded into memory
+    const bool streamed = !error && fileSize >= streamingThreshold;
+    const ma_uint32 flags = streamed ? MA_SOUND_FLAG_STREAM : MA_SOUND_FLAG_DECODE | MA_SOUND_FLAG_ASYNC;
+
     Sound sound;
-    result = ma_sound_init_from_file(&engine, path.string().c_str(), 0, nullptr, nullptr, sound.GetSound().get());
+    result = ma_sound_init_from_file(&engine, path.string().c_str(), flags, nullptr, nullptr, sound.GetSound().get());
 
     if(result != MA_SUCCESS)
+    {
         LLGL::Log::Errorf(
             LLGL::Log::ColorFlags::StdError,
             "Failed to load sound %s\n",
             path.string().c_str()
         );
 
+        return sound;
+    }
+
+    sources[sound.GetHandle()] = { .sound = sound.GetSound(), .path = path, .streamed = streamed };
+
     return sound;
 }
 
@@ -68,7 +89,12 @@ Sound AudioManager::CopySound(Sound& sound)
     }
 
     Sound newSound;
-    result = ma_sound_init_copy(&engine, sound.GetSound().get(), 0, nullptr, newSound.GetSound().get());
+
+    // Streams can't be copied, open the file once more instead
+    if(const auto source = FindSource(sound); source && source->streamed)
+        result = ma_sound_init_from_file(&engine, source->path.string().c_str(), MA_SOUND_FLAG_STREAM, nullptr, nullptr, newSound.GetSound().get());
+    else
+        result = ma_sound_init_copy(&engine, sound.GetSound().get(), 0, nullptr, newSound.GetSound().get());
 
     if(result != MA_SUCCESS)
         LLGL::Log::Errorf(
@@ -79,9 +105,243 @@ Sound AudioManager::CopySound(Sound& sound)
     return newSound;
 }
 
+bool AudioManager::PlayInstance(Sound& sound)
+{
+    if(!initialized)
+        return false;
+
+    const auto source = FindSource(sound);
+    const auto handle = sound.GetHandle();
+
+    const int priority = source ? source->priority : 0;
+    const uint32_t maxInstances = source ? source->maxInstances : defaultMaxInstances;
+
+    Voice* target = nullptr;
+
+    uint32_t playing = 0, instances = 0;
+    Voice* oldestInstance = nullptr;
+    Voice* idleSameSource = nullptr;
+    Voice* idle = nullptr;
+    Voice* victim = nullptr;
+
+    for(auto& voice : voices)
+    {
+        if(IsPlaying(voice))
+        {
+            playing++;
+
+            if(voice.source == handle)
+            {
+                instances++;
+
+                if(!oldestInstance || voice.order < oldestInstance->order)
+                    oldestInstance = &voice;
+            }
+
+            // The lowest priority loses, the oldest one among equals
+            if(!victim || voice.priority < victim->priority
+               || (voice.priority == victim->priority && voice.order < victim->order))
+                victim = &voice;
+        }
+        else if(voice.source == handle)
+            idleSameSource = &voice;
+        else
+            idle = &voice;
+    }
+
+    if(instances >= maxInstances && oldestInstance)
+        target = oldestInstance; // Restart the oldest instance of this sound
+    else if(playing < maxVoices)
+        target = idleSameSource ? idleSameSource : idle;
+    else if(victim && victim->priority <= priority)
+        target = victim;
+    else
+        return false;
+
+    if(!target)
+    {
+        if(voices.size() >= maxVoices)
+            return false;
+
+        Voice voice;
+
+        if(!InitVoice(voice, sound, source))
+        {
+            voice.sound.Detach();
+            return false;
+        }
+
+        target = &voices.emplace_back(std::move(voice));
+    }
+    else if(target->source != handle)
+    {
+        // Reuse the voice of another sound
+        ma_sound_uninit(target->sound.GetHandle());
+
+        if(!InitVoice(*target, sound, source))
+        {
+            // Already uninitialized above, the destructor mustn't do it again
+            target->sound.Detach();
+
+            voices.erase(voices.begin() + (target - voices.data()));
+            return false;
+        }
+    }
+    else
+        ma_sound_seek_to_pcm_frame(target->sound.GetHandle(), 0);
+
+    target->priority = priority;
+    target->order = voiceOrder++;
+
+    CopyParameters(sound, target->sound);
+
+    ma_sound_start(target->sound.GetHandle());
+
+    return true;
+}
+
+void AudioManager::StopInstances(Sound& sound)
+{
+    const auto handle = sound.GetHandle();
+
+    for(auto& voice : voices)
+        if(voice.source == handle)
+            voice.sound.Stop();
+}
+
+void AudioManager::SetInstanceLimit(const Sound& sound, const uint32_t limit)
+{
+    if(const auto source = FindSource(sound))
+        source->maxInstances = std::max(limit, 1u);
+}
+
+void AudioManager::SetPriority(const Sound& sound, const int priority)
+{
+    if(const auto source = FindSource(sound))
+        source->priority = priority;
+}
+
+void AudioManager::SetMaxVoices(const uint32_t maxVoices)
+{
+    this->maxVoices = maxVoices;
+
+    if(voices.size() > maxVoices)
+    {
+        // Drop the oldest voices
+        std::ranges::sort(voices, std::ranges::greater{}, &Voice::order);
+        voices.resize(maxVoices);
+    }
+}
+
+void AudioManager::SetStreamingThreshold(const uintmax_t bytes)
+{
+    streamingThreshold = bytes;
+}
+
+void AudioManager::SetEmitterStats(const uint32_t real, const uint32_t virtualized)
+{
+    emitterStats = { real, virtualized };
+}
+
+bool AudioManager::IsStreamed(const Sound& sound) const
+{
+    const auto source = FindSource(sound);
+
+    return source && source->streamed;
+}
+
+int AudioManager::GetPriority(const Sound& sound) const
+{
+    const auto source = FindSource(sound);
+
+    return source ? source->priority : 0;
+}
+
+uint32_t AudioManager::GetMaxVoices() const
+{
+    return maxVoices;
+}
+
+uint32_t AudioManager::GetPlayingVoiceCount() const
+{
+    return static_cast<uint32_t>(std::ranges::count_if(voices, IsPlaying));
+}
+
+AudioManager::VoiceStats AudioManager::GetVoiceStats() const
+{
+    return { emitterStats.real + GetPlayingVoiceCount(), emitterStats.virtualized };
+}
+
 ma_engine* AudioManager::GetEngine()
 {
     return &engine;
 }
 
+AudioManager::Source* AudioManager::FindSource(const Sound& sound)
+{
+    const auto it = sources.find(sound.GetHandle());
+
+    if(it == sources.end())
+        return nullptr;
+
+    // The address might belong to a sound that was already destroyed
+    if(it->second.sound.expired())
+    {
+        sources.erase(it);
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+const AudioManager::Source* AudioManager::FindSource(const Sound& sound) const
+{
+    const auto it = sources.find(sound.GetHandle());
+
+    return it == sources.end() || it->second.sound.expired() ? nullptr : &it->second;
+}
+
+bool AudioManager::InitVoice(Voice& voice, Sound& sound, const Source* source)
+{
+    if(source && source->streamed)
+        result = ma_sound_init_from_file(&engine, source->path.string().c_str(), MA_SOUND_FLAG_STREAM, nullptr, nullptr, voice.sound.GetHandle());
+    else
+        result = ma_sound_init_copy(&engine, sound.GetHandle(), 0, nullptr, voice.sound.GetHandle());
+
+    if(result != MA_SUCCESS)
+    {
+        LLGL::Log::Errorf(
+            LLGL::Log::ColorFlags::StdError,
+            "Failed to create a voice\n"
+        );
+
+        return false;
+    }
+
+    voice.source = sound.GetHandle();
+
+    return true;
+}
+
+void AudioManager::CopyParameters(const Sound& from, const Sound& to)
+{
+    to.SetVolume(from.GetVolume());
+    to.SetPitch(from.GetPitch());
+    to.SetPan(from.GetPan());
+    to.SetLooping(false);
+
+    to.SetSpatializationEnabled(from.IsSpatializationEnabled());
+    to.SetPosition(from.GetPosition());
+    to.SetDirection(from.GetDirection());
+    to.SetVelocity(from.GetVelocity());
+    to.SetRolloff(from.GetRolloff());
+    to.SetMinDistance(from.GetMinDistance());
+    to.SetMaxDistance(from.GetMaxDistance());
+}
+
+bool AudioManager::IsPlaying(const Voice& voice)
+{
+    return ma_sound_is_playing(voice.sound.GetHandle());
+}
+
 }
@@ -1,4 +1,5 @@
 #include <Sound.hpp>
+#include <AudioManager.hpp>
 
 #include <glm/gtc/quaternion.hpp>
 
@@ -27,6 +28,28 @@ void Sound::Play() const
 void Sound::Stop() const
 {
     ma_sound_stop(sound.get());
+
+    stopCount++;
+}
+
+bool Sound::PlayInstance()
+{
+    return AudioManager::Get().PlayInstance(*this);
+}
+
+void Sound::StopInstances()
+{
+    AudioManager::Get().StopInstances(*this);
+}
+
+void Sound::SetPriority(const int priority) const
+{
+    AudioManager::Get().SetPriority(*this, priority);
+}
+
+void Sound::SetInstanceLimit(const uint32_t limit) const
+{
+    AudioManager::Get().SetInstanceLimit(*this, limit);
 }
 
 void Sound::SetPosition(const glm::vec3& position) const
@@ -235,9 +258,29 @@ bool Sound::IsSpatializationEnabled() const
     return ma_sound_is_spatialization_enabled(sound.get());
 }
 
+bool Sound::IsPlaying() const
+{
+    return ma_sound_is_playing(sound.get());
+}
+
+uint32_t Sound::GetStopCount() const
+{
+    return stopCount;
+}
+
 std::shared_ptr<ma_sound> Sound::GetSound()
 {
     return sound;
 }
 
+ma_sound* Sound::GetHandle() const
+{
+    return sound.get();
+}
+
+void Sound::Detach()
+{
+    sound.reset();
+}
+
 }
@@ -8,11 +8,7 @@ BloomComponent::BloomComponent(const LLGL::Extent2D& resolution)
 {
     EventManager::Get().AddListener(Event::Type::WindowResize, this);
 
-    const LLGL::Extent2D scaledResolution =
-    {
-        static_cast<uint32_t>(static_cast<float>(resolution.width) / resolutionScale),
-        static_cast<uint32_t>(static_cast<float>(resolution.height) / resolutionScale)
-    };
+    const auto scaledResolution = GetScaledResolution();
 
     LLGL::PipelineLayoutDescriptor pingPongLayout =
     {
@@ -42,7 +38,6 @@ BloomComponent::BloomComponent(const LLGL::Extent2D& resolution)
         AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
         AssetManager::Get().Load<FragmentShaderAsset>("threshold.frag", true),
         scaledResolution,
-        true,
         false
     );
 
@@ -51,7 +46,6 @@ BloomComponent::BloomComponent(const LLGL::Extent2D& resolution)
         AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
         AssetManager::Get().Load<FragmentShaderAsset>("blur.frag", true),
         scaledResolution,
-        true,
         false
     );
 
@@ -60,7 +54,46 @@ BloomComponent::BloomComponent(const LLGL::Extent2D& resolution)
         AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
         AssetManager::Get().Load<FragmentShaderAsset>("blur.frag", true),
         scaledResolution,
-        true,
+        false
+    );
+
+    downsample = std::make_shared<PostProcessing>(
+        LLGL::PipelineLayoutDescriptor
+        {
+            .bindings =
+            {
+                { "frame", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 1 },
+                { "samplerState", LLGL::ResourceType::Sampler, 0, LLGL::StageFlags::FragmentStage, 1 }
+            },
+            .uniforms =
+            {
+                { "karisAverage", LLGL::UniformType::Bool1 }
+            }
+        },
+        AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
+        AssetManager::Get().Load<FragmentShaderAsset>("bloomDownsample.frag", true),
+        scaledResolution,
+        false
+    );
+
+    upsample = std::make_shared<PostProcessing>(
+        LLGL::PipelineLayoutDescriptor
+        {
+            .bindings =
+            {
+                { "frame", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 1 },
+                { "current", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 },
+                { "samplerState", LLGL::ResourceType::Sampler, 0, LLGL::StageFlags::FragmentStage, 1 }
+            },
+            .uniforms =
+            {
+                { "filterRadius", LLGL::UniformType::Float1 },
+                { "weight", LLGL::UniformType::Float1 }
+            }
+        },
+        AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
+        AssetManager::Get().Load<FragmentShaderAsset>("bloomUpsample.frag", true),
+        scaledResolution,
         false
     );
 
@@ -81,8 +114,9 @@ BloomComponent::BloomComponent(const LLGL::Extent2D& resolution)
 BloomComponent::BloomComponent(BloomComponent&& other) noexcept
     : ComponentBase("BloomComponent"),
       threshold(other.threshold), strength(other.strength), resolutionScale(other.resolutionScale),
+      mipChain(other.mipChain), mipCount(other.mipCount), filterRadius(other.filterRadius),
       resolution(other.resolution), sampler(other.sampler), thresholdPass(std::move(other.thresholdPass)),
-      pingPong(std::move(other.pingPong))
+      pingPong(std::move(other.pingPong)), downsample(std::move(other.downsample)), upsample(std::move(other.upsample))
 {
     EventManager::Get().AddListener(Event::Type::WindowResize, this);
 
@@ -97,19 +131,10 @@ BloomComponent::~BloomComponent()
     EventManager::Get().RemoveListener(Event::Type::WindowResize, this);
 }
 
-void BloomComponent::SetupPostProcessing() const
+void BloomComponent::SetupPostProcessing()
 {
-    const LLGL::Extent2D scaledResolution =
-    {
-        static_cast<uint32_t>(static_cast<float>(resolution.width) / resolutionScale),
-        static_cast<uint32_t>(static_cast<float>(resolution.height) / resolutionScale)
-    };
-
-    WindowResizeEvent newEvent(scaledResolution);
-
-    thresholdPass->OnEvent(newEvent);
-    pingPong[0]->OnEvent(newEvent);
-    pingPong[1]->OnEvent(newEvent);
+    // Every texture of the bloom is a transient one of the render graph,
+    // it's sized by the current settings every frame, so there's nothing to recreate
 }
 
 void BloomComponent::OnEvent(Event& event)
@@ -124,4 +149,15 @@ void BloomComponent::OnEvent(Event& event)
     }
 }
 
+LLGL::Extent2D BloomComponent::GetScaledResolution() const
+{
+    const float scale = mipChain ? 2.0f : resolutionScale;
+
+    return
+    {
+        std::max(static_cast<uint32_t>(static_cast<float>(resolution.width) / scale), 1u),
+        std::max(static_cast<uint32_t>(static_cast<float>(resolution.height) / scale), 1u)
+    };
+}
+
 }
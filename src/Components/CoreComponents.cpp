@@ -45,82 +45,10 @@ void LightComponent::SetupProjection()
 
 void LightComponent::SetupShadowMap(const LLGL::Extent2D& resolution)
 {
-    if(depth)
-    {
-        Renderer::Get().Release(depth);
-        Renderer::Get().Release(renderTarget);
-    }
-
-    CreateDepth(resolution);
-    CreateRenderTarget(resolution);
+    // The shadow is rendered into the atlas, there's nothing to create here
+    this->resolution = resolution;
 
     SetupProjection();
-
-    if(!shadowMapPipeline)
-        CreatePipeline();
-}
-
-void LightComponent::CreateDepth(const LLGL::Extent2D& resolution)
-{
-    const LLGL::TextureDescriptor depthDesc =
-    {
-        .type = LLGL::TextureType::Texture2D,
-        .bindFlags = LLGL::BindFlags::DepthStencilAttachment | LLGL::BindFlags::Sampled,
-        .format = LLGL::Format::D32Float,
-        .extent = { resolution.width, resolution.height, 1 },
-        .mipLevels = 1,
-        .samples = 1
-    };
-
-    depth = Renderer::Get().CreateTexture(depthDesc);
-}
-
-void LightComponent::CreateRenderTarget(const LLGL::Extent2D& resolution)
-{
-    renderTarget = Renderer::Get().CreateRenderTarget(resolution, {}, depth);
-}
-
-void LightComponent::CreatePipeline()
-{
-    shadowMapPipeline = Renderer::Get().CreatePipelineState(
-        LLGL::PipelineLayoutDescriptor
-        {
-            .bindings =
-            {
-                { "matrices", LLGL::ResourceType::Buffer, LLGL::BindFlags::ConstantBuffer, LLGL::StageFlags::VertexStage, 1 }
-            }
-        },
-        LLGL::GraphicsPipelineDescriptor
-        {
-            .renderPass = renderTarget->GetRenderPass(),
-            .vertexShader = AssetManager::Get().Load<VertexShaderAsset>("depth.vert", true)->shader,
-            .fragmentShader = AssetManager::Get().Load<FragmentShaderAsset>("depth.frag", true)->shader,
-            .depth = LLGL::DepthDescriptor
-            {
-                .testEnabled = true,
-                .writeEnabled = true
-            },
-            .rasterizer = LLGL::RasterizerDescriptor
-            {
-                .cullMode = LLGL::CullMode::Disabled, // Make it configurable in future?
-                .depthBias =
-                {
-                    .constantFactor = 4.0f,
-                    .slopeFactor = 1.5f
-                },
-                .frontCCW = true
-            },
-            .blend =
-            {
-                .targets =
-                {
-                    {
-                        .colorMask = 0x0
-                    }
-                }
-            }
-        }
-    );
 }
 
 }
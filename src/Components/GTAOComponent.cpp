@@ -8,11 +8,7 @@ GTAOComponent::GTAOComponent(const LLGL::Extent2D& resolution)
 {
     EventManager::Get().AddListener(Event::Type::WindowResize, this);
 
-    const LLGL::Extent2D scaledResolution =
-    {
-        static_cast<uint32_t>(static_cast<float>(resolution.width) / resolutionScale),
-        static_cast<uint32_t>(static_cast<float>(resolution.height) / resolutionScale)
-    };
+    const auto scaledResolution = GetScaledResolution();
 
     gtao = std::make_shared<PostProcessing>(
         LLGL::PipelineLayoutDescriptor
@@ -30,16 +26,15 @@ GTAOComponent::GTAOComponent(const LLGL::Extent2D& resolution)
                 { "radius", LLGL::UniformType::Float1 },
                 { "falloff", LLGL::UniformType::Float1 },
                 { "thicknessMix", LLGL::UniformType::Float1 },
-                { "maxStride", LLGL::UniformType::Float1 }
+                { "maxStride", LLGL::UniformType::Float1 },
+                { "temporalRotation", LLGL::UniformType::Float1 },
+                { "temporalOffset", LLGL::UniformType::Float1 }
             }
         },
         AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
         AssetManager::Get().Load<FragmentShaderAsset>("GTAO.frag", true),
         scaledResolution,
-        true,
-        false,
-        false,
-        LLGL::Format::R16Float
+        false
     );
 
     boxBlur = std::make_shared<PostProcessing>(
@@ -53,10 +48,58 @@ GTAOComponent::GTAOComponent(const LLGL::Extent2D& resolution)
         AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
         AssetManager::Get().Load<FragmentShaderAsset>("boxBlur.frag", true),
         scaledResolution,
-        true,
-        false,
-        false,
-        LLGL::Format::R16Float
+        false
+    );
+
+    const LLGL::PipelineLayoutDescriptor historyLayout =
+    {
+        .bindings =
+        {
+            { "frame", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 1 },
+            { "history", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 },
+            { "gDepth", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 3 }
+        },
+        .uniforms =
+        {
+            { "inverseViewProjection", LLGL::UniformType::Float4x4 },
+            { "previousViewProjection", LLGL::UniformType::Float4x4 },
+            { "far", LLGL::UniformType::Float1 },
+            { "near", LLGL::UniformType::Float1 },
+            { "historyWeight", LLGL::UniformType::Float1 },
+            { "historyValid", LLGL::UniformType::Bool1 }
+        }
+    };
+
+    for(auto& pass : history)
+        pass = std::make_shared<PostProcessing>(
+            historyLayout,
+            AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
+            AssetManager::Get().Load<FragmentShaderAsset>("GTAOTemporal.frag", true),
+            scaledResolution,
+            true,
+            false,
+            false,
+            LLGL::Format::RG16Float
+        );
+
+    upsample = std::make_shared<PostProcessing>(
+        LLGL::PipelineLayoutDescriptor
+        {
+            .bindings =
+            {
+                { "frame", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 1 },
+                { "gDepth", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 }
+            },
+            .uniforms =
+            {
+                { "far", LLGL::UniformType::Float1 },
+                { "near", LLGL::UniformType::Float1 }
+            }
+        },
+        AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
+        AssetManager::Get().Load<FragmentShaderAsset>("GTAOUpsample.frag", true),
+        resolution,
+        false
     );
 }
 
@@ -64,7 +107,10 @@ GTAOComponent::GTAOComponent(GTAOComponent&& other) noexcept
     : ComponentBase("GTAOComponent"),
       resolutionScale(other.resolutionScale), samples(other.samples), limit(other.limit),
       radius(other.radius), falloff(other.falloff), thicknessMix(other.thicknessMix), maxStride(other.maxStride),
-      resolution(other.resolution), gtao(std::move(other.gtao)), boxBlur(std::move(other.boxBlur))
+      temporal(other.temporal), historyWeight(other.historyWeight),
+      resolution(other.resolution), gtao(std::move(other.gtao)), boxBlur(std::move(other.boxBlur)),
+      history(std::move(other.history)), upsample(std::move(other.upsample)),
+      previousViewProjection(other.previousViewProjection), frameIndex(other.frameIndex), historyValid(other.historyValid)
 {
     EventManager::Get().AddListener(Event::Type::WindowResize, this);
 }
@@ -74,18 +120,15 @@ GTAOComponent::~GTAOComponent()
     EventManager::Get().RemoveListener(Event::Type::WindowResize, this);
 }
 
-void GTAOComponent::SetupPostProcessing() const
+void GTAOComponent::SetupPostProcessing()
 {
-    const LLGL::Extent2D scaledResolution =
-    {
-        static_cast<uint32_t>(static_cast<float>(resolution.width) / resolutionScale),
-        static_cast<uint32_t>(static_cast<float>(resolution.height) / resolutionScale)
-    };
+    // Only the history is kept between frames, the other passes write to the render graph's textures
+    WindowResizeEvent newEvent(GetScaledResolution());
 
-    WindowResizeEvent newEvent(scaledResolution);
+    history[0]->OnEvent(newEvent);
+    history[1]->OnEvent(newEvent);
 
-    gtao->OnEvent(newEvent);
-    boxBlur->OnEvent(newEvent);
+    historyValid = false;
 }
 
 void GTAOComponent::OnEvent(Event& event)
@@ -100,4 +143,13 @@ void GTAOComponent::OnEvent(Event& event)
     }
 }
 
+LLGL::Extent2D GTAOComponent::GetScaledResolution() const
+{
+    return
+    {
+        std::max(static_cast<uint32_t>(static_cast<float>(resolution.width) / resolutionScale), 1u),
+        std::max(static_cast<uint32_t>(static_cast<float>(resolution.height) / resolutionScale), 1u)
+    };
+}
+
 }
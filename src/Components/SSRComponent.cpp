@@ -8,11 +8,7 @@ SSRComponent::SSRComponent(const LLGL::Extent2D& resolution)
 {
     EventManager::Get().AddListener(Event::Type::WindowResize, this);
 
-    LLGL::Extent2D scaledResolution = 
-    {
-        (uint32_t)(resolution.width / resolutionScale),
-        (uint32_t)(resolution.height / resolutionScale)
-    };
+    const auto scaledResolution = GetScaledResolution();
 
     ssr = std::make_shared<PostProcessing>(
         LLGL::PipelineLayoutDescriptor
@@ -35,10 +31,63 @@ SSRComponent::SSRComponent(const LLGL::Extent2D& resolution)
         AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
         AssetManager::Get().Load<FragmentShaderAsset>("SSR.frag", true),
         scaledResolution,
-        true,
-        false,
-        true
+        false
+    );
+
+    hiZTrace = std::make_shared<PostProcessing>(
+        LLGL::PipelineLayoutDescriptor
+        {
+            .bindings =
+            {
+                { "matrices", LLGL::ResourceType::Buffer, LLGL::BindFlags::ConstantBuffer, LLGL::StageFlags::FragmentStage, 1 },
+                { "gNormal", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 },
+                { "gCombined", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 3 },
+                { "hiZ", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 4 },
+                { "frame", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 5 }
+            },
+            .uniforms =
+            {
+                { "maxSteps", LLGL::UniformType::Int1 },
+                { "levelCount", LLGL::UniformType::Int1 },
+                { "maxDistance", LLGL::UniformType::Float1 },
+                { "thickness", LLGL::UniformType::Float1 },
+                { "jitter", LLGL::UniformType::Float1 }
+            }
+        },
+        AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
+        AssetManager::Get().Load<FragmentShaderAsset>("SSRHiZ.frag", true),
+        scaledResolution,
+        false
     );
+
+    const LLGL::PipelineLayoutDescriptor historyLayout =
+    {
+        .bindings =
+        {
+            { "frame", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 1 },
+            { "history", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 },
+            { "gDepth", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 3 }
+        },
+        .uniforms =
+        {
+            { "inverseViewProjection", LLGL::UniformType::Float4x4 },
+            { "previousViewProjection", LLGL::UniformType::Float4x4 },
+            { "historyWeight", LLGL::UniformType::Float1 },
+            { "historyValid", LLGL::UniformType::Bool1 }
+        }
+    };
+
+    // The tonemapping pass picks the mip level by roughness, so the history has mips too
+    for(auto& pass : history)
+        pass = std::make_shared<PostProcessing>(
+            historyLayout,
+            AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
+            AssetManager::Get().Load<FragmentShaderAsset>("SSRTemporal.frag", true),
+            scaledResolution,
+            true,
+            false,
+            true
+        );
 }
 
 SSRComponent::SSRComponent(SSRComponent&& other) noexcept
@@ -48,7 +97,10 @@ SSRComponent::SSRComponent(SSRComponent&& other) noexcept
       maxSteps(other.maxSteps),
       maxBinarySearchSteps(other.maxBinarySearchSteps),
       rayStep(other.rayStep),
-      ssr(std::move(other.ssr))
+      hiZ(other.hiZ), maxDistance(other.maxDistance), thickness(other.thickness),
+      temporal(other.temporal), historyWeight(other.historyWeight),
+      ssr(std::move(other.ssr)), hiZTrace(std::move(other.hiZTrace)), history(std::move(other.history)),
+      previousViewProjection(other.previousViewProjection), frameIndex(other.frameIndex), historyValid(other.historyValid)
 {
     EventManager::Get().AddListener(Event::Type::WindowResize, this);
 }
@@ -60,15 +112,13 @@ SSRComponent::~SSRComponent()
 
 void SSRComponent::SetupPostProcessing()
 {
-    LLGL::Extent2D scaledResolution = 
-    {
-        (uint32_t)(resolution.width / resolutionScale),
-        (uint32_t)(resolution.height / resolutionScale)
-    };
+    // Only the history is kept between frames, the traced reflections are the render graph's textures
+    WindowResizeEvent newEvent(GetScaledResolution());
 
-    WindowResizeEvent newEvent(scaledResolution);
+    history[0]->OnEvent(newEvent);
+    history[1]->OnEvent(newEvent);
 
-    ssr->OnEvent(newEvent);
+    historyValid = false;
 }
 
 void SSRComponent::OnEvent(Event& event)
@@ -83,4 +133,13 @@ void SSRComponent::OnEvent(Event& event)
     }
 }
 
+LLGL::Extent2D SSRComponent::GetScaledResolution() const
+{
+    return
+    {
+        std::max(static_cast<uint32_t>(static_cast<float>(resolution.width) / resolutionScale), 1u),
+        std::max(static_cast<uint32_t>(static_cast<float>(resolution.height) / resolutionScale), 1u)
+    };
+}
+
 }
@@ -1,4 +1,5 @@
 #include <SkyComponents.hpp>
+#include <Hash.hpp>
 
 namespace lustra
 {
@@ -41,19 +42,53 @@ ProceduralSkyComponent::ProceduralSkyComponent(const LLGL::Extent2D& resolution)
 
     MakeSetUniforms();
 
-    Build();
+    BuildEnvironment(true);
 }
 
 ProceduralSkyComponent::ProceduralSkyComponent(ProceduralSkyComponent&& other)
     : ComponentBase("ProceduralSkyComponent"),
       time(other.time), cirrus(other.cirrus), cumulus(other.cumulus), flip(other.flip),
-      asset(std::move(other.asset)), resolution(other.resolution), pipeline(other.pipeline)
+      timeSliced(other.timeSliced), asset(std::move(other.asset)), resolution(other.resolution),
+      pipeline(other.pipeline), build(std::move(other.build)), rebuild(other.rebuild)
 {
+    other.build.reset();
+
     MakeSetUniforms();
 }
 
+ProceduralSkyComponent::~ProceduralSkyComponent()
+{
+    // The unfinished textures aren't referenced by the asset yet
+    if(build)
+        PBRManager::Get().Cancel(*build);
+}
+
 void ProceduralSkyComponent::Build()
 {
+    BuildEnvironment(false);
+}
+
+void ProceduralSkyComponent::BuildEnvironment(const bool cache)
+{
+    if(timeSliced && asset && asset->loaded)
+    {
+        // Restarting would never let a frequently updated sky finish
+        if(build)
+            rebuild = true;
+        else
+            BeginBuild();
+
+        return;
+    }
+
+    if(build)
+    {
+        PBRManager::Get().Cancel(*build);
+
+        build.reset();
+        rebuild = false;
+    }
+
     if(asset)
     {
         if(asset->loaded)
@@ -68,17 +103,51 @@ void ProceduralSkyComponent::Build()
 
     flip = 1;
 
+    const auto cacheKey = cache
+        ? Hash()
+            .Add(Renderer::Get().GetShaderHash(AssetManager::Get().Load<FragmentShaderAsset>("proceduralSky.frag", true)->shader))
+            .Add(time)
+            .Add(cirrus)
+            .Add(cumulus)
+            .Get()
+        : 0;
+
     asset = PBRManager::Get().Build(
         resolution,
         AssetManager::Get().Load<TextureAsset>("default", true),
         asset,
         pipeline,
-        setUniforms
+        setUniforms,
+        cacheKey
     );
 
     flip = 0;
 }
 
+void ProceduralSkyComponent::Update()
+{
+    if(!build || !PBRManager::Get().Step(*build))
+        return;
+
+    // The previous frame was the last one to use the old textures
+    Renderer::Get().Release(asset->cubeMap);
+    Renderer::Get().Release(asset->irradiance);
+    Renderer::Get().Release(asset->prefiltered);
+
+    asset->cubeMap = build->cubeMap;
+    asset->irradiance = build->irradiance;
+    asset->prefiltered = build->prefiltered;
+
+    build.reset();
+
+    if(rebuild)
+    {
+        rebuild = false;
+
+        BeginBuild();
+    }
+}
+
 void ProceduralSkyComponent::MakeSetUniforms()
 {
     setUniforms = [&](auto commandBuffer)
@@ -100,10 +169,29 @@ void ProceduralSkyComponent::DefaultTextures() const
     asset->brdf = defaultTexture;
 }
 
+void ProceduralSkyComponent::BeginBuild()
+{
+    // The parameters are copied, so the faces rendered in different frames match
+    build = PBRManager::Get().BeginBuild(
+        resolution,
+        AssetManager::Get().Load<TextureAsset>("default", true),
+        pipeline,
+        [time = time, cirrus = cirrus, cumulus = cumulus](auto commandBuffer)
+        {
+            constexpr int flip = 1;
+
+            commandBuffer->SetUniforms(0, &time, sizeof(time));
+            commandBuffer->SetUniforms(1, &cirrus, sizeof(cirrus));
+            commandBuffer->SetUniforms(2, &cumulus, sizeof(cumulus));
+            commandBuffer->SetUniforms(3, &flip, sizeof(flip));
+        }
+    );
+}
+
 HDRISkyComponent::HDRISkyComponent(const TextureAssetPtr& hdri, const LLGL::Extent2D& resolution)
     : ComponentBase("HDRISkyComponent"), environmentMap(hdri), resolution(resolution)
 {
-    EventManager::Get().AddListener(Event::Type::AssetLoaded, this);
+    Subscribe();
 
     SetupSkyPipeline();
 
@@ -122,23 +210,12 @@ HDRISkyComponent::HDRISkyComponent(HDRISkyComponent&& other)
       environmentMap(std::move(other.environmentMap)), asset(std::move(other.asset)),
       resolution(other.resolution), pipelineSky(other.pipelineSky)
 {
-    EventManager::Get().AddListener(Event::Type::AssetLoaded, this);
+    Subscribe();
 }
 
 HDRISkyComponent::~HDRISkyComponent()
 {
-    EventManager::Get().RemoveListener(Event::Type::AssetLoaded, this);
-}
-
-void HDRISkyComponent::OnEvent(Event& event)
-{
-    if(event.GetType() == Event::Type::AssetLoaded)
-    {
-        const auto assetLoadedEvent = static_cast<AssetLoadedEvent&>(event);
-
-        if(assetLoadedEvent.GetAsset() == environmentMap)
-            Build();
-    }
+    EventBus::Get().Unsubscribe(assetLoadedSubscription);
 }
 
 void HDRISkyComponent::Build()
@@ -155,7 +232,22 @@ void HDRISkyComponent::Build()
         }
     }
 
-    asset = PBRManager::Get().Build(resolution, environmentMap, asset);
+    // The file itself is only looked at, hashing a large HDRI would take longer than its time stamp
+    std::error_code sizeError, timeError;
+
+    const auto& path = environmentMap->path;
+    const auto size = std::filesystem::file_size(path, sizeError);
+    const auto writeTime = std::filesystem::last_write_time(path, timeError);
+
+    const auto cacheKey = sizeError || timeError
+        ? 0
+        : Hash()
+            .Add(path.generic_string())
+            .Add(size)
+            .Add(writeTime.time_since_epoch().count())
+            .Get();
+
+    asset = PBRManager::Get().Build(resolution, environmentMap, asset, nullptr, nullptr, cacheKey);
 }
 
 void HDRISkyComponent::SetupSkyPipeline()
@@ -198,4 +290,19 @@ void HDRISkyComponent::DefaultTextures() const
     asset->brdf = defaultTexture;
 }
 
+void HDRISkyComponent::Subscribe()
+{
+    assetLoadedSubscription = EventBus::Get().Subscribe<AssetLoadedEvent>(
+        [this](const auto events)
+        {
+            for(const auto& event : events)
+                if(event.GetAsset() == environmentMap)
+                {
+                    Build();
+                    break;
+                }
+        }
+    );
+}
+
 }
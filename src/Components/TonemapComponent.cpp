@@ -39,7 +39,6 @@ TonemapComponent::TonemapComponent(const LLGL::Extent2D& resolution)
         AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true),
         AssetManager::Get().Load<FragmentShaderAsset>("tonemap.frag", true),
         resolution,
-        true,
         false
     );
 
@@ -74,9 +73,8 @@ void TonemapComponent::OnEvent(Event& event)
     {
         auto windowResizeEvent = static_cast<WindowResizeEvent&>(event);
 
+        // The lit frame is a transient texture of the render graph, it follows the resolution by itself
         resolution = windowResizeEvent.GetSize();
-
-        postProcessing->OnEvent(windowResizeEvent);
     }
 }
 
@@ -0,0 +1,159 @@
+#include <Animation.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace lustra
+{
+
+static uint16_t QuantizeUnorm(const float value, const float min, const float extent)
+{
+    return extent > 0.0f ? static_cast<uint16_t>(std::lround(std::clamp((value - min) / extent, 0.0f, 1.0f) * 65535.0f)) : 0;
+}
+
+static int16_t QuantizeSnorm(const float value)
+{
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// One component of all the joints, out = a + (b - a) * alpha, dequantized on the way
+template<class T>
+static void LerpComponent(const T* a, const T* b, float* out, const size_t count, const float alpha, const float scale, const float offset)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        const auto first = static_cast<float>(a[i]);
+
+        out[i] = offset + (first + (static_cast<float>(b[i]) - first) * alpha) * scale;
+    }
+}
+
+Animation::Animation(std::string name, const float duration, const std::vector<std::vector<Keyframe>>& tracks)
+    : name(std::move(name)), duration(duration), jointCount(tracks.size())
+{
+    frameCount = tracks.empty() ? 0 : tracks[0].size();
+
+    if(frameCount == 0)
+        return;
+
+    glm::vec3 translationMax(std::numeric_limits<float>::lowest()), scaleMax(std::numeric_limits<float>::lowest());
+
+    translationMin = scaleMin = glm::vec3(std::numeric_limits<float>::max());
+
+    for(const auto& track : tracks)
+        for(const auto& keyframe : track)
+        {
+            translationMin = glm::min(translationMin, keyframe.translation);
+            translationMax = glm::max(translationMax, keyframe.translation);
+            scaleMin = glm::min(scaleMin, keyframe.scale);
+            scaleMax = glm::max(scaleMax, keyframe.scale);
+        }
+
+    translationExtent = translationMax - translationMin;
+    scaleExtent = scaleMax - scaleMin;
+
+    rotations.resize(frameCount * 4 * jointCount);
+    translations.resize(frameCount * 3 * jointCount);
+    scales.resize(frameCount * 3 * jointCount);
+
+    for(size_t joint = 0; joint < jointCount; joint++)
+    {
+        glm::quat previous{ 1.0f, 0.0f, 0.0f, 0.0f };
+
+        for(size_t frame = 0; frame < frameCount; frame++)
+        {
+            const auto& keyframe = tracks[joint][frame];
+
+            // Neighbouring keys stay in the same hemisphere, so sampling can lerp them without a check
+            auto rotation = glm::normalize(keyframe.rotation);
+
+            if(glm::dot(rotation, previous) < 0.0f)
+                rotation = -rotation;
+
+            previous = rotation;
+
+            for(size_t c = 0; c < 4; c++)
+                rotations[(frame * 4 + c) * jointCount + joint] = QuantizeSnorm(rotation[c]);
+
+            for(size_t c = 0; c < 3; c++)
+            {
+                translations[(frame * 3 + c) * jointCount + joint] =
+                    QuantizeUnorm(keyframe.translation[c], translationMin[c], translationExtent[c]);
+                scales[(frame * 3 + c) * jointCount + joint] =
+                    QuantizeUnorm(keyframe.scale[c], scaleMin[c], scaleExtent[c]);
+            }
+        }
+    }
+}
+
+void Animation::Sample(const float time, Pose& pose) const
+{
+    if(pose.GetJointCount() != jointCount)
+        pose.Resize(jointCount);
+
+    if(frameCount == 0)
+        return;
+
+    const auto position = std::clamp(time * sampleRate, 0.0f, static_cast<float>(frameCount - 1));
+
+    const auto first = static_cast<size_t>(position);
+    const auto second = std::min(first + 1, frameCount - 1);
+    const auto alpha = position - static_cast<float>(first);
+
+    for(size_t c = 0; c < 3; c++)
+    {
+        LerpComponent(
+            &translations[(first * 3 + c) * jointCount], &translations[(second * 3 + c) * jointCount],
+            pose.translation[c].data(), jointCount, alpha, translationExtent[c] / 65535.0f, translationMin[c]
+        );
+        LerpComponent(
+            &scales[(first * 3 + c) * jointCount], &scales[(second * 3 + c) * jointCount],
+            pose.scale[c].data(), jointCount, alpha, scaleExtent[c] / 65535.0f, scaleMin[c]
+        );
+    }
+
+    // glm::quat is x, y, z, w when indexed
+    for(size_t c = 0; c < 4; c++)
+        LerpComponent(
+            &rotations[(first * 4 + c) * jointCount], &rotations[(second * 4 + c) * jointCount],
+            pose.rotation[c].data(), jointCount, alpha, 1.0f / 32767.0f, 0.0f
+        );
+
+    auto* const x = pose.rotation[0].data();
+    auto* const y = pose.rotation[1].data();
+    auto* const z = pose.rotation[2].data();
+    auto* const w = pose.rotation[3].data();
+
+    for(size_t i = 0; i < jointCount; i++)
+    {
+        const auto inverseLength = 1.0f / std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i]);
+
+        x[i] *= inverseLength;
+        y[i] *= inverseLength;
+        z[i] *= inverseLength;
+        w[i] *= inverseLength;
+    }
+}
+
+const std::string& Animation::GetName() const
+{
+    return name;
+}
+
+float Animation::GetDuration() const
+{
+    return duration;
+}
+
+size_t Animation::GetJointCount() const
+{
+    return jointCount;
+}
+
+size_t Animation::GetFrameCount() const
+{
+    return frameCount;
+}
+
+}
@@ -1,11 +1,158 @@
 #include <AnimationManager.hpp>
+#include <Multithreading.hpp>
+#include <CoreComponents.hpp>
+
+#include <algorithm>
+#include <cmath>
 
 namespace lustra
 {
 
-void AnimationManager::Update(Entity& entity, float deltaTime)
+// Wraps or clamps the time to the duration of the animation, -1 if there's no such animation
+static float AdvanceTime(
+    const AnimationAsset& animation,
+    const int32_t index,
+    const float time,
+    const float deltaTime,
+    const bool loop
+)
+{
+    if(index < 0 || index >= static_cast<int32_t>(animation.animations.size()))
+        return -1.0f;
+
+    const auto duration = animation.animations[index].GetDuration();
+
+    if(duration <= 0.0f)
+        return 0.0f;
+
+    const auto next = time + deltaTime;
+
+    if(loop)
+        return next - std::floor(next / duration) * duration;
+
+    return std::clamp(next, 0.0f, duration);
+}
+
+void AnimationManager::Update(const std::span<const Instance> instances, const float deltaTime)
+{
+    std::vector<const Instance*> visible;
+
+    for(const auto& instance : instances)
+    {
+        Advance(*instance.animator, *instance.animation, deltaTime);
+
+        if(instance.visible)
+            visible.push_back(&instance);
+    }
+
+    // A few joints per character, a thread is only worth it for a handful of them
+    Multithreading::ParallelFor(visible.size(), [&](const size_t begin, const size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+            Evaluate(*visible[i]->animator, *visible[i]->animation);
+    }, 4);
+
+    Upload(instances);
+}
+
+LLGL::Buffer* AnimationManager::GetPaletteBuffer() const
+{
+    return paletteBuffer;
+}
+
+void AnimationManager::Upload(const std::span<const Instance> instances)
 {
-    // TODO ...
+    palettes.clear();
+
+    for(const auto& instance : instances)
+    {
+        auto& animator = *instance.animator;
+
+        // The palettes of the hidden ones are out of date and aren't drawn
+        if(!instance.visible || animator.palette.empty())
+        {
+            animator.paletteOffset = AnimatorComponent::noPalette;
+            continue;
+        }
+
+        animator.paletteOffset = static_cast<uint32_t>(palettes.size());
+
+        palettes.insert(palettes.end(), animator.palette.begin(), animator.palette.end());
+    }
+
+    if(palettes.empty())
+        return;
+
+    if(!paletteBuffer || palettes.size() > paletteCapacity)
+    {
+        paletteCapacity = std::max<uint64_t>(paletteCapacity, Matrices::maxJoints);
+
+        while(paletteCapacity < palettes.size())
+            paletteCapacity *= 2;
+
+        if(paletteBuffer)
+            Renderer::Get().Release(paletteBuffer);
+
+        LLGL::BufferDescriptor bufferDesc;
+
+        bufferDesc.size = paletteCapacity * sizeof(glm::mat4);
+        bufferDesc.stride = sizeof(glm::mat4);
+        bufferDesc.bindFlags = LLGL::BindFlags::Storage;
+
+        paletteBuffer = Renderer::Get().CreateBuffer(bufferDesc);
+    }
+
+    Renderer::Get().WriteBuffer(*paletteBuffer, 0, palettes.data(), palettes.size() * sizeof(glm::mat4));
+}
+
+void AnimationManager::Advance(AnimatorComponent& animator, const AnimationAsset& animation, const float deltaTime)
+{
+    if(!animator.playing)
+        return;
+
+    const auto step = deltaTime * animator.speed;
+
+    animator.time = AdvanceTime(animation, animator.animation, animator.time, step, animator.loop);
+
+    if(animator.previousAnimation == -1)
+        return;
+
+    animator.previousTime = AdvanceTime(animation, animator.previousAnimation, animator.previousTime, step, animator.loop);
+    animator.fade += animator.fadeDuration > 0.0f ? deltaTime / animator.fadeDuration : 1.0f;
+
+    if(animator.fade >= 1.0f || animator.previousTime < 0.0f)
+    {
+        animator.fade = 1.0f;
+        animator.previousAnimation = -1;
+    }
+}
+
+void AnimationManager::Evaluate(AnimatorComponent& animator, const AnimationAsset& animation)
+{
+    const auto& skeleton = animation.skeleton;
+    const auto count = static_cast<int32_t>(animation.animations.size());
+
+    if(animator.animation >= 0 && animator.animation < count)
+        animation.animations[animator.animation].Sample(animator.time, animator.pose);
+    else
+        animator.pose = skeleton.restPose;
+
+    // Play may fade out of an index that doesn't exist while the animator is paused, Advance doesn't reset it then
+    if(animator.previousAnimation != -1 && (animator.previousAnimation < 0 || animator.previousAnimation >= count))
+    {
+        animator.fade = 1.0f;
+        animator.previousAnimation = -1;
+    }
+
+    if(animator.previousAnimation != -1)
+    {
+        animation.animations[animator.previousAnimation].Sample(animator.previousTime, animator.blendPose);
+        animator.blendPose.Blend(animator.pose, animator.fade);
+
+        std::swap(animator.pose, animator.blendPose);
+    }
+
+    skeleton.ComputePalette(animator.pose, animator.palette);
 }
 
 }
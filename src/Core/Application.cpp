@@ -1,4 +1,7 @@
 #include <Application.hpp>
+#include <EventBus.hpp>
+#include <PBRManager.hpp>
+#include <ShadowAtlas.hpp>
 
 namespace lustra
 {
@@ -16,6 +19,9 @@ Application::Application(const Config& config) : config(config)
     if(!Renderer::Get().IsInit())
         exit(EXIT_FAILURE);
 
+    Renderer::Get().SetPipelineCacheDirectory(config.pipelineCachePath);
+    PBRManager::SetCacheDirectory(config.environmentCachePath);
+
     Renderer::Get().InitSwapChain(window);
 
     Renderer::Get().PrintRendererInfo();
@@ -23,6 +29,8 @@ Application::Application(const Config& config) : config(config)
     if(config.vsync)
         Renderer::Get().GetSwapChain()->SetVsyncInterval(1);
 
+    ShadowAtlas::Get().SetConfig(config.shadowAtlas);
+
     ImGuiManager::Get().Init(
         window->GetGLFWWindow(),
         config.imGuiFontPath,
@@ -61,11 +69,19 @@ void Application::Run()
 
         Multithreading::Get().Update();
 
+        EventBus::Get().Flush();
+
         Update(deltaTimeTimer.GetElapsedSeconds());
 
         deltaTimeTimer.Reset();
 
+        Renderer::Get().BeginFrame();
+
         Render();
+
+        Renderer::Get().EndFrame();
+
+        // ImGui draws with OpenGL directly, so the frame has to be submitted before it
         RenderImGui();
 
         Renderer::Get().Present();
@@ -1,8 +1,33 @@
 #include <Multithreading.hpp>
 
+#include <algorithm>
+#include <atomic>
+
 namespace lustra
 {
 
+Multithreading::Multithreading()
+{
+    // The calling thread of ParallelFor runs a chunk as well
+    const size_t count = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+
+    for(size_t i = 0; i < count; i++)
+        workers.emplace_back(&Multithreading::RunWorker, this);
+}
+
+Multithreading::~Multithreading()
+{
+    {
+        std::lock_guard lock(mutex);
+        stop = true;
+    }
+
+    condition.notify_all();
+
+    for(auto& worker : workers)
+        worker.join();
+}
+
 void Multithreading::Update()
 {
     for(size_t i = 0; i < jobs.size(); i++)
@@ -35,4 +60,123 @@ size_t Multithreading::GetJobsNum() const
     return jobs.size();
 }
 
+size_t Multithreading::GetChunkCount(const size_t count, const size_t minChunkSize)
+{
+    if(count == 0)
+        return 0;
+
+    const size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const size_t chunkLimit = std::max(minChunkSize, size_t(1));
+
+    return std::clamp((count + chunkLimit - 1) / chunkLimit, size_t(1), threads);
+}
+
+void Multithreading::ParallelFor(
+    const size_t count,
+    const std::function<void(size_t begin, size_t end)>& function,
+    const size_t minChunkSize
+)
+{
+    ParallelForChunks(count, [&](size_t, const size_t begin, const size_t end)
+    {
+        function(begin, end);
+    }, minChunkSize);
+}
+
+void Multithreading::ParallelForChunks(
+    const size_t count,
+    const std::function<void(size_t chunk, size_t begin, size_t end)>& function,
+    const size_t minChunkSize
+)
+{
+    const size_t chunks = GetChunkCount(count, minChunkSize);
+
+    if(chunks == 0)
+        return;
+
+    // Not worth waking up the workers
+    if(chunks == 1)
+    {
+        function(0, 0, count);
+        return;
+    }
+
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+
+    auto& instance = Get();
+
+    std::atomic<size_t> remaining = chunks - 1;
+
+    {
+        std::lock_guard lock(instance.mutex);
+
+        for(size_t i = 1; i < chunks; i++)
+            instance.tasks.emplace_back([&, i]()
+            {
+                function(i, i * chunkSize, std::min((i + 1) * chunkSize, count));
+
+                if(remaining.fetch_sub(1) == 1)
+                {
+                    // Under the lock, so the waiting thread can't miss it
+                    std::lock_guard lock(instance.mutex);
+                    instance.condition.notify_all();
+                }
+            });
+    }
+
+    instance.condition.notify_all();
+
+    function(0, 0, std::min(chunkSize, count));
+
+    // Helps with the queued chunks instead of just waiting, so a nested ParallelFor can't get stuck
+    while(remaining > 0)
+    {
+        if(instance.RunTask())
+            continue;
+
+        std::unique_lock lock(instance.mutex);
+        instance.condition.wait(lock, [&]() { return remaining == 0 || !instance.tasks.empty(); });
+    }
+}
+
+void Multithreading::RunWorker()
+{
+    while(true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock lock(mutex);
+            condition.wait(lock, [this]() { return stop || !tasks.empty(); });
+
+            if(stop)
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+bool Multithreading::RunTask()
+{
+    std::function<void()> task;
+
+    {
+        std::lock_guard lock(mutex);
+
+        if(tasks.empty())
+            return false;
+
+        task = std::move(tasks.front());
+        tasks.pop_front();
+    }
+
+    task();
+
+    return true;
+}
+
 }
@@ -0,0 +1,116 @@
+#include <Skeleton.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace lustra
+{
+
+void Pose::Resize(const size_t jointCount)
+{
+    for(auto& component : translation)
+        component.resize(jointCount, 0.0f);
+
+    for(auto& component : scale)
+        component.resize(jointCount, 1.0f);
+
+    for(size_t i = 0; i < rotation.size(); i++)
+        rotation[i].resize(jointCount, i == 3 ? 1.0f : 0.0f);
+}
+
+size_t Pose::GetJointCount() const
+{
+    return translation[0].size();
+}
+
+void Pose::Blend(const Pose& other, const float weight)
+{
+    const auto count = std::min(GetJointCount(), other.GetJointCount());
+
+    for(size_t c = 0; c < 3; c++)
+    {
+        auto* const translationOut = translation[c].data();
+        auto* const scaleOut = scale[c].data();
+
+        const auto* const otherTranslation = other.translation[c].data();
+        const auto* const otherScale = other.scale[c].data();
+
+        for(size_t i = 0; i < count; i++)
+        {
+            translationOut[i] += (otherTranslation[i] - translationOut[i]) * weight;
+            scaleOut[i] += (otherScale[i] - scaleOut[i]) * weight;
+        }
+    }
+
+    auto* const x = rotation[0].data();
+    auto* const y = rotation[1].data();
+    auto* const z = rotation[2].data();
+    auto* const w = rotation[3].data();
+
+    const auto* const otherX = other.rotation[0].data();
+    const auto* const otherY = other.rotation[1].data();
+    const auto* const otherZ = other.rotation[2].data();
+    const auto* const otherW = other.rotation[3].data();
+
+    for(size_t i = 0; i < count; i++)
+    {
+        const auto dot = x[i] * otherX[i] + y[i] * otherY[i] + z[i] * otherZ[i] + w[i] * otherW[i];
+
+        // q and -q are the same rotation, the one closer to this pose is taken
+        const auto otherWeight = dot < 0.0f ? -weight : weight;
+        const auto thisWeight = 1.0f - weight;
+
+        const auto rx = x[i] * thisWeight + otherX[i] * otherWeight;
+        const auto ry = y[i] * thisWeight + otherY[i] * otherWeight;
+        const auto rz = z[i] * thisWeight + otherZ[i] * otherWeight;
+        const auto rw = w[i] * thisWeight + otherW[i] * otherWeight;
+
+        const auto inverseLength = 1.0f / std::sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+
+        x[i] = rx * inverseLength;
+        y[i] = ry * inverseLength;
+        z[i] = rz * inverseLength;
+        w[i] = rw * inverseLength;
+    }
+}
+
+int32_t Skeleton::Find(const std::string_view name) const
+{
+    const auto it = std::ranges::find(joints, name, &Joint::name);
+
+    return it != joints.end() ? static_cast<int32_t>(std::distance(joints.begin(), it)) : -1;
+}
+
+void Skeleton::ComputePalette(const Pose& pose, std::vector<glm::mat4>& palette) const
+{
+    palette.resize(joints.size());
+
+    if(pose.GetJointCount() < joints.size())
+    {
+        std::ranges::fill(palette, glm::mat4(1.0f));
+        return;
+    }
+
+    // Model space transforms first, the parents are always ready before their children
+    for(size_t i = 0; i < joints.size(); i++)
+    {
+        const auto x = pose.rotation[0][i], y = pose.rotation[1][i], z = pose.rotation[2][i], w = pose.rotation[3][i];
+        const glm::vec3 scale = { pose.scale[0][i], pose.scale[1][i], pose.scale[2][i] };
+
+        // T * R * S without going through glm::translate, glm::mat4_cast and glm::scale
+        const glm::mat4 local =
+        {
+            glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f) * scale.x,
+            glm::vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f) * scale.y,
+            glm::vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f) * scale.z,
+            glm::vec4(pose.translation[0][i], pose.translation[1][i], pose.translation[2][i], 1.0f)
+        };
+
+        palette[i] = joints[i].parent < 0 ? local : palette[joints[i].parent] * local;
+    }
+
+    for(size_t i = 0; i < joints.size(); i++)
+        palette[i] = globalInverse * palette[i] * joints[i].inverseBind;
+}
+
+}
@@ -223,6 +223,7 @@ void Editor::DrawPropertiesWindow()
             lustra::ProceduralSkyComponent,
             lustra::HDRISkyComponent,
             lustra::SoundComponent,
+            lustra::AnimatorComponent,
             lustra::RigidBodyComponent
         >(scene->GetRegistry(), selectedEntity);
 
@@ -284,6 +285,9 @@ void Editor::DrawPropertiesWindow()
             if(ImGui::MenuItem("Add SoundComponent"))
                 selectedEntity.GetOrAddComponent<lustra::SoundComponent>();
 
+            if(ImGui::MenuItem("Add AnimatorComponent"))
+                selectedEntity.GetOrAddComponent<lustra::AnimatorComponent>();
+
             if(ImGui::MenuItem("Add ScriptComponent"))
                 selectedEntity.GetOrAddComponent<lustra::ScriptComponent>();
 
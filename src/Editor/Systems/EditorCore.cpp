@@ -16,7 +16,18 @@ void Editor::Init()
 
     lustra::EventManager::Get().AddListener(lustra::Event::Type::WindowResize, this);
     lustra::EventManager::Get().AddListener(lustra::Event::Type::WindowFocus, this);
-    lustra::EventManager::Get().AddListener(lustra::Event::Type::AssetLoaded, this);
+
+    lustra::EventBus::Get().Subscribe<lustra::AssetLoadedEvent>(
+        [this](const auto events)
+        {
+            for(const auto& event : events)
+                if(event.GetAsset() == sceneAsset)
+                {
+                    SwitchScene(sceneAsset);
+                    break;
+                }
+        }
+    );
 
     CreateRenderTarget();
 
@@ -118,13 +129,6 @@ void Editor::OnEvent(lustra::Event& event)
         else
             lustra::Renderer::Get().GetSwapChain()->SetVsyncInterval(5);
     }
-    else if(event.GetType() == lustra::Event::Type::AssetLoaded)
-    {
-        const auto assetLoadedEvent = dynamic_cast<lustra::AssetLoadedEvent*>(&event);
-
-        if(assetLoadedEvent->GetAsset() == sceneAsset)
-            SwitchScene(sceneAsset);
-    }
 }
 
 bool Editor::CheckShortcut(const std::initializer_list<lustra::Keyboard::Key> shortcut)
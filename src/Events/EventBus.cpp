@@ -0,0 +1,44 @@
+#include <EventBus.hpp>
+
+#include <stdexcept>
+
+namespace lustra
+{
+
+EventBus::~EventBus()
+{
+    for(auto& channel : channels)
+        delete channel.exchange(nullptr);
+}
+
+void EventBus::Unsubscribe(Subscription& subscription)
+{
+    if(!subscription.IsValid())
+        return;
+
+    if(const auto channel = channels[subscription.typeId].load(std::memory_order_acquire))
+        channel->Remove(subscription.handlerId);
+
+    subscription = {};
+}
+
+void EventBus::Flush()
+{
+    for(auto& channel : channels)
+        if(const auto ptr = channel.load(std::memory_order_acquire))
+            ptr->Flush();
+}
+
+uint32_t EventBus::NextTypeId()
+{
+    static std::atomic<uint32_t> counter = 0;
+
+    const auto id = counter.fetch_add(1, std::memory_order_relaxed);
+
+    if(id >= maxEventTypes)
+        throw std::runtime_error("EventBus: too many event types, increase maxEventTypes");
+
+    return id;
+}
+
+}
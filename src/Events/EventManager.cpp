@@ -21,18 +21,20 @@ void EventManager::AddListener(const Event::Type eventType, EventListener* liste
 
 void EventManager::RemoveListener(const Event::Type eventType, EventListener* listener)
 {
-    if(listeners.empty())
+    const auto it = listeners.find(eventType);
+    if(it == listeners.end())
         return;
 
-    auto& vec = listeners[eventType];
-    std::erase(vec, listener);
+    std::erase(it->second, listener);
 }
 
 void EventManager::Dispatch(const std::unique_ptr<Event>& event)
 {
-    const auto& vec = listeners[event->GetType()];
+    const auto it = listeners.find(event->GetType());
+    if(it == listeners.end())
+        return;
 
-    for(const auto listener : vec)
+    for(const auto listener : it->second)
     {
         listener->OnEvent(*event);
 
@@ -8,28 +8,11 @@ DeferredRenderer::DeferredRenderer()
 {
     LLGL::Extent2D resolution = Renderer::Get().GetViewportResolution();
 
-    EventManager::Get().AddListener(Event::Type::WindowResize, this);
     EventManager::Get().AddListener(Event::Type::WindowResize, this);
 
-    LLGL::TextureDescriptor colorAttachmentDesc =
-    {
-        .type = LLGL::TextureType::Texture2D,
-        .bindFlags = LLGL::BindFlags::ColorAttachment,
-        .format = LLGL::Format::RGBA16Float,
-        .extent = { resolution.width, resolution.height, 1 },
-        .mipLevels = 1,
-        .samples = 1
-    };
-
-    LLGL::TextureDescriptor depthAttachmentDesc =
-    {
-        .type = LLGL::TextureType::Texture2D,
-        .bindFlags = LLGL::BindFlags::DepthStencilAttachment,
-        .format = LLGL::Format::D32Float,
-        .extent = { resolution.width, resolution.height, 1 },
-        .mipLevels = 1,
-        .samples = 1
-    };
+    assetLoadedSubscription = EventBus::Get().Subscribe<AssetLoadedEvent>(
+        [this](const auto events) { OnAssetLoaded(events); }
+    );
 
     LLGL::SamplerDescriptor shadowSamplerDesc
     {
@@ -43,19 +26,7 @@ DeferredRenderer::DeferredRenderer()
         .borderColor = { 1.0f, 1.0f, 1.0f, 1.0f },
     };
 
-    gBufferPosition = Renderer::Get().CreateTexture(colorAttachmentDesc);
-    gBufferAlbedo = Renderer::Get().CreateTexture(colorAttachmentDesc);
-
-    colorAttachmentDesc.format = LLGL::Format::RGB16Float;
-
-    gBufferNormal = Renderer::Get().CreateTexture(colorAttachmentDesc);
-    gBufferCombined = Renderer::Get().CreateTexture(colorAttachmentDesc);
-    gBufferEmission = Renderer::Get().CreateTexture(colorAttachmentDesc);
-
-    gBufferDepth = Renderer::Get().CreateTexture(depthAttachmentDesc);
-
-    gBuffer = Renderer::Get().CreateRenderTarget(resolution, { gBufferPosition, gBufferAlbedo, gBufferNormal, gBufferCombined, gBufferEmission }, gBufferDepth);
-    //gBufferPipeline = Renderer::Get().CreateRenderTargetPipeline(gBuffer);
+    CreateGBuffer(resolution);
 
     lightingPass = AssetManager::Get().Load<FragmentShaderAsset>("lightingPass.frag", true);
 
@@ -64,22 +35,21 @@ DeferredRenderer::DeferredRenderer()
     layoutDesc = {
         .bindings =
         {
-            { "gPosition", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 1 },
-            { "gAlbedo", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 },
-            { "gNormal", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 3 },
-            { "gCombined", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 4 },
-            { "gEmission", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 5 },
-            { "lightBuffer", LLGL::ResourceType::Buffer, LLGL::BindFlags::ConstantBuffer, LLGL::StageFlags::FragmentStage, 6 },
-            { "shadowBuffer", LLGL::ResourceType::Buffer, LLGL::BindFlags::ConstantBuffer, LLGL::StageFlags::FragmentStage, 7 },
-            { "shadowMaps[0]", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 8 },
-            { "shadowMaps[1]", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 9 },
-            { "shadowMaps[2]", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 10 },
-            { "shadowMaps[3]", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 11 },
+            { "gAlbedo", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 1 },
+            { "gNormal", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 },
+            { "gCombined", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 3 },
+            { "gEmission", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 4 },
+            { "gDepth", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 5 },
+            { "lightBuffer", LLGL::ResourceType::Buffer, LLGL::BindFlags::Storage, LLGL::StageFlags::FragmentStage, 1 },
+            { "shadowBuffer", LLGL::ResourceType::Buffer, LLGL::BindFlags::Storage, LLGL::StageFlags::FragmentStage, 4 },
+            { "shadowAtlas", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 8 },
             { "irradiance", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 12 },
             { "prefiltered", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 13 },
             { "brdf", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 14 },
             { "gtao", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 15 },
-            { "samplerState", LLGL::ResourceType::Sampler, 0, LLGL::StageFlags::FragmentStage, 1 }
+            { "samplerState", LLGL::ResourceType::Sampler, 0, LLGL::StageFlags::FragmentStage, 1 },
+            { "clusterBuffer", LLGL::ResourceType::Buffer, LLGL::BindFlags::Storage, LLGL::StageFlags::FragmentStage, 2 },
+            { "lightIndexBuffer", LLGL::ResourceType::Buffer, LLGL::BindFlags::Storage, LLGL::StageFlags::FragmentStage, 3 }
         },
         .staticSamplers =
         {
@@ -87,17 +57,17 @@ DeferredRenderer::DeferredRenderer()
         },
         .uniforms =
         {
-            { "numLights", LLGL::UniformType::Int1 },
-            { "numShadows", LLGL::UniformType::Int1 },
             { "cameraPosition", LLGL::UniformType::Float3 },
-            { "view", LLGL::UniformType::Float4x4 }
+            { "view", LLGL::UniformType::Float4x4 },
+            { "projection", LLGL::UniformType::Float4x4 },
+            { "inverseView", LLGL::UniformType::Float4x4 },
+            { "inverseProjection", LLGL::UniformType::Float4x4 },
+            { "clusterScale", LLGL::UniformType::Float1 },
+            { "clusterBias", LLGL::UniformType::Float1 }
         },
         .combinedTextureSamplers =
         {
-            { "shadowMaps[0]", "shadowMaps[0]", "shadowMapSampler", 8 },
-            { "shadowMaps[1]", "shadowMaps[1]", "shadowMapSampler", 9 },
-            { "shadowMaps[2]", "shadowMaps[2]", "shadowMapSampler", 10 },
-            { "shadowMaps[3]", "shadowMaps[3]", "shadowMapSampler", 11 },
+            { "shadowAtlas", "shadowAtlas", "shadowMapSampler", 8 }
         }
     };
 
@@ -114,6 +84,7 @@ DeferredRenderer::DeferredRenderer()
 DeferredRenderer::~DeferredRenderer()
 {
     EventManager::Get().RemoveListener(Event::Type::WindowResize, this);
+    EventBus::Get().Unsubscribe(assetLoadedSubscription);
 }
 
 void DeferredRenderer::Draw(
@@ -128,11 +99,11 @@ void DeferredRenderer::Draw(
             rect->BindBuffers(commandBuffer, false);
         },
         {
-            { 0, gBufferPosition },
-            { 1, gBufferAlbedo },
-            { 2, gBufferNormal },
-            { 3, gBufferCombined },
-            { 4, gBufferEmission },
+            { 0, gBufferAlbedo },
+            { 1, gBufferNormal },
+            { 2, gBufferCombined },
+            { 3, gBufferEmission },
+            { 4, gBufferDepth },
             { 5, resources.at(5) },
             { 6, resources.at(6) },
             { 7, resources.at(7) },
@@ -140,10 +111,9 @@ void DeferredRenderer::Draw(
             { 9, resources.at(9) },
             { 10, resources.at(10) },
             { 11, resources.at(11) },
-            { 12, resources.at(12) },
+            { 12, AssetManager::Get().Load<TextureAsset>("default", true)->sampler },
             { 13, resources.at(13) },
-            { 14, resources.at(14) },
-            { 15, AssetManager::Get().Load<TextureAsset>("default", true)->sampler }
+            { 14, resources.at(14) }
         },
         [&](auto commandBuffer)
         {
@@ -162,63 +132,75 @@ void DeferredRenderer::OnEvent(Event& event)
     {
         const auto resizeEvent = dynamic_cast<WindowResizeEvent*>(&event);
 
-        LLGL::Extent2D size = resizeEvent->GetSize();
-
-        Renderer::Get().Release(gBufferPosition);
         Renderer::Get().Release(gBufferAlbedo);
         Renderer::Get().Release(gBufferNormal);
+        Renderer::Get().Release(gBufferCombined);
+        Renderer::Get().Release(gBufferEmission);
         Renderer::Get().Release(gBufferDepth);
         Renderer::Get().Release(gBuffer);
 
-        LLGL::TextureDescriptor colorAttachmentDesc =
-        {
-            .type = LLGL::TextureType::Texture2D,
-            .bindFlags = LLGL::BindFlags::ColorAttachment,
-            .format = LLGL::Format::RGBA16Float,
-            .extent = { size.width, size.height, 1 },
-            .mipLevels = 1,
-            .samples = 1
-        };
-
-        const LLGL::TextureDescriptor depthAttachmentDesc =
-        {
-            .type = LLGL::TextureType::Texture2D,
-            .bindFlags = LLGL::BindFlags::DepthStencilAttachment,
-            .format = LLGL::Format::D32Float,
-            .extent = { size.width, size.height, 1 },
-            .mipLevels = 1,
-            .samples = 1
-        };
+        CreateGBuffer(resizeEvent->GetSize());
+    }
+}
 
-        gBufferPosition = Renderer::Get().CreateTexture(colorAttachmentDesc);
-        gBufferAlbedo = Renderer::Get().CreateTexture(colorAttachmentDesc);
+void DeferredRenderer::CreateGBuffer(const LLGL::Extent2D& resolution)
+{
+    // 20 bytes per pixel:
+    // - albedo and material are 8 bits per channel
+    // - normals are octahedral-encoded into two 16-bit channels
+    // - the position is reconstructed from the depth
+    LLGL::TextureDescriptor colorAttachmentDesc =
+    {
+        .type = LLGL::TextureType::Texture2D,
+        .bindFlags = LLGL::BindFlags::ColorAttachment,
+        .format = LLGL::Format::RGBA8UNorm,
+        .extent = { resolution.width, resolution.height, 1 },
+        .mipLevels = 1,
+        .samples = 1
+    };
+
+    const LLGL::TextureDescriptor depthAttachmentDesc =
+    {
+        .type = LLGL::TextureType::Texture2D,
+        .bindFlags = LLGL::BindFlags::DepthStencilAttachment | LLGL::BindFlags::Sampled,
+        .format = LLGL::Format::D32Float,
+        .extent = { resolution.width, resolution.height, 1 },
+        .mipLevels = 1,
+        .samples = 1
+    };
 
-        colorAttachmentDesc.format = LLGL::Format::RGB16Float;
+    gBufferAlbedo = Renderer::Get().CreateTexture(colorAttachmentDesc);
+    gBufferCombined = Renderer::Get().CreateTexture(colorAttachmentDesc);
 
-        gBufferNormal = Renderer::Get().CreateTexture(colorAttachmentDesc);
-        gBufferCombined = Renderer::Get().CreateTexture(colorAttachmentDesc);
-        gBufferEmission = Renderer::Get().CreateTexture(colorAttachmentDesc);
+    colorAttachmentDesc.format = LLGL::Format::RG16UNorm;
 
-        gBufferDepth = Renderer::Get().CreateTexture(depthAttachmentDesc);
+    gBufferNormal = Renderer::Get().CreateTexture(colorAttachmentDesc);
 
-        gBuffer = Renderer::Get().CreateRenderTarget(size, { gBufferPosition, gBufferAlbedo, gBufferNormal, gBufferCombined, gBufferEmission }, gBufferDepth);
-    }
-    else if(event.GetType() == Event::Type::AssetLoaded)
-    {
-        const auto assetEvent = dynamic_cast<AssetLoadedEvent*>(&event);
+    colorAttachmentDesc.format = LLGL::Format::R11G11B10Float;
+
+    gBufferEmission = Renderer::Get().CreateTexture(colorAttachmentDesc);
+
+    gBufferDepth = Renderer::Get().CreateTexture(depthAttachmentDesc);
+
+    gBuffer = Renderer::Get().CreateRenderTarget(resolution, { gBufferAlbedo, gBufferNormal, gBufferCombined, gBufferEmission }, gBufferDepth);
+}
 
-        if(assetEvent->GetAsset()->type == Asset::Type::FragmentShader)
+void DeferredRenderer::OnAssetLoaded(const std::span<const AssetLoadedEvent> events)
+{
+    for(const auto& event : events)
+    {
+        if(event.GetAsset() == lightingPass)
         {
-            const auto shader = std::static_pointer_cast<FragmentShaderAsset>(assetEvent->GetAsset());
-            if(lightingPass == shader)
-                rectPipeline = Renderer::Get().CreatePipelineState(
-                    layoutDesc,
-                    LLGL::GraphicsPipelineDescriptor
-                    {
-                        .vertexShader = AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true)->shader,
-                        .fragmentShader = lightingPass->shader
-                    }
-                );
+            rectPipeline = Renderer::Get().CreatePipelineState(
+                layoutDesc,
+                LLGL::GraphicsPipelineDescriptor
+                {
+                    .vertexShader = AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true)->shader,
+                    .fragmentShader = lightingPass->shader
+                }
+            );
+
+            break;
         }
     }
 }
@@ -233,11 +215,6 @@ LLGL::Texture* DeferredRenderer::GetDepth()
     return gBufferDepth;
 }
 
-LLGL::Texture* DeferredRenderer::GetPosition() const
-{
-    return gBufferPosition;
-}
-
 LLGL::Texture* DeferredRenderer::GetAlbedo() const
 {
     return gBufferAlbedo;
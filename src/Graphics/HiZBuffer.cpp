@@ -0,0 +1,170 @@
+#include <HiZBuffer.hpp>
+#include <AssetManager.hpp>
+#include <ModelAsset.hpp>
+#include <ShaderAsset.hpp>
+
+#include <algorithm>
+#include <bit>
+
+namespace lustra
+{
+
+HiZBuffer::HiZBuffer()
+{
+    rect = AssetManager::Get().Load<ModelAsset>("plane", true)->meshes[0];
+
+    CreatePipeline();
+}
+
+void HiZBuffer::Build(LLGL::Texture* depth)
+{
+    const auto extent = depth->GetMipExtent(0);
+
+    if(!texture || extent.width != resolution.width || extent.height != resolution.height)
+        Create({ extent.width, extent.height });
+
+    Renderer::Get().Begin();
+
+    for(int level = 0; level < static_cast<int>(levelCount); level++)
+    {
+        Renderer::Get().RenderPass(
+            [&](auto commandBuffer)
+            {
+                // The previous level is done, it can go into the pyramid
+                if(level > 0)
+                    CopyLevel(commandBuffer, level - 1);
+
+                rect->BindBuffers(commandBuffer, false);
+            },
+            {
+                { 0, depth },
+                { 1, level == 0 ? depth : scratch[level - 1] }
+            },
+            [&](auto commandBuffer)
+            {
+                commandBuffer->SetUniforms(0, &level, sizeof(level));
+
+                rect->Draw(commandBuffer);
+            },
+            pipeline,
+            levels[level]
+        );
+    }
+
+    Renderer::Get().RenderPass(
+        [&](auto commandBuffer)
+        {
+            CopyLevel(commandBuffer, levelCount - 1);
+        }, {}, [&](auto) {},
+        nullptr
+    );
+
+    Renderer::Get().End();
+
+    Renderer::Get().Submit();
+}
+
+LLGL::Texture* HiZBuffer::GetTexture() const
+{
+    return texture;
+}
+
+uint32_t HiZBuffer::GetLevelCount() const
+{
+    return levelCount;
+}
+
+LLGL::Extent2D HiZBuffer::GetResolution() const
+{
+    return resolution;
+}
+
+void HiZBuffer::CopyLevel(LLGL::CommandBuffer* commandBuffer, const uint32_t level) const
+{
+    const auto extent = scratch[level]->GetMipExtent(0);
+
+    commandBuffer->CopyTexture(
+        *texture, LLGL::TextureLocation(LLGL::Offset3D{}, 0, level),
+        *scratch[level], LLGL::TextureLocation(LLGL::Offset3D{}, 0, 0),
+        extent
+    );
+}
+
+void HiZBuffer::Create(const LLGL::Extent2D& resolution)
+{
+    if(texture)
+    {
+        for(const auto renderTarget : levels)
+            Renderer::Get().Release(renderTarget);
+
+        for(const auto levelTexture : scratch)
+            Renderer::Get().Release(levelTexture);
+
+        Renderer::Get().Release(texture);
+    }
+
+    this->resolution = resolution;
+
+    levelCount = std::bit_width(std::max({ resolution.width, resolution.height, 1u }));
+
+    const LLGL::TextureDescriptor textureDesc =
+    {
+        .type = LLGL::TextureType::Texture2D,
+        .bindFlags = LLGL::BindFlags::Sampled | LLGL::BindFlags::CopyDst,
+        .format = LLGL::Format::RG32Float,
+        .extent = { resolution.width, resolution.height, 1 },
+        .mipLevels = levelCount,
+        .samples = 1
+    };
+
+    texture = Renderer::Get().CreateTexture(textureDesc);
+
+    scratch.clear();
+    levels.clear();
+
+    for(uint32_t level = 0; level < levelCount; level++)
+    {
+        const LLGL::Extent2D levelResolution =
+        {
+            std::max(resolution.width >> level, 1u),
+            std::max(resolution.height >> level, 1u)
+        };
+
+        scratch.push_back(Renderer::Get().CreateTexture(
+            {
+                .type = LLGL::TextureType::Texture2D,
+                .bindFlags = LLGL::BindFlags::ColorAttachment | LLGL::BindFlags::Sampled | LLGL::BindFlags::CopySrc,
+                .format = LLGL::Format::RG32Float,
+                .extent = { levelResolution.width, levelResolution.height, 1 },
+                .mipLevels = 1,
+                .samples = 1
+            }
+        ));
+
+        levels.push_back(Renderer::Get().CreateRenderTarget(levelResolution, { scratch.back() }));
+    }
+}
+
+void HiZBuffer::CreatePipeline()
+{
+    pipeline = Renderer::Get().CreatePipelineState(
+        LLGL::PipelineLayoutDescriptor
+        {
+            .bindings =
+            {
+                { "depth", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 1 },
+                { "hiZ", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 }
+            },
+            .uniforms =
+            {
+                { "level", LLGL::UniformType::Int1 }
+            }
+        },
+        {
+            .vertexShader = AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true)->shader,
+            .fragmentShader = AssetManager::Get().Load<FragmentShaderAsset>("hiZ.frag", true)->shader
+        }
+    );
+}
+
+}
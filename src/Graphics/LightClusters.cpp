@@ -0,0 +1,206 @@
+#include <LightClusters.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace lustra
+{
+
+LightClusters::LightClusters()
+{
+    Reserve(lightBuffer, lightCapacity, initialLights, sizeof(Light));
+    Reserve(indexBuffer, indexCapacity, initialIndices, sizeof(uint32_t));
+
+    LLGL::BufferDescriptor clusterBufferDesc;
+
+    clusterBufferDesc.size = clusterCount * sizeof(Cluster);
+    clusterBufferDesc.stride = sizeof(Cluster);
+    clusterBufferDesc.bindFlags = LLGL::BindFlags::Storage;
+
+    clusters.resize(clusterCount);
+
+    clusterBuffer = Renderer::Get().CreateBuffer(clusterBufferDesc, clusters.data());
+}
+
+void LightClusters::Build(
+    const std::span<const Light> lights,
+    const glm::mat4& view,
+    const glm::mat4& projection,
+    const float near,
+    const float far
+)
+{
+    this->near = std::max(near, 0.001f);
+    this->far = std::max(far, this->near * 1.001f);
+
+    const float logRatio = std::log(this->far / this->near);
+
+    sliceScale = static_cast<float>(gridZ) / logRatio;
+    sliceBias = static_cast<float>(gridZ) * std::log(this->near) / logRatio;
+
+    // x_ndc = (P00 * x + P20 * z) / -z, same for y
+    const glm::vec2 scale = { projection[0][0], projection[1][1] };
+    const glm::vec2 offset = { projection[2][0], projection[2][1] };
+
+    const auto sliceDepth = [&](const uint32_t slice)
+    {
+        return this->near * std::pow(this->far / this->near, static_cast<float>(slice) / gridZ);
+    };
+
+    // Tiles covered by [min, max] of the sphere in the [nearDepth, farDepth] depth range
+    const auto tileRange = [&](const float min, const float max, const float nearDepth, const float farDepth, const int axis, const int grid)
+    {
+        const float ndcMin = std::min(min / nearDepth, min / farDepth) * scale[axis] - offset[axis];
+        const float ndcMax = std::max(max / nearDepth, max / farDepth) * scale[axis] - offset[axis];
+
+        return std::pair
+        {
+            std::max(static_cast<int>(std::floor((ndcMin * 0.5f + 0.5f) * grid)), 0),
+            std::min(static_cast<int>(std::floor((ndcMax * 0.5f + 0.5f) * grid)), grid - 1)
+        };
+    };
+
+    std::ranges::fill(clusters, Cluster{ 0, 0 });
+    assignments.clear();
+
+    for(uint32_t i = 0; i < lights.size(); i++)
+    {
+        const auto& light = lights[i];
+
+        if(std::isinf(light.radius))
+        {
+            for(uint32_t cluster = 0; cluster < clusters.size(); cluster++)
+            {
+                clusters[cluster].count++;
+                assignments.emplace_back(cluster, i);
+            }
+
+            continue;
+        }
+
+        const glm::vec3 center = view * glm::vec4(light.position, 1.0f);
+        const float depth = -center.z;
+
+        // Entirely behind the near plane or beyond the far plane
+        if(depth + light.radius < this->near || depth - light.radius > this->far)
+            continue;
+
+        const float minDepth = std::max(depth - light.radius, this->near);
+        const float maxDepth = std::min(depth + light.radius, this->far);
+
+        const uint32_t lastSlice = GetSlice(maxDepth);
+
+        for(uint32_t z = GetSlice(minDepth); z <= lastSlice; z++)
+        {
+            const float nearDepth = std::max(sliceDepth(z), minDepth);
+            const float farDepth = std::min(sliceDepth(z + 1), maxDepth);
+
+            const auto [firstX, lastX] = tileRange(center.x - light.radius, center.x + light.radius, nearDepth, farDepth, 0, gridX);
+            const auto [firstY, lastY] = tileRange(center.y - light.radius, center.y + light.radius, nearDepth, farDepth, 1, gridY);
+
+            for(int y = firstY; y <= lastY; y++)
+                for(int x = firstX; x <= lastX; x++)
+                {
+                    const uint32_t cluster = x + y * gridX + z * gridX * gridY;
+
+                    clusters[cluster].count++;
+                    assignments.emplace_back(cluster, i);
+                }
+        }
+    }
+
+    uint32_t offsetInList = 0;
+
+    for(auto& cluster : clusters)
+    {
+        cluster.offset = offsetInList;
+        offsetInList += cluster.count;
+
+        cluster.count = 0; // Used as a cursor below
+    }
+
+    indices.resize(assignments.size());
+
+    // Assignments are in light order, so are the lists of every cluster
+    for(const auto& [cluster, light] : assignments)
+    {
+        auto& target = clusters[cluster];
+
+        indices[target.offset + target.count++] = light;
+    }
+}
+
+void LightClusters::Upload(const std::span<const Light> lights)
+{
+    Reserve(lightBuffer, lightCapacity, lights.size(), sizeof(Light));
+    Reserve(indexBuffer, indexCapacity, indices.size(), sizeof(uint32_t));
+
+    if(!lights.empty())
+        Renderer::Get().WriteBuffer(*lightBuffer, 0, lights.data(), lights.size_bytes());
+
+    if(!indices.empty())
+        Renderer::Get().WriteBuffer(*indexBuffer, 0, indices.data(), indices.size() * sizeof(uint32_t));
+
+    Renderer::Get().WriteBuffer(*clusterBuffer, 0, clusters.data(), clusters.size() * sizeof(Cluster));
+}
+
+float LightClusters::GetSliceScale() const
+{
+    return sliceScale;
+}
+
+float LightClusters::GetSliceBias() const
+{
+    return sliceBias;
+}
+
+size_t LightClusters::GetIndexCount() const
+{
+    return indices.size();
+}
+
+LLGL::Buffer* LightClusters::GetLightBuffer() const
+{
+    return lightBuffer;
+}
+
+LLGL::Buffer* LightClusters::GetClusterBuffer() const
+{
+    return clusterBuffer;
+}
+
+LLGL::Buffer* LightClusters::GetIndexBuffer() const
+{
+    return indexBuffer;
+}
+
+void LightClusters::Reserve(LLGL::Buffer*& buffer, uint64_t& capacity, const uint64_t count, const uint32_t stride)
+{
+    if(buffer && count <= capacity)
+        return;
+
+    capacity = std::max<uint64_t>(capacity, 1);
+
+    while(capacity < count)
+        capacity *= 2;
+
+    if(buffer)
+        Renderer::Get().Release(buffer);
+
+    LLGL::BufferDescriptor bufferDesc;
+
+    bufferDesc.size = capacity * stride;
+    bufferDesc.stride = stride;
+    bufferDesc.bindFlags = LLGL::BindFlags::Storage;
+
+    buffer = Renderer::Get().CreateBuffer(bufferDesc);
+}
+
+uint32_t LightClusters::GetSlice(const float depth) const
+{
+    const float slice = std::floor(std::log(depth) * sliceScale - sliceBias);
+
+    return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(gridZ - 1)));
+}
+
+}
@@ -1,10 +1,35 @@
 #include <Mesh.hpp>
 
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <limits>
+
 namespace lustra
 {
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const bool setupBuffers)
-            : vertices(vertices), indices(indices)
+// Half floats get coarser further from zero, at 4 the step is about 1/256
+constexpr float maxHalfCoord = 4.0f;
+
+static glm::vec2 EncodeOctahedral(glm::vec3 normal)
+{
+    normal /= std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+    glm::vec2 encoded(normal.x, normal.y);
+
+    if(normal.z < 0.0f)
+        encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x)))
+            * glm::vec2(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+
+    return encoded;
+}
+
+Mesh::Mesh(
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    const bool setupBuffers,
+    const bool compress
+) : vertices(vertices), indices(indices), compress(compress)
 {
     if(setupBuffers)
         SetupBuffers();
@@ -12,13 +37,34 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& ind
 
 void Mesh::SetupBuffers()
 {
-    vertexFormat = Renderer::Get().GetDefaultVertexFormat();
     matricesBuffer = Renderer::Get().GetMatricesBuffer();
 
-    CreateVertexBuffer();
+    // The compressed positions are relative to the bounds
+    ComputeBounds();
+
+    compressed = compress && skin.empty() && CanCompress();
+
+    if(!skin.empty())
+        CreateSkinnedVertexBuffer();
+    else if(compressed)
+        CreateCompressedVertexBuffers();
+    else
+        CreateVertexBuffer();
+
     CreateIndexBuffer();
 }
 
+void Mesh::ReleaseBuffers()
+{
+    for(auto buffer : { &vertexBuffer, &positionBuffer, &indexBuffer })
+    {
+        if(*buffer)
+            Renderer::Get().Release(*buffer);
+
+        *buffer = nullptr;
+    }
+}
+
 void Mesh::CreateCube()
 {
     vertices =
@@ -82,22 +128,54 @@ void Mesh::CreatePlane()
     SetupBuffers();
 }
 
-void Mesh::BindBuffers(LLGL::CommandBuffer* commandBuffer, const bool bindMatrices) const
+void Mesh::BindBuffers(LLGL::CommandBuffer* commandBuffer, const bool bindMatrices, const bool positionsOnly) const
 {
-    commandBuffer->SetVertexBuffer(*vertexBuffer);
+    commandBuffer->SetVertexBuffer(positionsOnly && positionBuffer ? *positionBuffer : *vertexBuffer);
     commandBuffer->SetIndexBuffer(*indexBuffer);
 
     if(bindMatrices)
     {
-        const auto matricesBinding = Renderer::Get().GetMatrices()->GetBinding();
+        auto matricesBinding = Renderer::Get().GetMatrices()->GetBinding();
+
+        if(compressed)
+        {
+            matricesBinding.positionScale = glm::vec4(bounds.max - bounds.min, 0.0f);
+            matricesBinding.positionOffset = glm::vec4(bounds.min, 1.0f);
+        }
 
         commandBuffer->UpdateBuffer(*matricesBuffer, 0, &matricesBinding, sizeof(Matrices::Binding));
     }
 }
 
-void Mesh::Draw(LLGL::CommandBuffer* commandBuffer) const
+void Mesh::Draw(LLGL::CommandBuffer* commandBuffer, const size_t lod) const
 {
-    commandBuffer->DrawIndexed(indices.size(), 0);
+    if(lod == 0 || lod >= lodRanges.size())
+    {
+        commandBuffer->DrawIndexed(indices.size(), 0);
+        return;
+    }
+
+    commandBuffer->DrawIndexed(lodRanges[lod].second, lodRanges[lod].first);
+}
+
+void Mesh::SetLods(std::vector<Lod> lods)
+{
+    this->lods = std::move(lods);
+}
+
+void Mesh::SetSkin(std::vector<VertexSkin> skin)
+{
+    this->skin = std::move(skin);
+}
+
+size_t Mesh::GetLodCount() const
+{
+    return lods.size() + 1;
+}
+
+float Mesh::GetLodError(const size_t lod) const
+{
+    return lod == 0 || lod > lods.size() ? 0.0f : lods[lod - 1].error;
 }
 
 std::vector<Vertex> Mesh::GetVertices() const
@@ -105,23 +183,169 @@ std::vector<Vertex> Mesh::GetVertices() const
     return vertices;
 }
 
-std::vector<uint32_t> Mesh::GetIndices() const
+std::vector<uint32_t> Mesh::GetIndices(const size_t lod) const
 {
-    return indices;
+    return lod == 0 || lod > lods.size() ? indices : lods[lod - 1].indices;
+}
+
+Mesh::Bounds Mesh::GetBounds() const
+{
+    return bounds;
+}
+
+bool Mesh::IsCompressed() const
+{
+    return compressed;
+}
+
+bool Mesh::IsSkinned() const
+{
+    return !skin.empty();
 }
 
 void Mesh::CreateVertexBuffer()
 {
+    const auto vertexFormat = Renderer::Get().GetDefaultVertexFormat();
     const auto bufferDesc = LLGL::VertexBufferDesc(vertices.size() * sizeof(Vertex), vertexFormat);
 
     vertexBuffer = Renderer::Get().CreateBuffer(bufferDesc, vertices.data());
 }
 
+void Mesh::CreateSkinnedVertexBuffer()
+{
+    struct SkinnedVertex
+    {
+        Vertex vertex;
+        VertexSkin skin;
+    };
+
+    static_assert(sizeof(SkinnedVertex) == sizeof(Vertex) + sizeof(VertexSkin));
+
+    std::vector<SkinnedVertex> skinnedVertices;
+    skinnedVertices.reserve(vertices.size());
+
+    for(size_t i = 0; i < vertices.size(); i++)
+        skinnedVertices.push_back({ vertices[i], i < skin.size() ? skin[i] : VertexSkin{} });
+
+    const auto vertexFormat = Renderer::Get().GetSkinnedVertexFormat();
+    const auto bufferDesc = LLGL::VertexBufferDesc(skinnedVertices.size() * sizeof(SkinnedVertex), vertexFormat);
+
+    vertexBuffer = Renderer::Get().CreateBuffer(bufferDesc, skinnedVertices.data());
+}
+
+void Mesh::CreateCompressedVertexBuffers()
+{
+    // The OpenGL backend takes the attribute formats from the buffer and the normalized integers and
+    // half floats arrive in the shaders as floats, so the same shaders read both kinds of meshes
+    LLGL::VertexFormat vertexFormat;
+    vertexFormat.AppendAttribute({ "position", LLGL::Format::RGBA16UNorm });
+    vertexFormat.AppendAttribute({ "normal", LLGL::Format::RG16SNorm });
+    vertexFormat.AppendAttribute({ "texCoord", LLGL::Format::RG16Float });
+
+    LLGL::VertexFormat positionFormat;
+    positionFormat.AppendAttribute({ "position", LLGL::Format::RGBA16UNorm });
+
+    const auto extent = bounds.max - bounds.min;
+    const auto scale = glm::vec3(
+        extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+        extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+        extent.z > 0.0f ? 1.0f / extent.z : 0.0f
+    );
+
+    std::vector<CompressedVertex> compressedVertices;
+    compressedVertices.reserve(vertices.size());
+
+    for(const auto& vertex : vertices)
+    {
+        const auto position = glm::clamp((vertex.position - bounds.min) * scale, 0.0f, 1.0f);
+        const auto normal = EncodeOctahedral(vertex.normal);
+
+        compressedVertices.push_back(
+            {
+                .position =
+                {
+                    glm::packUnorm1x16(position.x),
+                    glm::packUnorm1x16(position.y),
+                    glm::packUnorm1x16(position.z),
+                    0
+                },
+                .normal =
+                {
+                    static_cast<int16_t>(glm::packSnorm1x16(normal.x)),
+                    static_cast<int16_t>(glm::packSnorm1x16(normal.y))
+                },
+                .coords = { glm::packHalf1x16(vertex.coords.x), glm::packHalf1x16(vertex.coords.y) }
+            }
+        );
+    }
+
+    vertexBuffer = Renderer::Get().CreateBuffer(
+        LLGL::VertexBufferDesc(compressedVertices.size() * sizeof(CompressedVertex), vertexFormat),
+        compressedVertices.data()
+    );
+
+    std::vector<std::array<uint16_t, 4>> positions;
+    positions.reserve(compressedVertices.size());
+
+    for(const auto& vertex : compressedVertices)
+        positions.push_back(vertex.position);
+
+    positionBuffer = Renderer::Get().CreateBuffer(
+        LLGL::VertexBufferDesc(positions.size() * sizeof(positions[0]), positionFormat),
+        positions.data()
+    );
+}
+
 void Mesh::CreateIndexBuffer()
 {
-    const auto bufferDesc = LLGL::IndexBufferDesc(indices.size() * sizeof(uint32_t), LLGL::Format::R32UInt);
+    auto allIndices = indices;
+
+    lodRanges = { { 0, static_cast<uint32_t>(indices.size()) } };
 
-    indexBuffer = Renderer::Get().CreateBuffer(bufferDesc, indices.data());
+    for(const auto& lod : lods)
+    {
+        lodRanges.emplace_back(static_cast<uint32_t>(allIndices.size()), static_cast<uint32_t>(lod.indices.size()));
+
+        allIndices.insert(allIndices.end(), lod.indices.begin(), lod.indices.end());
+    }
+
+    // Half the memory and the bandwidth if every index fits into 16 bits
+    if(vertices.size() <= std::numeric_limits<uint16_t>::max() + 1ull)
+    {
+        const std::vector<uint16_t> shortIndices(allIndices.begin(), allIndices.end());
+
+        const auto bufferDesc = LLGL::IndexBufferDesc(shortIndices.size() * sizeof(uint16_t), LLGL::Format::R16UInt);
+
+        indexBuffer = Renderer::Get().CreateBuffer(bufferDesc, shortIndices.data());
+
+        return;
+    }
+
+    const auto bufferDesc = LLGL::IndexBufferDesc(allIndices.size() * sizeof(uint32_t), LLGL::Format::R32UInt);
+
+    indexBuffer = Renderer::Get().CreateBuffer(bufferDesc, allIndices.data());
+}
+
+void Mesh::ComputeBounds()
+{
+    if(vertices.empty())
+        return;
+
+    bounds = { vertices[0].position, vertices[0].position };
+
+    for(const auto& vertex : vertices)
+    {
+        bounds.min = glm::min(bounds.min, vertex.position);
+        bounds.max = glm::max(bounds.max, vertex.position);
+    }
+}
+
+bool Mesh::CanCompress() const
+{
+    return !vertices.empty() && std::ranges::all_of(vertices, [](const Vertex& vertex)
+    {
+        return std::abs(vertex.coords.x) <= maxHalfCoord && std::abs(vertex.coords.y) <= maxHalfCoord;
+    });
 }
 
 }
@@ -0,0 +1,700 @@
+#include <MeshOptimizer.hpp>
+#include <Hash.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace lustra
+{
+
+constexpr auto invalidVertex = std::numeric_limits<uint32_t>::max();
+
+// Sum of the squared distances to a set of planes, weighted by the areas of their triangles
+struct Quadric
+{
+    // Upper triangle of the symmetric 4x4 matrix
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+    double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+    double a22 = 0.0, a23 = 0.0;
+    double a33 = 0.0;
+
+    double weight = 0.0;
+
+    static Quadric FromPlane(const glm::dvec3& normal, const double distance, const double weight)
+    {
+        return
+        {
+            normal.x * normal.x * weight, normal.x * normal.y * weight, normal.x * normal.z * weight, normal.x * distance * weight,
+            normal.y * normal.y * weight, normal.y * normal.z * weight, normal.y * distance * weight,
+            normal.z * normal.z * weight, normal.z * distance * weight,
+            distance * distance * weight,
+            weight
+        };
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+        a11 += other.a11; a12 += other.a12; a13 += other.a13;
+        a22 += other.a22; a23 += other.a23;
+        a33 += other.a33;
+
+        weight += other.weight;
+
+        return *this;
+    }
+
+    // Mean squared distance of the point to the planes
+    double Evaluate(const glm::dvec3& p) const
+    {
+        const auto error =
+            p.x * p.x * a00 + 2.0 * p.x * p.y * a01 + 2.0 * p.x * p.z * a02 + 2.0 * p.x * a03
+            + p.y * p.y * a11 + 2.0 * p.y * p.z * a12 + 2.0 * p.y * a13
+            + p.z * p.z * a22 + 2.0 * p.z * a23
+            + a33;
+
+        return weight > 0.0 ? std::abs(error) / weight : 0.0;
+    }
+};
+
+// Triangles around every vertex, adjacency[offsets[v]..offsets[v + 1]]
+static void BuildAdjacency(
+    const std::vector<uint32_t>& indices,
+    const size_t vertexCount,
+    std::vector<uint32_t>& offsets,
+    std::vector<uint32_t>& adjacency
+)
+{
+    offsets.assign(vertexCount + 1, 0);
+
+    for(const auto index : indices)
+        offsets[index + 1]++;
+
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    adjacency.resize(indices.size());
+
+    auto fill = offsets;
+
+    for(size_t i = 0; i < indices.size(); i++)
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+}
+
+float MeshOptimizer::Statistics::GetACMR() const
+{
+    return triangles ? static_cast<float>(misses) / static_cast<float>(triangles) : 0.0f;
+}
+
+float MeshOptimizer::Statistics::GetOptimizedACMR() const
+{
+    return triangles ? static_cast<float>(optimizedMisses) / static_cast<float>(triangles) : 0.0f;
+}
+
+MeshOptimizer::Statistics& MeshOptimizer::Statistics::operator+=(const Statistics& other)
+{
+    triangles += other.triangles;
+    vertices += other.vertices;
+    optimizedVertices += other.optimizedVertices;
+    misses += other.misses;
+    optimizedMisses += other.optimizedMisses;
+    lods += other.lods;
+
+    return *this;
+}
+
+MeshOptimizer::Statistics MeshOptimizer::Optimize(
+    std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    std::vector<VertexSkin>* skin
+)
+{
+    Statistics statistics
+    {
+        .triangles = indices.size() / 3,
+        .vertices = vertices.size(),
+        .optimizedVertices = vertices.size(),
+        .misses = CountCacheMisses(indices, vertices.size())
+    };
+
+    statistics.optimizedMisses = statistics.misses;
+
+    // Lines and points aren't worth it
+    if(indices.empty() || indices.size() % 3)
+        return statistics;
+
+    const auto clusters = OptimizeVertexCache(indices, vertices.size());
+
+    OptimizeOverdraw(indices, vertices, clusters);
+    OptimizeVertexFetch(vertices, indices, skin);
+
+    statistics.optimizedVertices = vertices.size();
+    statistics.optimizedMisses = CountCacheMisses(indices, vertices.size());
+
+    return statistics;
+}
+
+size_t MeshOptimizer::CountCacheMisses(const std::vector<uint32_t>& indices, const size_t vertexCount)
+{
+    // A vertex is in the FIFO cache if less than cacheSize vertices were added after it
+    std::vector<size_t> cacheTime(vertexCount, 0);
+
+    size_t time = cacheSize + 1, misses = 0;
+
+    for(const auto index : indices)
+    {
+        if(time - cacheTime[index] > cacheSize)
+        {
+            cacheTime[index] = time++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
+
+std::vector<size_t> MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, const size_t vertexCount)
+{
+    const auto triangleCount = indices.size() / 3;
+
+    std::vector<uint32_t> offsets, adjacency;
+    BuildAdjacency(indices, vertexCount, offsets, adjacency);
+
+    std::vector<uint32_t> liveTriangles(vertexCount);
+
+    for(size_t i = 0; i < vertexCount; i++)
+        liveTriangles[i] = offsets[i + 1] - offsets[i];
+
+    std::vector<size_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+
+    std::vector<uint32_t> deadEnd, candidates, result;
+    result.reserve(indices.size());
+
+    std::vector<size_t> clusters;
+
+    size_t time = cacheSize + 1;
+    uint32_t cursor = 0;
+
+    // The recently used vertices first, then whatever comes next in the input
+    const auto skipDeadEnd = [&]()
+    {
+        while(!deadEnd.empty())
+        {
+            const auto vertex = deadEnd.back();
+            deadEnd.pop_back();
+
+            if(liveTriangles[vertex])
+                return vertex;
+        }
+
+        for(; cursor < vertexCount; cursor++)
+            if(liveTriangles[cursor])
+                return cursor;
+
+        return invalidVertex;
+    };
+
+    auto fanning = skipDeadEnd();
+
+    while(fanning != invalidVertex)
+    {
+        candidates.clear();
+
+        // All remaining triangles around the fanning vertex
+        for(auto i = offsets[fanning]; i < offsets[fanning + 1]; i++)
+        {
+            const auto triangle = adjacency[i];
+
+            if(emitted[triangle])
+                continue;
+
+            for(int j = 0; j < 3; j++)
+            {
+                const auto vertex = indices[triangle * 3 + j];
+
+                result.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+
+                liveTriangles[vertex]--;
+
+                if(time - cacheTime[vertex] > cacheSize)
+                    cacheTime[vertex] = time++;
+            }
+
+            emitted[triangle] = true;
+        }
+
+        // The oldest candidate that stays in the cache while its triangles are emitted
+        auto next = invalidVertex;
+        int64_t bestPriority = -1;
+
+        for(const auto vertex : candidates)
+        {
+            if(!liveTriangles[vertex])
+                continue;
+
+            int64_t priority = 0;
+
+            if(time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+                priority = static_cast<int64_t>(time - cacheTime[vertex]);
+
+            if(priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if(next == invalidVertex)
+        {
+            next = skipDeadEnd();
+
+            // Jumping elsewhere loses whatever is in the cache
+            if(next != invalidVertex)
+                clusters.push_back(result.size() / 3);
+        }
+
+        fanning = next;
+    }
+
+    indices = std::move(result);
+
+    clusters.insert(clusters.begin(), 0);
+
+    return clusters;
+}
+
+void MeshOptimizer::OptimizeOverdraw(
+    std::vector<uint32_t>& indices,
+    const std::vector<Vertex>& vertices,
+    const std::vector<size_t>& hardClusters,
+    const float threshold
+)
+{
+    const auto triangleCount = indices.size() / 3;
+    const auto clusters = SplitClusters(indices, vertices.size(), hardClusters, threshold);
+
+    glm::vec3 meshCenter(0.0f);
+
+    for(const auto& vertex : vertices)
+        meshCenter += vertex.position;
+
+    meshCenter /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+
+    // The clusters facing away from the center are more likely to occlude the others
+    std::vector<float> sortKeys(clusters.size());
+
+    for(size_t i = 0; i < clusters.size(); i++)
+    {
+        const auto end = i + 1 < clusters.size() ? clusters[i + 1] : triangleCount;
+
+        glm::vec3 normal(0.0f), center(0.0f);
+        float area = 0.0f;
+
+        for(auto j = clusters[i]; j < end; j++)
+        {
+            const auto& p0 = vertices[indices[j * 3]].position;
+            const auto& p1 = vertices[indices[j * 3 + 1]].position;
+            const auto& p2 = vertices[indices[j * 3 + 2]].position;
+
+            const auto triangleNormal = glm::cross(p1 - p0, p2 - p0);
+            const auto triangleArea = glm::length(triangleNormal);
+
+            normal += triangleNormal;
+            center += (p0 + p1 + p2) / 3.0f * triangleArea;
+            area += triangleArea;
+        }
+
+        const auto normalLength = glm::length(normal);
+
+        if(area > 0.0f && normalLength > 0.0f)
+            sortKeys[i] = glm::dot(center / area - meshCenter, normal / normalLength);
+    }
+
+    std::vector<size_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::ranges::stable_sort(order, [&](const size_t a, const size_t b)
+    {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    for(const auto cluster : order)
+    {
+        const auto end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+
+        result.insert(result.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + end * 3);
+    }
+
+    indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(
+    std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    std::vector<VertexSkin>* skin
+)
+{
+    std::vector<uint32_t> remap(vertices.size(), invalidVertex);
+
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    std::vector<VertexSkin> skinResult;
+
+    if(skin)
+        skinResult.reserve(skin->size());
+
+    for(auto& index : indices)
+    {
+        if(remap[index] == invalidVertex)
+        {
+            remap[index] = static_cast<uint32_t>(result.size());
+            result.push_back(vertices[index]);
+
+            if(skin)
+                skinResult.push_back((*skin)[index]);
+        }
+
+        index = remap[index];
+    }
+
+    vertices = std::move(result);
+
+    if(skin)
+        *skin = std::move(skinResult);
+}
+
+std::vector<uint32_t> MeshOptimizer::Simplify(
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    const size_t targetIndexCount,
+    const float maxError,
+    float& error
+)
+{
+    error = 0.0f;
+
+    if(vertices.empty() || indices.size() % 3)
+        return indices;
+
+    const auto vertexCount = vertices.size();
+
+    glm::vec3 min = vertices[0].position, max = vertices[0].position;
+
+    for(const auto& vertex : vertices)
+    {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+
+    const auto size = static_cast<double>(glm::length(max - min));
+
+    if(size <= 0.0)
+        return indices;
+
+    // A vertex with the same position as another one lies on a UV seam, moving it would tear the seam open
+    std::unordered_map<uint64_t, uint32_t> positionCount;
+
+    const auto positionKey = [&](const uint32_t vertex)
+    {
+        const auto& position = vertices[vertex].position;
+
+        return Hash().Add(position.x).Add(position.y).Add(position.z).Get();
+    };
+
+    for(size_t i = 0; i < vertexCount; i++)
+        positionCount[positionKey(static_cast<uint32_t>(i))]++;
+
+    // An edge with only one triangle is a border, collapsing it would shrink the hole or the outline
+    std::unordered_map<uint64_t, uint32_t> edgeCount;
+
+    const auto edgeKey = [](const uint32_t a, const uint32_t b)
+    {
+        return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+    };
+
+    for(size_t i = 0; i < indices.size(); i += 3)
+        for(int j = 0; j < 3; j++)
+            edgeCount[edgeKey(indices[i + j], indices[i + (j + 1) % 3])]++;
+
+    std::vector<bool> seam(vertexCount), border(vertexCount);
+
+    for(size_t i = 0; i < vertexCount; i++)
+        seam[i] = positionCount[positionKey(static_cast<uint32_t>(i))] > 1;
+
+    for(size_t i = 0; i < indices.size(); i += 3)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            const auto a = indices[i + j], b = indices[i + (j + 1) % 3];
+
+            if(edgeCount[edgeKey(a, b)] == 1)
+                border[a] = border[b] = true;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+
+    for(size_t i = 0; i < indices.size(); i += 3)
+    {
+        const glm::dvec3 p0 = vertices[indices[i]].position;
+        const glm::dvec3 p1 = vertices[indices[i + 1]].position;
+        const glm::dvec3 p2 = vertices[indices[i + 2]].position;
+
+        const auto normal = glm::cross(p1 - p0, p2 - p0);
+        const auto area = glm::length(normal);
+
+        if(area <= 0.0)
+            continue;
+
+        const auto plane = Quadric::FromPlane(normal / area, -glm::dot(normal / area, p0), area);
+
+        for(int j = 0; j < 3; j++)
+            quadrics[indices[i + j]] += plane;
+    }
+
+    struct Collapse
+    {
+        uint32_t from, to;
+        double cost;
+    };
+
+    const auto maxCost = std::pow(static_cast<double>(maxError) * size, 2.0);
+
+    auto result = indices;
+
+    std::vector<uint32_t> offsets, adjacency, remap(vertexCount);
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(vertexCount);
+
+    double resultCost = 0.0;
+
+    // A collapse would turn the triangle around
+    const auto flips = [&](const uint32_t from, const uint32_t to)
+    {
+        for(auto i = offsets[from]; i < offsets[from + 1]; i++)
+        {
+            const auto triangle = &result[adjacency[i] * 3];
+
+            if(triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                continue;
+
+            glm::vec3 before[3], after[3];
+
+            for(int j = 0; j < 3; j++)
+            {
+                before[j] = vertices[triangle[j]].position;
+                after[j] = vertices[triangle[j] == from ? to : triangle[j]].position;
+            }
+
+            const auto normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const auto normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+            if(glm::dot(normalBefore, normalAfter) <= 0.0f)
+                return true;
+        }
+
+        return false;
+    };
+
+    // Every pass collapses edges that don't share vertices, so they can't interfere with each other
+    while(result.size() > targetIndexCount)
+    {
+        BuildAdjacency(result, vertexCount, offsets, adjacency);
+
+        collapses.clear();
+
+        for(size_t i = 0; i < result.size(); i += 3)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                const auto a = result[i + j], b = result[i + (j + 1) % 3];
+
+                auto quadric = quadrics[a];
+                quadric += quadrics[b];
+
+                for(const auto [from, to] : { std::pair(a, b), std::pair(b, a) })
+                    if(!seam[from] && !border[from] && !seam[to])
+                        collapses.push_back({ from, to, quadric.Evaluate(vertices[to].position) });
+            }
+        }
+
+        std::ranges::sort(collapses, {}, &Collapse::cost);
+
+        std::ranges::fill(touched, false);
+        std::iota(remap.begin(), remap.end(), 0);
+
+        auto triangleCount = result.size() / 3;
+        const auto targetTriangleCount = targetIndexCount / 3;
+
+        size_t collapsed = 0;
+
+        for(const auto& [from, to, cost] : collapses)
+        {
+            if(cost > maxCost || triangleCount <= targetTriangleCount)
+                break;
+
+            if(touched[from] || touched[to] || flips(from, to))
+                continue;
+
+            remap[from] = to;
+            quadrics[to] += quadrics[from];
+
+            resultCost = std::max(resultCost, cost);
+
+            for(auto i = offsets[from]; i < offsets[from + 1]; i++)
+            {
+                const auto triangle = &result[adjacency[i] * 3];
+
+                if(triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                    triangleCount--;
+
+                for(int j = 0; j < 3; j++)
+                    touched[triangle[j]] = true;
+            }
+
+            collapsed++;
+        }
+
+        if(!collapsed)
+            break;
+
+        std::vector<uint32_t> remapped;
+        remapped.reserve(result.size());
+
+        for(size_t i = 0; i < result.size(); i += 3)
+        {
+            const auto a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+
+            if(a != b && b != c && a != c)
+                remapped.insert(remapped.end(), { a, b, c });
+        }
+
+        result = std::move(remapped);
+    }
+
+    error = static_cast<float>(std::sqrt(resultCost) / size);
+
+    return result;
+}
+
+std::vector<Mesh::Lod> MeshOptimizer::GenerateLods(
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    const size_t maxLods,
+    const float maxError
+)
+{
+    std::vector<Mesh::Lod> lods;
+
+    auto previousCount = indices.size();
+
+    for(size_t i = 0; i < maxLods; i++)
+    {
+        // Every level starts from the full detail, so the errors don't add up
+        const auto target = indices.size() / 3 / (2ull << i) * 3;
+
+        float error = 0.0f;
+        auto lodIndices = Simplify(vertices, indices, target, maxError, error);
+
+        // The error bound doesn't let it go much further
+        if(static_cast<float>(lodIndices.size()) > static_cast<float>(previousCount) * 0.8f)
+            break;
+
+        OptimizeVertexCache(lodIndices, vertices.size());
+
+        previousCount = lodIndices.size();
+
+        lods.push_back({ std::move(lodIndices), error });
+    }
+
+    return lods;
+}
+
+std::vector<size_t> MeshOptimizer::SplitClusters(
+    const std::vector<uint32_t>& indices,
+    const size_t vertexCount,
+    const std::vector<size_t>& hardClusters,
+    const float threshold
+)
+{
+    const auto triangleCount = indices.size() / 3;
+
+    std::vector<size_t> cacheTime(vertexCount, 0);
+    size_t time = cacheSize + 1;
+
+    const auto countMisses = [&](const size_t triangle)
+    {
+        size_t misses = 0;
+
+        for(int i = 0; i < 3; i++)
+        {
+            const auto vertex = indices[triangle * 3 + i];
+
+            if(time - cacheTime[vertex] > cacheSize)
+            {
+                cacheTime[vertex] = time++;
+                misses++;
+            }
+        }
+
+        return misses;
+    };
+
+    // Pushing the time past the cache size empties it
+    const auto flush = [&]() { time += cacheSize + 1; };
+
+    std::vector<size_t> result;
+
+    for(size_t i = 0; i < hardClusters.size(); i++)
+    {
+        const auto start = hardClusters[i];
+        const auto end = i + 1 < hardClusters.size() ? hardClusters[i + 1] : triangleCount;
+
+        if(start == end)
+            continue;
+
+        flush();
+
+        size_t misses = 0;
+
+        for(auto j = start; j < end; j++)
+            misses += countMisses(j);
+
+        // A split cluster starts with an empty cache, so it may not be much worse than the whole one
+        const auto clusterThreshold = threshold * static_cast<float>(misses) / static_cast<float>(end - start);
+
+        flush();
+
+        result.push_back(start);
+
+        auto clusterStart = start;
+        misses = 0;
+
+        for(auto j = start; j < end; j++)
+        {
+            misses += countMisses(j);
+
+            if(j + 1 < end && static_cast<float>(misses) / static_cast<float>(j - clusterStart + 1) <= clusterThreshold)
+            {
+                result.push_back(j + 1);
+
+                clusterStart = j + 1;
+                misses = 0;
+
+                flush();
+            }
+        }
+    }
+
+    return result;
+}
+
+}
@@ -1,20 +1,41 @@
 #include <PBRManager.hpp>
 #include <ShaderAsset.hpp>
+#include <Hash.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 
 namespace lustra
 {
 
+// Bumped whenever the layout of the cache files changes
+constexpr uint32_t cacheVersion = 1;
+
+// The least recently used files are removed past that, a 1024x1024 environment takes about 40 MB
+constexpr uintmax_t maxCacheSize = 512ull * 1024 * 1024;
+
 PBRManager::PBRManager()
 {
     SetupConvertPipeline();
     SetupIrradiancePipeline();
     SetupPrefilteredPipeline();
     SetupBRDFPipeline();
+    SetupSHPipelines();
 
-    CreateBRDFTexture({ 256, 256 });
-    CreateBRDFRenderTarget({ 256, 256 });
+    CreateSHTexture();
 
-    RenderBRDF();
+    Hash hash;
+
+    hash.Add(Renderer::Get().GetShaderHash(AssetManager::Get().Load<VertexShaderAsset>("skybox.vert", true)->shader));
+
+    for(const auto name : { "HDRIConvert.frag", "irradiance.frag", "prefilter.frag" })
+        hash.Add(Renderer::Get().GetShaderHash(AssetManager::Get().Load<FragmentShaderAsset>(name, true)->shader));
+
+    shadersKey = hash.Get();
+
+    SetupBRDF();
 }
 
 EnvironmentAssetPtr PBRManager::Build(
@@ -22,13 +43,196 @@ EnvironmentAssetPtr PBRManager::Build(
     const TextureAssetPtr& environmentMap,
     EnvironmentAssetPtr environmentAsset,
     LLGL::PipelineState* customConvertPipeline,
+    const std::function<void(LLGL::CommandBuffer*)>& setConvertUniforms,
+    const uint64_t cacheKey
+)
+{
+    // The previous textures belong to the previous environment asset, which releases them itself
+    CreateCubemaps(resolution);
+
+    const auto key = cacheKey
+        ? Hash().Add(cacheKey).Add(shadersKey).Add(resolution.width).Add(resolution.height).Get()
+        : 0;
+
+    if(!key || !LoadEnvironment(key, resolution))
+    {
+        RenderEnvironment(resolution, environmentMap, customConvertPipeline, setConvertUniforms);
+
+        if(key)
+            StoreEnvironment(key, resolution);
+    }
+
+    if(environmentAsset)
+    {
+        environmentAsset->cubeMap = cubeMap;
+        environmentAsset->irradiance = irradiance;
+        environmentAsset->prefiltered = prefiltered;
+        environmentAsset->brdf = brdf;
+    }
+    else
+        environmentAsset = std::make_shared<EnvironmentAsset>(cubeMap, irradiance, prefiltered, brdf);
+
+    environmentAsset->loaded = true;
+
+    return environmentAsset;
+}
+
+void PBRManager::SetCacheDirectory(const std::filesystem::path& path)
+{
+    cacheDirectory = path;
+}
+
+PBRManager::IncrementalBuild PBRManager::BeginBuild(
+    const LLGL::Extent2D& resolution,
+    const TextureAssetPtr& environmentMap,
+    LLGL::PipelineState* customConvertPipeline,
     const std::function<void(LLGL::CommandBuffer*)>& setConvertUniforms
 )
 {
-    if(!cubeMap || !environmentAsset || resolution != renderTargets[0]->GetResolution())
-        CreateCubemaps(resolution);
+    return
+    {
+        .resolution = resolution,
+        .environmentMap = environmentMap,
+        .convertPipeline = customConvertPipeline ? customConvertPipeline : pipelineConvert,
+        .setConvertUniforms = setConvertUniforms,
+        .cubeMap = CreateCubeMap(resolution),
+        .irradiance = CreateCubeMap({ resolution.width / 32, resolution.height / 32 }),
+        .prefiltered = CreateCubeMap({ resolution.width / 6, resolution.height / 6 })
+    };
+}
+
+bool PBRManager::Step(IncrementalBuild& build)
+{
+    for(const auto renderTarget : build.renderTargets)
+        Renderer::Get().Release(renderTarget);
 
-    ReleaseRenderTargets();
+    build.renderTargets.clear();
+
+    constexpr uint32_t facesNum = 6;
+
+    const auto mipsNum = LLGL::NumMipLevels(build.resolution.width / 6, build.resolution.height / 6);
+
+    // Faces of the cube map, then the irradiance, then the mip levels of the prefiltered map
+    if(build.step >= facesNum + 1 + mipsNum)
+        return true;
+
+    const auto matrices = Renderer::Get().GetMatrices();
+
+    matrices->PushMatrix();
+
+    matrices->GetModel() = glm::mat4(1.0f);
+    matrices->GetProjection() = projection;
+
+    const auto renderTarget = [&](LLGL::Texture* texture, const uint32_t mipLevel, const uint32_t face)
+    {
+        const auto extent = texture->GetMipExtent(mipLevel);
+
+        build.renderTargets.push_back(
+            Renderer::Get().CreateRenderTarget(
+                { extent.width, extent.height },
+                { LLGL::AttachmentDescriptor(texture, mipLevel, face) }
+            )
+        );
+
+        return build.renderTargets.back();
+    };
+
+    const auto sampler = build.environmentMap->sampler;
+
+    Renderer::Get().Begin(false);
+
+    if(build.step < facesNum)
+    {
+        RenderFace(
+            {
+                { 1, build.environmentMap->texture },
+                { 2, sampler }
+            },
+            renderTarget(build.cubeMap, 0, build.step),
+            static_cast<int>(build.step),
+            build.convertPipeline,
+            build.setConvertUniforms
+        );
+    }
+    else if(build.step == facesNum)
+    {
+        // The projection reads a low mip level of the cube map
+        Renderer::Get().GenerateMips(build.cubeMap, false);
+
+        ProjectSH(build.cubeMap, sampler);
+
+        for(uint32_t i = 0; i < facesNum; i++)
+        {
+            RenderFace(
+                {
+                    { 1, shCoefficients },
+                    { 2, sampler }
+                },
+                renderTarget(build.irradiance, 0, i),
+                static_cast<int>(i),
+                pipelineIrradianceSH
+            );
+        }
+
+        Renderer::Get().GenerateMips(build.irradiance, false);
+    }
+    else
+    {
+        const int mipLevel = static_cast<int>(build.step - facesNum - 1);
+
+        const auto setUniforms = [&](auto commandBuffer)
+        {
+            float roughness = static_cast<float>(mipLevel) / static_cast<float>(mipsNum - 1);
+
+            commandBuffer->SetUniforms(0, &roughness, sizeof(roughness));
+            commandBuffer->SetUniforms(1, &mipLevel, sizeof(mipLevel));
+        };
+
+        for(uint32_t i = 0; i < facesNum; i++)
+        {
+            RenderFace(
+                {
+                    { 1, build.cubeMap },
+                    { 2, sampler }
+                },
+                renderTarget(build.prefiltered, mipLevel, i),
+                static_cast<int>(i),
+                pipelinePrefiltered,
+                setUniforms
+            );
+        }
+    }
+
+    Renderer::Get().End();
+
+    Renderer::Get().Submit();
+
+    matrices->PopMatrix();
+
+    build.step++;
+
+    return false;
+}
+
+void PBRManager::Cancel(IncrementalBuild& build) const
+{
+    for(const auto renderTarget : build.renderTargets)
+        Renderer::Get().Release(renderTarget);
+
+    Renderer::Get().Release(build.cubeMap);
+    Renderer::Get().Release(build.irradiance);
+    Renderer::Get().Release(build.prefiltered);
+
+    build = {};
+}
+
+void PBRManager::RenderEnvironment(
+    const LLGL::Extent2D& resolution,
+    const TextureAssetPtr& environmentMap,
+    LLGL::PipelineState* customConvertPipeline,
+    const std::function<void(LLGL::CommandBuffer*)>& setConvertUniforms
+)
+{
     CreateRenderTargets(resolution, cubeMap);
 
     RenderCubeMap(
@@ -65,19 +269,70 @@ EnvironmentAssetPtr PBRManager::Build(
         pipelinePrefiltered
     );
 
-    if(environmentAsset)
-    {
-        environmentAsset->cubeMap = cubeMap;
-        environmentAsset->irradiance = irradiance;
-        environmentAsset->prefiltered = prefiltered;
-        environmentAsset->brdf = brdf;
-    }
-    else
-        environmentAsset = std::make_shared<EnvironmentAsset>(cubeMap, irradiance, prefiltered, brdf);
+    ReleaseRenderTargets();
+}
 
-    environmentAsset->loaded = true;
+void PBRManager::RenderFace(
+    const std::unordered_map<uint32_t, LLGL::Resource*>& resources,
+    LLGL::RenderTarget* renderTarget,
+    const int face,
+    LLGL::PipelineState* pipeline,
+    const std::function<void(LLGL::CommandBuffer*)>& setUniforms
+)
+{
+    const auto cube = AssetManager::Get().Load<ModelAsset>("cube", true)->meshes[0];
 
-    return environmentAsset;
+    Renderer::Get().GetMatrices()->GetView() = views[face];
+
+    Renderer::Get().ClearRenderTarget(renderTarget, false);
+
+    Renderer::Get().RenderPass(
+        [&](auto commandBuffer)
+        {
+            cube->BindBuffers(commandBuffer);
+        },
+        {
+            { 0, Renderer::Get().GetMatricesBuffer() },
+            { 1, resources.at(1) },
+            { 2, resources.at(2) }
+        },
+        [&](auto commandBuffer)
+        {
+            if(setUniforms)
+                setUniforms(commandBuffer);
+
+            cube->Draw(commandBuffer);
+        },
+        pipeline,
+        renderTarget
+    );
+}
+
+void PBRManager::ProjectSH(LLGL::Texture* cubeMap, LLGL::Sampler* sampler) const
+{
+    const auto plane = AssetManager::Get().Load<ModelAsset>("plane", true)->meshes[0];
+
+    // About 16 texels per face
+    const float lod = std::max(std::log2(static_cast<float>(cubeMap->GetMipExtent(0).width)) - 4.0f, 0.0f);
+
+    Renderer::Get().RenderPass(
+        [&](auto commandBuffer)
+        {
+            plane->BindBuffers(commandBuffer, false);
+        },
+        {
+            { 0, cubeMap },
+            { 1, sampler }
+        },
+        [&](auto commandBuffer)
+        {
+            commandBuffer->SetUniforms(0, &lod, sizeof(lod));
+
+            plane->Draw(commandBuffer);
+        },
+        pipelineSHProject,
+        shRenderTarget
+    );
 }
 
 void PBRManager::RenderCubeMap(
@@ -96,39 +351,15 @@ void PBRManager::RenderCubeMap(
     matrices->GetModel() = glm::mat4(1.0f);
     matrices->GetProjection() = projection;
 
-    auto cube = AssetManager::Get().Load<ModelAsset>("cube", true)->meshes[0];
+    // All faces go into one submission, every face has its own target so it's cleared separately
+    Renderer::Get().Begin(false);
 
     for(int i = 0; i < 6; i++)
-    {
-        matrices->GetView() = views[i];
-
-        Renderer::Get().Begin();
-
-        Renderer::Get().RenderPass(
-            [&](auto commandBuffer)
-            {
-                cube->BindBuffers(commandBuffer);
-            },
-            {
-                { 0, Renderer::Get().GetMatricesBuffer() },
-                { 1, resources.at(1) },
-                { 2, resources.at(2) }
-            },
-            [&](auto commandBuffer)
-            {
-                if(setUniforms)
-                    setUniforms(commandBuffer);
-
-                cube->Draw(commandBuffer);
-            },
-            pipeline,
-            renderTargets[i]
-        );
+        RenderFace(resources, renderTargets[i], i, pipeline, setUniforms);
 
-        Renderer::Get().End();
+    Renderer::Get().End();
 
-        Renderer::Get().Submit();
-    }
+    Renderer::Get().Submit();
 
     Renderer::Get().GenerateMips(cubeMap);
 
@@ -150,8 +381,6 @@ void PBRManager::RenderCubeMapMips(
     matrices->GetModel() = glm::mat4(1.0f);
     matrices->GetProjection() = projection;
 
-    auto cube = AssetManager::Get().Load<ModelAsset>("cube", true)->meshes[0];
-
     const auto initialResolution = renderTargets[0]->GetResolution();
 
     const auto mipsNum =
@@ -162,39 +391,23 @@ void PBRManager::RenderCubeMapMips(
 
     for(int i = 0; i < mipsNum; i++)
     {
-        for(int j = 0; j < 6; j++)
-        {
-            matrices->GetView() = views[j];
-
-            Renderer::Get().Begin();
+        // One submission per mip level, the render targets are recreated between them
+        Renderer::Get().Begin(false);
 
-            Renderer::Get().RenderPass(
-                [&](auto commandBuffer)
-                {
-                    cube->BindBuffers(commandBuffer);
-                },
-                {
-                    { 0, Renderer::Get().GetMatricesBuffer() },
-                    { 1, resources.at(1) },
-                    { 2, resources.at(2) }
-                },
-                [&](auto commandBuffer)
-                {
-                    float roughness = static_cast<float>(i) / static_cast<float>(mipsNum - 1);
+        const auto setUniforms = [&](auto commandBuffer)
+        {
+            float roughness = static_cast<float>(i) / static_cast<float>(mipsNum - 1);
 
-                    commandBuffer->SetUniforms(0, &roughness, sizeof(roughness));
-                    commandBuffer->SetUniforms(1, &i, sizeof(i));
+            commandBuffer->SetUniforms(0, &roughness, sizeof(roughness));
+            commandBuffer->SetUniforms(1, &i, sizeof(i));
+        };
 
-                    cube->Draw(commandBuffer);
-                },
-                pipeline,
-                renderTargets[j]
-            );
+        for(int j = 0; j < 6; j++)
+            RenderFace(resources, renderTargets[j], j, pipeline, setUniforms);
 
-            Renderer::Get().End();
+        Renderer::Get().End();
 
-            Renderer::Get().Submit();
-        }
+        Renderer::Get().Submit();
 
         if(i == mipsNum - 1)
             break;
@@ -242,6 +455,209 @@ void PBRManager::RenderBRDF()
     Renderer::Get().Submit();
 }
 
+void PBRManager::SetupBRDF()
+{
+    constexpr LLGL::Extent2D resolution = { 256, 256 };
+
+    CreateBRDFTexture(resolution);
+    CreateBRDFRenderTarget(resolution);
+
+    const auto key = Hash()
+        .Add(Renderer::Get().GetShaderHash(AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true)->shader))
+        .Add(Renderer::Get().GetShaderHash(AssetManager::Get().Load<FragmentShaderAsset>("BRDF.frag", true)->shader))
+        .Add(resolution.width)
+        .Add(resolution.height)
+        .Get();
+
+    if(!cacheDirectory.empty())
+    {
+        std::ifstream file(GetCachePath(key), std::ios::binary);
+
+        uint32_t version = 0;
+
+        if(file.read(reinterpret_cast<char*>(&version), sizeof(version))
+           && version == cacheVersion && ReadMipLevel(file, brdf, 0))
+            return;
+    }
+
+    RenderBRDF();
+
+    if(cacheDirectory.empty())
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+
+    if(std::ofstream file(GetCachePath(key), std::ios::binary); file.is_open())
+    {
+        file.write(reinterpret_cast<const char*>(&cacheVersion), sizeof(cacheVersion));
+
+        WriteMipLevel(file, brdf, 0);
+    }
+}
+
+bool PBRManager::LoadEnvironment(const uint64_t key, const LLGL::Extent2D& resolution) const
+{
+    if(cacheDirectory.empty())
+        return false;
+
+    std::ifstream file(GetCachePath(key), std::ios::binary);
+
+    uint32_t version = 0;
+
+    if(!file.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != cacheVersion)
+        return false;
+
+    ScopedTimer timer("LoadEnvironment");
+
+    // Only the base levels of the cube map and the irradiance are stored, their mips are cheap to generate
+    if(!ReadMipLevel(file, cubeMap, 0) || !ReadMipLevel(file, irradiance, 0))
+        return false;
+
+    const auto mipsNum = LLGL::NumMipLevels(resolution.width / 6, resolution.height / 6);
+
+    for(uint32_t i = 0; i < mipsNum; i++)
+        if(!ReadMipLevel(file, prefiltered, i))
+            return false;
+
+    Renderer::Get().GenerateMips(cubeMap);
+    Renderer::Get().GenerateMips(irradiance);
+
+    // Marks it as recently used for the eviction
+    std::error_code error;
+    std::filesystem::last_write_time(GetCachePath(key), std::filesystem::file_time_type::clock::now(), error);
+
+    return true;
+}
+
+void PBRManager::StoreEnvironment(const uint64_t key, const LLGL::Extent2D& resolution) const
+{
+    if(cacheDirectory.empty())
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+
+    {
+        std::ofstream file(GetCachePath(key), std::ios::binary);
+
+        if(!file.is_open())
+            return;
+
+        file.write(reinterpret_cast<const char*>(&cacheVersion), sizeof(cacheVersion));
+
+        WriteMipLevel(file, cubeMap, 0);
+        WriteMipLevel(file, irradiance, 0);
+
+        const auto mipsNum = LLGL::NumMipLevels(resolution.width / 6, resolution.height / 6);
+
+        for(uint32_t i = 0; i < mipsNum; i++)
+            WriteMipLevel(file, prefiltered, i);
+    }
+
+    EvictCache(GetCachePath(key));
+}
+
+void PBRManager::EvictCache(const std::filesystem::path& keep)
+{
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUsed;
+        uintmax_t size;
+    };
+
+    std::vector<Entry> entries;
+    uintmax_t totalSize = 0;
+
+    std::error_code error;
+
+    for(const auto& file : std::filesystem::directory_iterator(cacheDirectory, error))
+    {
+        if(!file.is_regular_file(error) || file.path().extension() != ".bin")
+            continue;
+
+        const auto size = file.file_size(error);
+
+        if(error)
+            continue;
+
+        entries.push_back({ file.path(), file.last_write_time(error), size });
+        totalSize += size;
+    }
+
+    if(totalSize <= maxCacheSize)
+        return;
+
+    std::ranges::sort(entries, {}, &Entry::lastUsed);
+
+    for(const auto& entry : entries)
+    {
+        if(totalSize <= maxCacheSize)
+            break;
+
+        if(entry.path == keep || !std::filesystem::remove(entry.path, error))
+            continue;
+
+        totalSize -= entry.size;
+    }
+}
+
+bool PBRManager::ReadMipLevel(std::istream& stream, LLGL::Texture* texture, const uint32_t mipLevel)
+{
+    const auto extent = texture->GetMipExtent(mipLevel);
+    const auto layers = texture->GetDesc().arrayLayers;
+    const auto& formatAttribs = LLGL::GetFormatAttribs(texture->GetDesc().format);
+
+    std::vector<char> data(static_cast<size_t>(extent.width) * extent.height * layers * formatAttribs.bitSize / 8);
+
+    if(!stream.read(data.data(), static_cast<std::streamsize>(data.size())))
+        return false;
+
+    LLGL::TextureRegion region;
+    region.subresource.baseArrayLayer = 0;
+    region.subresource.numArrayLayers = layers;
+    region.subresource.baseMipLevel = mipLevel;
+    region.subresource.numMipLevels = 1;
+    region.extent = { extent.width, extent.height, 1 };
+
+    const LLGL::ImageView imageView{ formatAttribs.format, formatAttribs.dataType, data.data(), data.size() };
+
+    Renderer::Get().WriteTexture(*texture, region, imageView);
+
+    return true;
+}
+
+void PBRManager::WriteMipLevel(std::ostream& stream, LLGL::Texture* texture, const uint32_t mipLevel)
+{
+    const auto extent = texture->GetMipExtent(mipLevel);
+    const auto layers = texture->GetDesc().arrayLayers;
+    const auto& formatAttribs = LLGL::GetFormatAttribs(texture->GetDesc().format);
+
+    std::vector<char> data(static_cast<size_t>(extent.width) * extent.height * layers * formatAttribs.bitSize / 8);
+
+    LLGL::TextureRegion region;
+    region.subresource.baseArrayLayer = 0;
+    region.subresource.numArrayLayers = layers;
+    region.subresource.baseMipLevel = mipLevel;
+    region.subresource.numMipLevels = 1;
+    region.extent = { extent.width, extent.height, 1 };
+
+    const LLGL::MutableImageView imageView{ formatAttribs.format, formatAttribs.dataType, data.data(), data.size() };
+
+    Renderer::Get().ReadTexture(*texture, region, imageView);
+
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+std::filesystem::path PBRManager::GetCachePath(const uint64_t key)
+{
+    std::stringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+
+    return cacheDirectory / fileName.str();
+}
+
 void PBRManager::SetupConvertPipeline()
 {
     pipelineConvert = Renderer::Get().CreatePipelineState(
@@ -352,7 +768,29 @@ void PBRManager::SetupBRDFPipeline()
 
 void PBRManager::CreateCubemaps(const LLGL::Extent2D& resolution)
 {
-    LLGL::TextureDescriptor textureDesc
+    cubeMap = CreateCubeMap(resolution);
+    irradiance = CreateCubeMap({ resolution.width / 32, resolution.height / 32 });
+    prefiltered = CreateCubeMap({ resolution.width / 6, resolution.height / 6 });
+}
+
+void PBRManager::CreateSHTexture()
+{
+    const LLGL::TextureDescriptor textureDesc
+    {
+        .type = LLGL::TextureType::Texture2D,
+        .bindFlags = LLGL::BindFlags::ColorAttachment | LLGL::BindFlags::Sampled,
+        .format = LLGL::Format::RGBA32Float,
+        .extent = { 9, 1, 1 },
+        .mipLevels = 1
+    };
+
+    shCoefficients = Renderer::Get().CreateTexture(textureDesc);
+    shRenderTarget = Renderer::Get().CreateRenderTarget({ 9, 1 }, { shCoefficients });
+}
+
+LLGL::Texture* PBRManager::CreateCubeMap(const LLGL::Extent2D& resolution)
+{
+    const LLGL::TextureDescriptor textureDesc
     {
         .type = LLGL::TextureType::TextureCubeArray,
         .bindFlags = LLGL::BindFlags::ColorAttachment | LLGL::BindFlags::Sampled,
@@ -361,15 +799,61 @@ void PBRManager::CreateCubemaps(const LLGL::Extent2D& resolution)
         .arrayLayers = 6
     };
 
-    cubeMap = Renderer::Get().CreateTexture(textureDesc);
-    Renderer::Get().GenerateMips(cubeMap);
+    const auto texture = Renderer::Get().CreateTexture(textureDesc);
+    Renderer::Get().GenerateMips(texture);
+
+    return texture;
+}
 
-    textureDesc.extent = { resolution.width / 32, resolution.height / 32, 1 };
-    irradiance = Renderer::Get().CreateTexture(textureDesc);
+void PBRManager::SetupSHPipelines()
+{
+    pipelineSHProject = Renderer::Get().CreatePipelineState(
+        LLGL::PipelineLayoutDescriptor
+        {
+            .bindings =
+            {
+                { "skybox", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 },
+                { "samplerState", LLGL::ResourceType::Sampler, 0, LLGL::StageFlags::FragmentStage, 2 }
+            },
+            .uniforms =
+            {
+                { "lod", LLGL::UniformType::Float1 }
+            }
+        },
+        LLGL::GraphicsPipelineDescriptor
+        {
+            .vertexShader = AssetManager::Get().Load<VertexShaderAsset>("screenRect.vert", true)->shader,
+            .fragmentShader = AssetManager::Get().Load<FragmentShaderAsset>("SHProject.frag", true)->shader
+        }
+    );
 
-    textureDesc.extent = { resolution.width / 6, resolution.height / 6, 1 };
-    prefiltered = Renderer::Get().CreateTexture(textureDesc);
-    Renderer::Get().GenerateMips(prefiltered);
+    pipelineIrradianceSH = Renderer::Get().CreatePipelineState(
+        LLGL::PipelineLayoutDescriptor
+        {
+            .bindings =
+            {
+                { "matrices", LLGL::ResourceType::Buffer, LLGL::BindFlags::ConstantBuffer, LLGL::StageFlags::VertexStage, 1 },
+                { "coefficients", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 2 },
+                { "samplerState", LLGL::ResourceType::Sampler, 0, LLGL::StageFlags::FragmentStage, 2 }
+            }
+        },
+        LLGL::GraphicsPipelineDescriptor
+        {
+            .vertexShader = AssetManager::Get().Load<VertexShaderAsset>("skybox.vert", true)->shader,
+            .fragmentShader = AssetManager::Get().Load<FragmentShaderAsset>("irradianceSH.frag", true)->shader,
+            .depth = LLGL::DepthDescriptor
+            {
+                .testEnabled = true,
+                .writeEnabled = false,
+                .compareOp = LLGL::CompareOp::LessEqual
+            },
+            .rasterizer = LLGL::RasterizerDescriptor
+            {
+                .cullMode = LLGL::CullMode::Front,
+                .frontCCW = true
+            }
+        }
+    );
 }
 
 void PBRManager::CreateRenderTargets(const LLGL::Extent2D& resolution, LLGL::Texture* cubeMap, const int mipLevel)
@@ -412,11 +896,15 @@ void PBRManager::ReleaseCubeMaps() const
     }
 }
 
-void PBRManager::ReleaseRenderTargets() const
+void PBRManager::ReleaseRenderTargets()
 {
-    for(const auto renderTarget : renderTargets)
+    for(auto& renderTarget : renderTargets)
+    {
         if(renderTarget)
             Renderer::Get().Release(renderTarget);
+
+        renderTarget = nullptr;
+    }
 }
 
 }
@@ -40,7 +40,9 @@ PostProcessing::PostProcessing(
         renderTarget = Renderer::Get().CreateRenderTarget(resolution, { frame });
     }
 
-    EventManager::Get().AddListener(Event::Type::AssetLoaded, this);
+    assetLoadedSubscription = EventBus::Get().Subscribe<AssetLoadedEvent>(
+        [this](const auto events) { OnAssetLoaded(events); }
+    );
 
     rectPipeline =
         Renderer::Get().CreatePipelineState(
@@ -55,7 +57,7 @@ PostProcessing::PostProcessing(
 PostProcessing::~PostProcessing()
 {
     EventManager::Get().RemoveListener(Event::Type::WindowResize, this);
-    EventManager::Get().RemoveListener(Event::Type::AssetLoaded, this);
+    EventBus::Get().Unsubscribe(assetLoadedSubscription);
 }
 
 void PostProcessing::OnEvent(Event& event)
@@ -74,24 +76,24 @@ void PostProcessing::OnEvent(Event& event)
         frame = Renderer::Get().CreateTexture(frameDesc);
         renderTarget = Renderer::Get().CreateRenderTarget(size, { frame });
     }
-    else if(event.GetType() == Event::Type::AssetLoaded)
-    {
-        const auto assetEvent = dynamic_cast<AssetLoadedEvent*>(&event);
+}
 
-        if(assetEvent->GetAsset()->type == Asset::Type::FragmentShader)
+void PostProcessing::OnAssetLoaded(const std::span<const AssetLoadedEvent> events)
+{
+    for(const auto& event : events)
+    {
+        if(event.GetAsset() == fragmentShader)
         {
-            const auto shader = std::static_pointer_cast<FragmentShaderAsset>(assetEvent->GetAsset());
-            if(fragmentShader == shader)
-            {
-                rectPipeline =
-                    Renderer::Get().CreatePipelineState(
-                        layoutDesc,
-                        {
-                            .vertexShader = vertexShader->shader,
-                            .fragmentShader = fragmentShader->shader
-                        }
-                    );
-            }
+            rectPipeline =
+                Renderer::Get().CreatePipelineState(
+                    layoutDesc,
+                    {
+                        .vertexShader = vertexShader->shader,
+                        .fragmentShader = fragmentShader->shader
+                    }
+                );
+
+            break;
         }
     }
 }
@@ -108,6 +110,25 @@ LLGL::Texture* PostProcessing::Apply(
 
     Renderer::Get().Begin();
 
+    Record(resources, setUniforms, renderTarget, bindMatrices);
+
+    Renderer::Get().End();
+
+    Renderer::Get().Submit();
+
+    return frame;
+}
+
+void PostProcessing::Record(
+    const std::unordered_map<uint32_t, LLGL::Resource*>& resources,
+    const std::function<void(LLGL::CommandBuffer*)>& setUniforms,
+    LLGL::RenderTarget* renderTarget,
+    const bool bindMatrices
+)
+{
+    if(!renderTarget && !this->renderTarget)
+        return;
+
     Renderer::Get().RenderPass(
         [&](auto commandBuffer)
         {
@@ -126,12 +147,6 @@ LLGL::Texture* PostProcessing::Apply(
         rectPipeline,
         renderTarget ? renderTarget : this->renderTarget
     );
-
-    Renderer::Get().End();
-
-    Renderer::Get().Submit();
-
-    return frame;
 }
 
 LLGL::Texture* PostProcessing::GetFrame() const
@@ -0,0 +1,206 @@
+#include <RenderGraph.hpp>
+
+#include <algorithm>
+#include <ranges>
+
+namespace lustra
+{
+
+bool RenderGraph::TextureDesc::operator==(const TextureDesc& other) const
+{
+    return resolution.width == other.resolution.width
+        && resolution.height == other.resolution.height
+        && format == other.format
+        && mipMaps == other.mipMaps;
+}
+
+RenderGraph::Handle RenderGraph::Import(LLGL::Texture* texture, LLGL::RenderTarget* renderTarget)
+{
+    Resource resource = { .texture = texture, .renderTarget = renderTarget, .imported = true };
+
+    resource.desc.mipMaps = texture && texture->GetDesc().mipLevels != 1;
+
+    resources.push_back(resource);
+
+    return static_cast<Handle>(resources.size() - 1);
+}
+
+RenderGraph::Handle RenderGraph::Create(const TextureDesc& desc)
+{
+    resources.push_back({ .desc = desc });
+
+    return static_cast<Handle>(resources.size() - 1);
+}
+
+void RenderGraph::AddPass(std::vector<Handle> reads, std::vector<Handle> writes, std::function<void()> execute)
+{
+    passes.push_back({ std::move(reads), std::move(writes), std::move(execute) });
+}
+
+void RenderGraph::Execute(const Handle output)
+{
+    Cull(output);
+    ComputeLifetimes();
+
+    // The graph clears the transient textures itself
+    Renderer::Get().Begin(false);
+
+    for(int i = 0; i < static_cast<int>(passes.size()); i++)
+    {
+        const auto& pass = passes[i];
+
+        if(pass.culled)
+            continue;
+
+        for(const auto handle : pass.writes)
+        {
+            auto& resource = resources[handle];
+
+            if(resource.imported || resource.firstPass != i)
+                continue;
+
+            resource.pooled = Acquire(resource.desc);
+            resource.texture = pool[resource.pooled].texture;
+            resource.renderTarget = pool[resource.pooled].renderTarget;
+
+            // An aliased texture still holds whatever its previous owner left there
+            Renderer::Get().ClearRenderTarget(resource.renderTarget, false);
+        }
+
+        pass.execute();
+
+        for(const auto handle : pass.writes)
+            if(resources[handle].desc.mipMaps && resources[handle].texture)
+                Renderer::Get().GenerateMips(resources[handle].texture, false);
+
+        for(const auto& resource : resources)
+            if(resource.pooled != -1 && resource.lastPass == i)
+                pool[resource.pooled].busy = false;
+    }
+
+    Renderer::Get().End();
+
+    Renderer::Get().Submit();
+
+    Reset();
+}
+
+LLGL::Texture* RenderGraph::GetTexture(const Handle handle) const
+{
+    return resources[handle].texture;
+}
+
+LLGL::RenderTarget* RenderGraph::GetRenderTarget(const Handle handle) const
+{
+    return resources[handle].renderTarget;
+}
+
+size_t RenderGraph::GetPoolSize() const
+{
+    return pool.size();
+}
+
+void RenderGraph::Cull(const Handle output)
+{
+    std::vector<bool> needed(resources.size(), false);
+
+    needed[output] = true;
+
+    // Walking backwards, a pass is needed if anything after it reads what it writes
+    for(auto& pass : passes | std::views::reverse)
+    {
+        pass.culled = std::ranges::none_of(pass.writes, [&](const Handle handle)
+        {
+            return needed[handle] || resources[handle].imported;
+        });
+
+        if(!pass.culled)
+            for(const auto handle : pass.reads)
+                needed[handle] = true;
+    }
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+    for(int i = 0; i < static_cast<int>(passes.size()); i++)
+    {
+        if(passes[i].culled)
+            continue;
+
+        const auto use = [&](const Handle handle)
+        {
+            auto& resource = resources[handle];
+
+            if(resource.firstPass == -1)
+                resource.firstPass = i;
+
+            resource.lastPass = i;
+        };
+
+        std::ranges::for_each(passes[i].reads, use);
+        std::ranges::for_each(passes[i].writes, use);
+    }
+}
+
+int RenderGraph::Acquire(const TextureDesc& desc)
+{
+    auto index = std::distance(pool.begin(), std::ranges::find_if(pool, [&](const PooledTexture& texture)
+    {
+        return !texture.busy && texture.desc == desc;
+    }));
+
+    if(index == std::ssize(pool))
+        pool.push_back(CreateTexture(desc));
+
+    pool[index].busy = true;
+    pool[index].used = true;
+
+    return static_cast<int>(index);
+}
+
+void RenderGraph::Reset()
+{
+    resources.clear();
+    passes.clear();
+
+    std::erase_if(pool, [](const PooledTexture& texture)
+    {
+        if(texture.used)
+            return false;
+
+        Renderer::Get().Release(texture.renderTarget);
+        Renderer::Get().Release(texture.texture);
+
+        return true;
+    });
+
+    for(auto& texture : pool)
+    {
+        texture.busy = false;
+        texture.used = false;
+    }
+}
+
+RenderGraph::PooledTexture RenderGraph::CreateTexture(const TextureDesc& desc)
+{
+    const LLGL::TextureDescriptor textureDesc =
+    {
+        .type = LLGL::TextureType::Texture2D,
+        .bindFlags = LLGL::BindFlags::ColorAttachment | LLGL::BindFlags::Sampled,
+        .format = desc.format,
+        .extent = { desc.resolution.width, desc.resolution.height, 1 },
+        .mipLevels = static_cast<uint32_t>(desc.mipMaps ? 0 : 1),
+        .samples = 1
+    };
+
+    const auto texture = Renderer::Get().CreateTexture(textureDesc);
+
+    return
+    {
+        .desc = desc,
+        .texture = texture,
+        .renderTarget = Renderer::Get().CreateRenderTarget(desc.resolution, { texture })
+    };
+}
+
+}
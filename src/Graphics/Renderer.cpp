@@ -1,8 +1,59 @@
 #include <Renderer.hpp>
+#include <Hash.hpp>
+#include <Multithreading.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 
 namespace lustra
 {
 
+thread_local Renderer::Worker* Renderer::worker{};
+
+static bool IsIdentifierChar(const char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Whole identifiers only, the comments are skipped
+static bool MentionsIdentifier(const std::string& source, const std::string_view identifier)
+{
+    for(size_t i = 0; i < source.size();)
+    {
+        if(source.compare(i, 2, "//") == 0)
+        {
+            i = source.find('\n', i);
+            continue;
+        }
+
+        if(source.compare(i, 2, "/*") == 0)
+        {
+            const auto end = source.find("*/", i + 2);
+            i = end == std::string::npos ? end : end + 2;
+            continue;
+        }
+
+        if(!IsIdentifierChar(source[i]))
+        {
+            i++;
+            continue;
+        }
+
+        const auto begin = i;
+
+        while(i < source.size() && IsIdentifierChar(source[i]))
+            i++;
+
+        if(std::string_view(source).substr(begin, i - begin) == identifier)
+            return true;
+    }
+
+    return false;
+}
+
 void Renderer::Init()
 {
     if(renderSystem)
@@ -45,6 +96,8 @@ void Renderer::InitSwapChain(const LLGL::Extent2D& resolution, const bool fullsc
     viewportResolution = resolution;
 
     SetupBuffers();
+
+    EventManager::Get().AddListener(Event::Type::WindowResize, this);
 }
 
 void Renderer::InitSwapChain(const std::shared_ptr<LLGL::Surface>& surface)
@@ -54,18 +107,38 @@ void Renderer::InitSwapChain(const std::shared_ptr<LLGL::Surface>& surface)
     viewportResolution = swapChain->GetResolution();
 
     SetupBuffers();
+
+    EventManager::Get().AddListener(Event::Type::WindowResize, this);
 }
 
-void Renderer::Begin()
+void Renderer::BeginFrame()
 {
-    renderPassCounter = 0;
+    frameStarted = true;
 
     commandBuffer->Begin();
 }
 
-void Renderer::End() const
+void Renderer::EndFrame()
 {
+    frameStarted = false;
+
     commandBuffer->End();
+
+    commandQueue->Submit(*commandBuffer);
+}
+
+void Renderer::Begin(const bool clearFirstPass)
+{
+    renderPassCounter = clearFirstPass ? 0 : 1;
+
+    if(!frameStarted)
+        commandBuffer->Begin();
+}
+
+void Renderer::End() const
+{
+    if(!frameStarted)
+        commandBuffer->End();
 }
 
 void Renderer::RenderPass(
@@ -76,12 +149,13 @@ void Renderer::RenderPass(
     LLGL::RenderTarget* renderTarget
 )
 {
+    auto* commandBuffer = worker ? worker->commandBuffer : this->commandBuffer;
+    auto& renderPassCounter = worker ? worker->renderPassCounter : this->renderPassCounter;
+
     setupBuffers(commandBuffer);
 
     commandBuffer->BeginRenderPass(renderTarget ? *renderTarget : *swapChain);
     {
-        swapChain->ResizeBuffers(swapChain->GetSurface().GetContentSize());
-
         if(pipeline)
         {
             commandBuffer->SetViewport(renderTarget ? renderTarget->GetResolution() : swapChain->GetResolution());
@@ -102,9 +176,59 @@ void Renderer::RenderPass(
     commandBuffer->EndRenderPass();
 }
 
+void Renderer::RecordParallel(
+    const size_t count,
+    const std::function<void(size_t begin, size_t end)>& record,
+    const size_t minChunkSize
+)
+{
+    const size_t chunks = Multithreading::GetChunkCount(count, minChunkSize);
+
+    if(chunks == 0)
+        return;
+
+    // Not worth recording into the secondary command buffers
+    if(chunks == 1)
+    {
+        record(0, count);
+        return;
+    }
+
+    // Created on this thread, the render system isn't thread-safe
+    for(size_t i = 0; i < chunks; i++)
+        GetSecondaryCommandBuffer(i);
+
+    Multithreading::ParallelForChunks(count, [&](const size_t chunk, const size_t begin, const size_t end)
+    {
+        // Only the first chunk may still have to clear the target
+        Worker local =
+        {
+            .commandBuffer = secondaryCommandBuffers[chunk],
+            .matrices = std::make_shared<Matrices>(*matrices),
+            .renderPassCounter = chunk == 0 ? renderPassCounter : 1
+        };
+
+        worker = &local;
+
+        local.commandBuffer->Begin();
+
+        record(begin, end);
+
+        local.commandBuffer->End();
+
+        worker = nullptr;
+    }, minChunkSize);
+
+    for(size_t i = 0; i < chunks; i++)
+        commandBuffer->Execute(*secondaryCommandBuffers[i]);
+
+    renderPassCounter++;
+}
+
 void Renderer::Submit() const
 {
-    commandQueue->Submit(*commandBuffer);
+    if(!frameStarted)
+        commandQueue->Submit(*commandBuffer);
 }
 
 void Renderer::Present() const
@@ -135,9 +259,10 @@ void Renderer::ClearRenderTarget(LLGL::RenderTarget* renderTarget, const bool be
     }
 }
 
-void Renderer::GenerateMips(LLGL::Texture* texture)
+void Renderer::GenerateMips(LLGL::Texture* texture, const bool begin)
 {
-    Begin();
+    if(begin)
+        Begin();
 
     RenderPass(
         [&](auto)
@@ -147,27 +272,61 @@ void Renderer::GenerateMips(LLGL::Texture* texture)
         nullptr
     );
 
-    End();
+    if(begin)
+    {
+        End();
 
-    Submit();
+        Submit();
+    }
 }
 
 void Renderer::Unload()
 {
     renderSystem->Release(*matricesBuffer);
     renderSystem->Release(*commandBuffer);
+
+    for(const auto secondary : secondaryCommandBuffers)
+        renderSystem->Release(*secondary);
+
+    secondaryCommandBuffers.clear();
+
+    pipelineCache.clear();
+    pipelineLayoutCache.clear();
+    shaderHashes.clear();
+    shaderSources.clear();
+    shaderVariants.clear();
+    shaderVariantKeys.clear();
+
     renderSystem->Release(*swapChain);
 
     defaultVertexFormat = LLGL::VertexFormat();
+    skinnedVertexFormat = LLGL::VertexFormat();
 
     LLGL::RenderSystem::Unload(std::move(renderSystem));
 }
 
+void Renderer::OnEvent(Event& event)
+{
+    // The editor sends the size of its viewport, the swap chain always follows the window
+    if(event.GetType() == Event::Type::WindowResize && swapChain)
+        swapChain->ResizeBuffers(swapChain->GetSurface().GetContentSize());
+}
+
 void Renderer::WriteTexture(LLGL::Texture& texture, const LLGL::TextureRegion& textureRegion, const LLGL::ImageView& srcImageView) const
 {
     renderSystem->WriteTexture(texture, textureRegion, srcImageView);
 }
 
+void Renderer::ReadTexture(LLGL::Texture& texture, const LLGL::TextureRegion& textureRegion, const LLGL::MutableImageView& dstImageView) const
+{
+    renderSystem->ReadTexture(texture, textureRegion, dstImageView);
+}
+
+void Renderer::WriteBuffer(LLGL::Buffer& buffer, const uint64_t offset, const void* data, const uint64_t size) const
+{
+    renderSystem->WriteBuffer(buffer, offset, data, size);
+}
+
 void Renderer::SetViewportResolution(const LLGL::Extent2D& resolution)
 {
     viewportResolution = resolution;
@@ -220,31 +379,163 @@ LLGL::Buffer* Renderer::CreateBuffer(const std::string& name, const LLGL::Buffer
     return buffer;
 }
 
-LLGL::Shader* Renderer::CreateShader(const LLGL::ShaderType& type, const std::filesystem::path& path, const std::vector<LLGL::VertexAttribute>& attributes) const
+LLGL::Shader* Renderer::CreateShader(const LLGL::ShaderType& type, const std::filesystem::path& path, const std::vector<LLGL::VertexAttribute>& attributes)
 {
-    const auto strPath = path.string();
-    LLGL::ShaderDescriptor shaderDesc{ type, strPath.c_str() };
+    return CreateShaderFromSource(type, ReadShaderSource(path), path.filename().string(), attributes);
+}
+
+LLGL::Shader* Renderer::CreateShaderFromSource(
+    const LLGL::ShaderType& type,
+    const std::string& source,
+    const std::string& name,
+    const std::vector<LLGL::VertexAttribute>& attributes
+)
+{
+    LLGL::ShaderDescriptor shaderDesc{ type, source.c_str() };
+    shaderDesc.sourceSize = source.size();
+    shaderDesc.sourceType = LLGL::ShaderSourceType::CodeString;
 
     if(type == LLGL::ShaderType::Vertex)
         shaderDesc.vertex.inputAttribs = attributes.empty() ? defaultVertexFormat.attributes : attributes;
 
     const auto shader = renderSystem->CreateShader(shaderDesc);
 
+    shaderHashes[shader] = HashShader(shaderDesc, name, source);
+    shaderSources[shader] = { type, name, source, attributes };
+
     if(const LLGL::Report* report = shader->GetReport())
     {
         if(report->HasErrors())
             LLGL::Log::Errorf(LLGL::Log::ColorFlags::StdError,
                               "Shader compile errors:\n\t%s\n%s",
-                                      path.filename().string().c_str(), report->GetText());
+                                      name.c_str(), report->GetText());
         else
             LLGL::Log::Errorf(LLGL::Log::ColorFlags::StdWarning,
                               "Shader compile warnings:\n\t%s\n%s",
-                                      path.filename().string().c_str(), report->GetText());
+                                      name.c_str(), report->GetText());
     }
 
     return shader;
 }
 
+LLGL::Shader* Renderer::GetShaderVariant(
+    LLGL::Shader* shader,
+    const std::vector<std::string>& keywords,
+    const std::vector<LLGL::VertexAttribute>& attributes,
+    const bool required
+)
+{
+    const auto it = shaderSources.find(shader);
+
+    if(keywords.empty() || it == shaderSources.end())
+        return shader;
+
+    const auto& [type, name, source, shaderAttributes] = it->second;
+
+    // The variants belong to their shader, they're released with it
+    Hash hash;
+    hash.Add(reinterpret_cast<uintptr_t>(shader)).Add(shaderHashes[shader]);
+
+    for(const auto& keyword : keywords)
+        hash.Add(keyword);
+
+    for(const auto& attribute : attributes)
+        hash.Add(attribute.name.c_str()).Add(attribute.format);
+
+    const auto key = hash.Get();
+
+    auto& variant = shaderVariants[key];
+
+    if(variant)
+        return variant;
+
+    shaderVariantKeys[shader].push_back(key);
+
+    // A shader that doesn't mention any of the keywords would compile to the same thing
+    const auto mentioned = std::ranges::any_of(keywords, [&](const std::string& keyword)
+    {
+        return MentionsIdentifier(source, std::string_view(keyword).substr(0, keyword.find_first_of(" =(")));
+    });
+
+    if(!mentioned)
+    {
+        if(required)
+            LLGL::Log::Printf(
+                LLGL::Log::ColorFlags::StdWarning,
+                "Shader \"%s\" doesn't support \"%s\", it's used as it is\n",
+                name.c_str(), keywords.front().c_str()
+            );
+
+        variant = shader;
+
+        return variant;
+    }
+
+    // The defines go right after #version, which must stay the first directive
+    const auto version = source.find("#version");
+    const auto lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    const auto insertAt = lineEnd == std::string::npos ? 0 : lineEnd + 1;
+
+    std::string defines;
+
+    for(const auto& keyword : keywords)
+        defines += "#define " + keyword + "\n";
+
+    // Keeps the line numbers in the compile errors pointing at the original file
+    defines += "#line " + std::to_string(std::ranges::count(source.begin(), source.begin() + insertAt, '\n') + 1) + "\n";
+
+    std::string variantSource = source;
+    variantSource.insert(insertAt, defines);
+
+    variant = CreateShaderFromSource(type, variantSource, name, attributes.empty() ? shaderAttributes : attributes);
+
+    return variant;
+}
+
+void Renderer::ReleaseShaderVariants(const LLGL::Shader* shader)
+{
+    const auto it = shaderVariantKeys.find(shader);
+
+    if(it == shaderVariantKeys.end())
+        return;
+
+    for(const auto key : it->second)
+    {
+        const auto variant = shaderVariants.find(key);
+
+        if(variant == shaderVariants.end())
+            continue;
+
+        if(variant->second && variant->second != shader)
+            Release(variant->second);
+
+        shaderVariants.erase(variant);
+    }
+
+    shaderVariantKeys.erase(it);
+}
+
+uint64_t Renderer::GetShaderHash(const LLGL::Shader* shader) const
+{
+    const auto it = shaderHashes.find(shader);
+
+    return it != shaderHashes.end() ? it->second : 0;
+}
+
+std::string Renderer::ReadShaderSource(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if(!file.is_open())
+    {
+        LLGL::Log::Errorf(LLGL::Log::ColorFlags::StdError, "Failed to open shader: %s\n", path.string().c_str());
+
+        return {};
+    }
+
+    return { std::istreambuf_iterator(file), std::istreambuf_iterator<char>() };
+}
+
 LLGL::Texture* Renderer::CreateTexture(const LLGL::TextureDescriptor& textureDesc, const LLGL::ImageView* initialImage) const
 {
     return renderSystem->CreateTexture(textureDesc, initialImage);
@@ -273,12 +564,6 @@ LLGL::RenderTarget* Renderer::CreateRenderTarget(const LLGL::Extent2D& resolutio
 
 LLGL::PipelineState* Renderer::CreatePipelineState(LLGL::Shader* vertexShader, LLGL::Shader* fragmentShader)
 {
-    uint64_t key = reinterpret_cast<uint64_t>(vertexShader) ^ reinterpret_cast<uint64_t>(fragmentShader);
-
-    auto it = pipelineCache.find(key);
-    if(it != pipelineCache.end())
-        return it->second;
-
     LLGL::PipelineLayoutDescriptor layoutDesc;
 
     layoutDesc.bindings =
@@ -290,7 +575,8 @@ LLGL::PipelineState* Renderer::CreatePipelineState(LLGL::Shader* vertexShader, L
         { "roughnessTexture", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 5 },
         { "aoTexture", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 6 },
         { "emissionTexture", LLGL::ResourceType::Texture, LLGL::BindFlags::Sampled, LLGL::StageFlags::FragmentStage, 7 },
-        { "samplerState", LLGL::ResourceType::Sampler, 0, LLGL::StageFlags::FragmentStage, 2 }
+        { "samplerState", LLGL::ResourceType::Sampler, 0, LLGL::StageFlags::FragmentStage, 2 },
+        { "skinning", LLGL::ResourceType::Buffer, LLGL::BindFlags::Storage, LLGL::StageFlags::VertexStage, 2 }
     };
 
     layoutDesc.uniforms =
@@ -308,11 +594,10 @@ LLGL::PipelineState* Renderer::CreatePipelineState(LLGL::Shader* vertexShader, L
         { "emissionStrength", LLGL::UniformType::Float1 },
         { "uvScale", LLGL::UniformType::Float2 },
         { "uvOffset", LLGL::UniformType::Float2 },
-        { "time", LLGL::UniformType::Float1 }
+        { "time", LLGL::UniformType::Float1 },
+        { "paletteOffset", LLGL::UniformType::Int1 } // Of a skinned mesh, see AnimatorComponent::paletteOffset
     };
 
-    LLGL::PipelineLayout* pipelineLayout = renderSystem->CreatePipelineLayout(layoutDesc);
-
     LLGL::BlendTargetDescriptor blendTargetDesc;
     blendTargetDesc.blendEnabled = true;
 
@@ -323,7 +608,6 @@ LLGL::PipelineState* Renderer::CreatePipelineState(LLGL::Shader* vertexShader, L
     LLGL::GraphicsPipelineDescriptor pipelineStateDesc;
     pipelineStateDesc.vertexShader = vertexShader;
     pipelineStateDesc.fragmentShader = fragmentShader;
-    pipelineStateDesc.pipelineLayout = pipelineLayout;
     pipelineStateDesc.renderPass = swapChain->GetRenderPass();
 
     pipelineStateDesc.depth.testEnabled = true;
@@ -335,21 +619,37 @@ LLGL::PipelineState* Renderer::CreatePipelineState(LLGL::Shader* vertexShader, L
     pipelineStateDesc.rasterizer.frontCCW = true;
     pipelineStateDesc.rasterizer.multiSampleEnabled = (swapChain->GetSamples() > 1);
 
-    pipelineCache[key] = renderSystem->CreatePipelineState(pipelineStateDesc);
-
-    return pipelineCache[key];
+    return CreatePipelineState(layoutDesc, pipelineStateDesc);
 }
 
 LLGL::PipelineState* Renderer::CreatePipelineState(
     const LLGL::PipelineLayoutDescriptor& layoutDesc,
     LLGL::GraphicsPipelineDescriptor pipelineDesc
-) const
+)
 {
-    const auto pipelineLayout = renderSystem->CreatePipelineLayout(layoutDesc);
+    const auto layoutKey = HashPipelineLayout(layoutDesc);
+
+    auto& pipelineLayout = pipelineLayoutCache[layoutKey];
+
+    if(!pipelineLayout)
+        pipelineLayout = renderSystem->CreatePipelineLayout(layoutDesc);
 
     pipelineDesc.pipelineLayout = pipelineLayout;
 
-    return renderSystem->CreatePipelineState(pipelineDesc);
+    bool persistent = true;
+
+    const auto key = HashPipelineState(pipelineDesc, layoutKey, persistent);
+
+    // The render pass is an object without a description, so it only tells the pipelines apart while
+    // the program runs. The GL program doesn't depend on it, the binary on disk can be shared
+    const auto cacheKey = Hash().Add(key).Add(reinterpret_cast<uintptr_t>(pipelineDesc.renderPass)).Get();
+
+    if(const auto it = pipelineCache.find(cacheKey); it != pipelineCache.end())
+        return it->second;
+
+    return pipelineCache[cacheKey] = persistent
+        ? LoadPipelineState(pipelineDesc, key)
+        : renderSystem->CreatePipelineState(pipelineDesc);
 }
 
 LLGL::PipelineState* Renderer::CreateRenderTargetPipeline(const LLGL::RenderTarget* renderTarget) const
@@ -377,6 +677,11 @@ LLGL::VertexFormat Renderer::GetDefaultVertexFormat() const
     return defaultVertexFormat;
 }
 
+LLGL::VertexFormat Renderer::GetSkinnedVertexFormat() const
+{
+    return skinnedVertexFormat;
+}
+
 LLGL::Buffer* Renderer::GetMatricesBuffer() const
 {
     return matricesBuffer;
@@ -384,9 +689,17 @@ LLGL::Buffer* Renderer::GetMatricesBuffer() const
 
 std::shared_ptr<Matrices> Renderer::GetMatrices() const
 {
+    if(worker)
+        return worker->matrices;
+
     return matrices;
 }
 
+void Renderer::SetPipelineCacheDirectory(const std::filesystem::path& path)
+{
+    pipelineCacheDirectory = path;
+}
+
 bool Renderer::IsInit() const
 {
     return renderSystem != nullptr;// && swapChain != nullptr;
@@ -408,6 +721,10 @@ void Renderer::SetupDefaultVertexFormat()
     defaultVertexFormat.AppendAttribute({ "position", LLGL::Format::RGB32Float });
     defaultVertexFormat.AppendAttribute({ "normal", LLGL::Format::RGB32Float });
     defaultVertexFormat.AppendAttribute({ "texCoord", LLGL::Format::RG32Float });
+
+    skinnedVertexFormat = defaultVertexFormat;
+    skinnedVertexFormat.AppendAttribute({ "jointIndices", LLGL::Format::RGBA8UInt });
+    skinnedVertexFormat.AppendAttribute({ "jointWeights", LLGL::Format::RGBA8UNorm });
 }
 
 void Renderer::SetupCommandBuffer()
@@ -416,6 +733,16 @@ void Renderer::SetupCommandBuffer()
     commandQueue = renderSystem->GetCommandQueue();
 }
 
+LLGL::CommandBuffer* Renderer::GetSecondaryCommandBuffer(const size_t index)
+{
+    while(secondaryCommandBuffers.size() <= index)
+        secondaryCommandBuffers.push_back(
+            renderSystem->CreateCommandBuffer({ .flags = LLGL::CommandBufferFlags::Secondary })
+        );
+
+    return secondaryCommandBuffers[index];
+}
+
 void Renderer::CreateMatricesBuffer()
 {
     const auto bufferDesc = LLGL::ConstantBufferDesc(sizeof(Matrices::Binding));
@@ -430,4 +757,255 @@ void Renderer::SetupBuffers()
     CreateMatricesBuffer();
 }
 
+LLGL::PipelineState* Renderer::LoadPipelineState(const LLGL::GraphicsPipelineDescriptor& pipelineDesc, const uint64_t key) const
+{
+    if(pipelineCacheDirectory.empty())
+        return renderSystem->CreatePipelineState(pipelineDesc);
+
+    // A binary is only valid for the driver that produced it
+    const auto& info = renderSystem->GetRendererInfo();
+
+    const auto fileKey = Hash()
+        .Add(key)
+        .Add(info.rendererName)
+        .Add(info.deviceName)
+        .Add(info.vendorName)
+        .Get();
+
+    std::stringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << fileKey << ".bin";
+
+    const auto path = pipelineCacheDirectory / fileName.str();
+
+    std::vector<char> data;
+
+    if(std::ifstream file(path, std::ios::binary); file.is_open())
+        data.assign(std::istreambuf_iterator(file), std::istreambuf_iterator<char>());
+
+    const auto cache = renderSystem->CreatePipelineCache(
+        data.empty() ? LLGL::Blob() : LLGL::Blob::CreateCopy(data.data(), data.size())
+    );
+
+    const auto pipeline = renderSystem->CreatePipelineState(pipelineDesc, cache);
+
+    if(const LLGL::Report* report = pipeline->GetReport(); report && report->HasErrors())
+        LLGL::Log::Errorf(LLGL::Log::ColorFlags::StdError, "Pipeline state errors:\n%s", report->GetText());
+    else if(data.empty())
+    {
+        // The program was compiled and linked from scratch, the next launch loads it instead
+        if(const auto blob = cache->GetBlob())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(pipelineCacheDirectory, error);
+
+            if(std::ofstream file(path, std::ios::binary); file.is_open())
+                file.write(static_cast<const char*>(blob.GetData()), static_cast<std::streamsize>(blob.GetSize()));
+        }
+    }
+
+    renderSystem->Release(*cache);
+
+    return pipeline;
+}
+
+uint64_t Renderer::HashShader(const LLGL::ShaderDescriptor& shaderDesc, const std::string& name, const std::string& source)
+{
+    Hash hash;
+
+    // The contents rather than the path, an edited shader must not pick up a stale binary
+    hash.Add(shaderDesc.type).Add(name).Add(source);
+
+    for(const auto& attribute : shaderDesc.vertex.inputAttribs)
+    {
+        hash.Add(attribute.name.c_str())
+            .Add(attribute.format)
+            .Add(attribute.location)
+            .Add(attribute.slot)
+            .Add(attribute.offset)
+            .Add(attribute.stride);
+    }
+
+    return hash.Get();
+}
+
+uint64_t Renderer::HashPipelineLayout(const LLGL::PipelineLayoutDescriptor& layoutDesc)
+{
+    Hash hash;
+
+    const auto addBindings = [&](const std::vector<LLGL::BindingDescriptor>& bindings)
+    {
+        hash.Add(bindings.size());
+
+        for(const auto& binding : bindings)
+        {
+            hash.Add(binding.name.c_str())
+                .Add(binding.type)
+                .Add(binding.bindFlags)
+                .Add(binding.stageFlags)
+                .Add(binding.slot.index)
+                .Add(binding.slot.set)
+                .Add(binding.arraySize);
+        }
+    };
+
+    addBindings(layoutDesc.heapBindings);
+    addBindings(layoutDesc.bindings);
+
+    hash.Add(layoutDesc.staticSamplers.size());
+
+    for(const auto& staticSampler : layoutDesc.staticSamplers)
+    {
+        const auto& sampler = staticSampler.sampler;
+
+        hash.Add(staticSampler.name.c_str())
+            .Add(staticSampler.stageFlags)
+            .Add(staticSampler.slot.index)
+            .Add(staticSampler.slot.set)
+            .Add(sampler.addressModeU)
+            .Add(sampler.addressModeV)
+            .Add(sampler.addressModeW)
+            .Add(sampler.minFilter)
+            .Add(sampler.magFilter)
+            .Add(sampler.mipMapFilter)
+            .Add(sampler.mipMapEnabled)
+            .Add(sampler.mipMapLODBias)
+            .Add(sampler.minLOD)
+            .Add(sampler.maxLOD)
+            .Add(sampler.maxAnisotropy)
+            .Add(sampler.compareEnabled)
+            .Add(sampler.compareOp)
+            .Add(sampler.borderColor, sizeof(sampler.borderColor));
+    }
+
+    hash.Add(layoutDesc.uniforms.size());
+
+    for(const auto& uniform : layoutDesc.uniforms)
+        hash.Add(uniform.name.c_str()).Add(uniform.type).Add(uniform.arraySize);
+
+    hash.Add(layoutDesc.combinedTextureSamplers.size());
+
+    for(const auto& combined : layoutDesc.combinedTextureSamplers)
+    {
+        hash.Add(combined.name.c_str())
+            .Add(combined.textureName.c_str())
+            .Add(combined.samplerName.c_str())
+            .Add(combined.slot.index)
+            .Add(combined.slot.set);
+    }
+
+    return hash.Add(layoutDesc.barrierFlags).Get();
+}
+
+uint64_t Renderer::HashPipelineState(
+    const LLGL::GraphicsPipelineDescriptor& pipelineDesc,
+    const uint64_t layoutKey,
+    bool& persistent
+) const
+{
+    Hash hash;
+
+    hash.Add(layoutKey);
+
+    for(const auto shader : {
+            pipelineDesc.vertexShader,
+            pipelineDesc.tessControlShader,
+            pipelineDesc.tessEvaluationShader,
+            pipelineDesc.geometryShader,
+            pipelineDesc.fragmentShader
+        })
+    {
+        if(!shader)
+        {
+            hash.Add(uint64_t(0));
+            continue;
+        }
+
+        // A shader that wasn't created with CreateShader is only known by its pointer,
+        // which means nothing on the next launch
+        if(const auto it = shaderHashes.find(shader); it != shaderHashes.end())
+            hash.Add(it->second);
+        else
+        {
+            hash.Add(reinterpret_cast<uintptr_t>(shader));
+            persistent = false;
+        }
+    }
+
+    const auto& depth = pipelineDesc.depth;
+    const auto& stencil = pipelineDesc.stencil;
+    const auto& rasterizer = pipelineDesc.rasterizer;
+    const auto& blend = pipelineDesc.blend;
+
+    hash.Add(pipelineDesc.indexFormat)
+        .Add(pipelineDesc.primitiveTopology)
+        .Add(depth.testEnabled)
+        .Add(depth.writeEnabled)
+        .Add(depth.compareOp)
+        .Add(stencil.testEnabled)
+        .Add(stencil.referenceDynamic);
+
+    for(const auto& face : { stencil.front, stencil.back })
+    {
+        hash.Add(face.stencilFailOp)
+            .Add(face.depthFailOp)
+            .Add(face.depthPassOp)
+            .Add(face.compareOp)
+            .Add(face.readMask)
+            .Add(face.writeMask)
+            .Add(face.reference);
+    }
+
+    hash.Add(rasterizer.polygonMode)
+        .Add(rasterizer.cullMode)
+        .Add(rasterizer.depthBias.constantFactor)
+        .Add(rasterizer.depthBias.slopeFactor)
+        .Add(rasterizer.depthBias.clamp)
+        .Add(rasterizer.frontCCW)
+        .Add(rasterizer.discardEnabled)
+        .Add(rasterizer.depthClampEnabled)
+        .Add(rasterizer.scissorTestEnabled)
+        .Add(rasterizer.multiSampleEnabled)
+        .Add(rasterizer.antiAliasedLineEnabled)
+        .Add(rasterizer.conservativeRasterization)
+        .Add(rasterizer.lineWidth);
+
+    hash.Add(blend.alphaToCoverageEnabled)
+        .Add(blend.independentBlendEnabled)
+        .Add(blend.sampleMask)
+        .Add(blend.logicOp)
+        .Add(blend.blendFactor, sizeof(blend.blendFactor))
+        .Add(blend.blendFactorDynamic);
+
+    for(const auto& target : blend.targets)
+    {
+        hash.Add(target.blendEnabled)
+            .Add(target.srcColor)
+            .Add(target.dstColor)
+            .Add(target.colorArithmetic)
+            .Add(target.srcAlpha)
+            .Add(target.dstAlpha)
+            .Add(target.alphaArithmetic)
+            .Add(target.colorMask);
+    }
+
+    hash.Add(pipelineDesc.viewports.size());
+
+    for(const auto& viewport : pipelineDesc.viewports)
+    {
+        hash.Add(viewport.x)
+            .Add(viewport.y)
+            .Add(viewport.width)
+            .Add(viewport.height)
+            .Add(viewport.minDepth)
+            .Add(viewport.maxDepth);
+    }
+
+    hash.Add(pipelineDesc.scissors.size());
+
+    for(const auto& scissor : pipelineDesc.scissors)
+        hash.Add(scissor.x).Add(scissor.y).Add(scissor.width).Add(scissor.height);
+
+    return hash.Get();
+}
+
 }
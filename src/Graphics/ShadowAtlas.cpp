@@ -0,0 +1,384 @@
+#include <ShadowAtlas.hpp>
+#include <AssetManager.hpp>
+#include <ShaderAsset.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <ranges>
+
+namespace lustra
+{
+
+void ShadowAtlas::SetConfig(const ShadowAtlasConfig& config)
+{
+    this->config = config;
+
+    this->config.size = std::bit_floor(std::max(config.size, 256u));
+    this->config.maxTileSize = std::bit_floor(std::clamp(config.maxTileSize, 16u, this->config.size));
+    this->config.minTileSize = std::bit_floor(std::clamp(config.minTileSize, 16u, this->config.maxTileSize));
+    this->config.maxShadows = std::max(config.maxShadows, 1u);
+
+    if(texture)
+    {
+        Renderer::Get().Release(texture);
+        Renderer::Get().Release(renderTarget);
+        Renderer::Get().Release(shadowBuffer);
+
+        texture = nullptr;
+        renderTarget = nullptr;
+        shadowBuffer = nullptr;
+    }
+
+    Reset();
+}
+
+void ShadowAtlas::Allocate(std::span<Request> requests)
+{
+    if(!texture)
+        Create();
+
+    std::ranges::sort(requests, std::ranges::greater{}, &Request::importance);
+
+    if(requests.size() > config.maxShadows)
+        requests = requests.first(config.maxShadows);
+
+    for(auto& request : requests)
+        request.size = std::bit_floor(std::clamp(request.size, config.minTileSize, config.maxTileSize));
+
+    requested.clear();
+
+    for(const auto& request : requests)
+        requested.push_back(request.key);
+
+    std::ranges::sort(requested);
+
+    // Lights that lost their shadow or went out of budget
+    std::erase_if(tiles, [&](const auto& pair)
+    {
+        if(std::ranges::binary_search(requested, pair.first))
+            return false;
+
+        FreeNode({ pair.second.x, pair.second.y }, pair.second.size);
+
+        return true;
+    });
+
+    // Tiles that became too small or way too big. A tile that is smaller than the request because
+    // the atlas was full stays, otherwise it would be freed and rendered again every frame
+    for(const auto& request : requests)
+    {
+        const auto it = tiles.find(request.key);
+
+        if(it == tiles.end())
+            continue;
+
+        const auto& tile = it->second;
+
+        if((request.size > tile.size && request.size != tile.requestedSize) || request.size * 2 < tile.size)
+        {
+            FreeNode({ it->second.x, it->second.y }, it->second.size);
+
+            tiles.erase(it);
+        }
+    }
+
+    // The most important lights go first, if there's no room left a smaller tile is tried.
+    // Lights that already have a tile are never evicted to make room for others
+    for(const auto& request : requests)
+    {
+        if(tiles.contains(request.key))
+            continue;
+
+        for(uint32_t size = request.size; size >= config.minTileSize; size /= 2)
+        {
+            if(Node node; AllocateNode(size, node))
+            {
+                tiles[request.key] = { .x = node.x, .y = node.y, .size = size, .requestedSize = request.size };
+                break;
+            }
+        }
+    }
+
+    // The old tile is only given up once a bigger one is allocated
+    for(const auto& request : requests)
+    {
+        const auto it = tiles.find(request.key);
+
+        if(it == tiles.end() || it->second.size >= request.size)
+            continue;
+
+        for(uint32_t size = request.size; size > it->second.size; size /= 2)
+        {
+            if(Node node; AllocateNode(size, node))
+            {
+                FreeNode({ it->second.x, it->second.y }, it->second.size);
+
+                it->second = { .x = node.x, .y = node.y, .size = size, .requestedSize = request.size };
+                break;
+            }
+        }
+    }
+}
+
+void ShadowAtlas::Invalidate()
+{
+    for(auto& tile : tiles | std::views::values)
+        tile.dirty = true;
+}
+
+void ShadowAtlas::SetOwner(const void* owner)
+{
+    if(this->owner != owner)
+        Invalidate();
+
+    this->owner = owner;
+}
+
+void ShadowAtlas::Upload(const std::span<const Shadow> shadows)
+{
+    if(!texture)
+        Create();
+
+    const auto count = std::min<size_t>(shadows.size(), config.maxShadows);
+
+    if(count > 0)
+        Renderer::Get().WriteBuffer(*shadowBuffer, 0, shadows.data(), count * sizeof(Shadow));
+}
+
+ShadowAtlas::Tile* ShadowAtlas::GetTile(const uint32_t key)
+{
+    const auto it = tiles.find(key);
+
+    return it == tiles.end() ? nullptr : &it->second;
+}
+
+glm::vec4 ShadowAtlas::GetRect(const Tile& tile) const
+{
+    const auto size = static_cast<float>(config.size);
+
+    return glm::vec4(tile.x, tile.y, tile.size, tile.size) / size;
+}
+
+void ShadowAtlas::SetTileViewport(LLGL::CommandBuffer* commandBuffer, const Tile& tile)
+{
+    const auto x = static_cast<int32_t>(tile.x);
+    const auto y = static_cast<int32_t>(tile.y);
+    const auto size = static_cast<int32_t>(tile.size);
+
+    commandBuffer->SetViewport(LLGL::Viewport(x, y, size, size));
+    commandBuffer->SetScissor(LLGL::Scissor(x, y, size, size));
+}
+
+const ShadowAtlasConfig& ShadowAtlas::GetConfig() const
+{
+    return config;
+}
+
+LLGL::Texture* ShadowAtlas::GetTexture()
+{
+    if(!texture)
+        Create();
+
+    return texture;
+}
+
+LLGL::RenderTarget* ShadowAtlas::GetRenderTarget()
+{
+    if(!texture)
+        Create();
+
+    return renderTarget;
+}
+
+LLGL::PipelineState* ShadowAtlas::GetPipeline()
+{
+    if(!texture)
+        Create();
+
+    return pipeline;
+}
+
+LLGL::PipelineState* ShadowAtlas::GetSkinnedPipeline()
+{
+    if(!texture)
+        Create();
+
+    return skinnedPipeline;
+}
+
+LLGL::Buffer* ShadowAtlas::GetShadowBuffer()
+{
+    if(!texture)
+        Create();
+
+    return shadowBuffer;
+}
+
+void ShadowAtlas::Create()
+{
+    const LLGL::TextureDescriptor depthDesc =
+    {
+        .type = LLGL::TextureType::Texture2D,
+        .bindFlags = LLGL::BindFlags::DepthStencilAttachment | LLGL::BindFlags::Sampled,
+        .format = LLGL::Format::D32Float,
+        .extent = { config.size, config.size, 1 },
+        .mipLevels = 1,
+        .samples = 1
+    };
+
+    texture = Renderer::Get().CreateTexture(depthDesc);
+    renderTarget = Renderer::Get().CreateRenderTarget({ config.size, config.size }, {}, texture);
+
+    LLGL::BufferDescriptor shadowBufferDesc;
+
+    shadowBufferDesc.size = config.maxShadows * sizeof(Shadow);
+    shadowBufferDesc.stride = sizeof(Shadow);
+    shadowBufferDesc.bindFlags = LLGL::BindFlags::Storage;
+
+    shadowBuffer = Renderer::Get().CreateBuffer(shadowBufferDesc);
+
+    // The render pass of every depth-only target is the same, so is the pipeline
+    if(!pipeline)
+    {
+        pipeline = CreatePipeline(false);
+        skinnedPipeline = CreatePipeline(true);
+    }
+
+    Reset();
+}
+
+LLGL::PipelineState* ShadowAtlas::CreatePipeline(const bool skinned) const
+{
+    auto vertexShader = AssetManager::Get().Load<VertexShaderAsset>("depth.vert", true)->shader;
+
+    if(skinned)
+        vertexShader = Renderer::Get().GetShaderVariant(
+            vertexShader, { "SKINNED" }, Renderer::Get().GetSkinnedVertexFormat().attributes
+        );
+
+    LLGL::PipelineLayoutDescriptor layoutDesc
+    {
+        .bindings =
+        {
+            { "matrices", LLGL::ResourceType::Buffer, LLGL::BindFlags::ConstantBuffer, LLGL::StageFlags::VertexStage, 1 }
+        }
+    };
+
+    if(skinned)
+    {
+        layoutDesc.bindings.push_back(
+            { "skinning", LLGL::ResourceType::Buffer, LLGL::BindFlags::Storage, LLGL::StageFlags::VertexStage, 2 }
+        );
+        layoutDesc.uniforms.push_back({ "paletteOffset", LLGL::UniformType::Int1 });
+    }
+
+    return Renderer::Get().CreatePipelineState(
+        layoutDesc,
+        LLGL::GraphicsPipelineDescriptor
+        {
+            .renderPass = renderTarget->GetRenderPass(),
+            .vertexShader = vertexShader,
+            .fragmentShader = AssetManager::Get().Load<FragmentShaderAsset>("depth.frag", true)->shader,
+            .depth = LLGL::DepthDescriptor
+            {
+                .testEnabled = true,
+                .writeEnabled = true
+            },
+            .rasterizer = LLGL::RasterizerDescriptor
+            {
+                .cullMode = LLGL::CullMode::Disabled, // Make it configurable in future?
+                .depthBias =
+                {
+                    .constantFactor = 4.0f,
+                    .slopeFactor = 1.5f
+                },
+                .frontCCW = true,
+                .scissorTestEnabled = true // Clearing a tile mustn't touch the others
+            },
+            .blend =
+            {
+                .targets =
+                {
+                    {
+                        .colorMask = 0x0
+                    }
+                }
+            }
+        }
+    );
+}
+
+void ShadowAtlas::Reset()
+{
+    tiles.clear();
+
+    freeNodes.assign(GetLevel(config.minTileSize) + 1, {});
+    freeNodes[0].push_back({ 0, 0 });
+}
+
+bool ShadowAtlas::AllocateNode(const uint32_t size, Node& node)
+{
+    const auto level = GetLevel(size);
+
+    // The smallest free node that can fit the tile
+    auto found = static_cast<int>(level);
+
+    while(found >= 0 && freeNodes[found].empty())
+        found--;
+
+    if(found < 0)
+        return false;
+
+    node = freeNodes[found].back();
+    freeNodes[found].pop_back();
+
+    // Split it down to the requested size, keeping the top-left quarter
+    for(auto current = static_cast<uint32_t>(found); current < level; current++)
+    {
+        const auto half = config.size >> (current + 1);
+
+        freeNodes[current + 1].push_back({ node.x + half, node.y });
+        freeNodes[current + 1].push_back({ node.x, node.y + half });
+        freeNodes[current + 1].push_back({ node.x + half, node.y + half });
+    }
+
+    return true;
+}
+
+void ShadowAtlas::FreeNode(Node node, uint32_t size)
+{
+    auto level = GetLevel(size);
+
+    // Merge with the siblings while all of them are free
+    while(level > 0)
+    {
+        const auto parentSize = size * 2;
+        const Node parent = { node.x - node.x % parentSize, node.y - node.y % parentSize };
+
+        auto& nodes = freeNodes[level];
+
+        const auto isSibling = [&](const Node& other)
+        {
+            return other.x - other.x % parentSize == parent.x
+                && other.y - other.y % parentSize == parent.y;
+        };
+
+        if(std::ranges::count_if(nodes, isSibling) < 3)
+            break;
+
+        std::erase_if(nodes, isSibling);
+
+        node = parent;
+        size = parentSize;
+        level--;
+    }
+
+    freeNodes[level].push_back(node);
+}
+
+uint32_t ShadowAtlas::GetLevel(const uint32_t size) const
+{
+    return static_cast<uint32_t>(std::countr_zero(config.size) - std::countr_zero(size));
+}
+
+}
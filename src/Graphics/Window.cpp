@@ -1,4 +1,5 @@
 #include <Window.hpp>
+#include <Keyboard.hpp>
 #include <Mouse.hpp>
 
 namespace lustra
@@ -168,6 +169,8 @@ GLFWwindow* Window::CreateWindow() const
     glfwSetFramebufferSizeCallback(window, OnWindowResize);
     glfwSetWindowFocusCallback(window, OnWindowFocus);
     glfwSetScrollCallback(window, Mouse::ScrollCallback);
+    glfwSetKeyCallback(window, Keyboard::KeyCallback);
+    glfwSetMouseButtonCallback(window, Mouse::ButtonCallback);
 
     return window;
 }
@@ -1,54 +1,198 @@
 #include <InputManager.hpp>
 
+#include <algorithm>
+
 namespace lustra
 {
 
 void InputManager::Update()
 {
-    for(auto const& [action, keys] : keyboardMapping)
+    for(auto& state : actionStates)
     {
-        bool isPressed = false;
+        state.justPressed = state.pressedLatch;
+        state.justReleased = state.releasedLatch;
 
-        for(auto& key : keys)
-            if(Keyboard::IsKeyPressed(key))
-            {
-                isPressed = true;
-                break;
-            }
+        // A tap that started and ended within one frame still counts as pressed for that frame
+        state.pressed = state.held > 0 || state.justPressed;
 
-        actionStates[action] = isPressed;
+        state.pressedLatch = state.releasedLatch = false;
     }
+}
 
-    for(auto const& [action, buttons] : mouseMapping)
-    {
-        bool isPressed = false;
+InputManager::ActionId InputManager::RegisterAction(const std::string& action)
+{
+    const auto [it, inserted] = actionIds.try_emplace(action, static_cast<ActionId>(actionStates.size()));
 
-        for(auto& button : buttons)
-            if(Mouse::IsButtonPressed(button))
-            {
-                isPressed = true;
-                break;
-            }
+    if(inserted)
+        actionStates.emplace_back();
 
-        actionStates[action] = isPressed;
-    }
+    return it->second;
+}
+
+InputManager::ActionId InputManager::GetActionId(const std::string& action) const
+{
+    const auto it = actionIds.find(action);
+
+    return it == actionIds.end() ? invalidAction : it->second;
+}
+
+void InputManager::MapAction(const ActionId action, const Keyboard::Key key)
+{
+    const auto index = static_cast<size_t>(key);
+
+    if(action >= actionStates.size() || index >= keyCount)
+        return;
+
+    auto& actions = keyActions[index];
+
+    if(std::ranges::find(actions, action) != actions.end())
+        return;
+
+    actions.push_back(action);
+
+    if(keyStates[index])
+        actionStates[action].held++;
+}
+
+void InputManager::MapAction(const ActionId action, const Mouse::Button button)
+{
+    const auto index = static_cast<size_t>(button);
+
+    if(action >= actionStates.size() || index >= buttonCount)
+        return;
+
+    auto& actions = buttonActions[index];
+
+    if(std::ranges::find(actions, action) != actions.end())
+        return;
+
+    actions.push_back(action);
+
+    if(buttonStates[index])
+        actionStates[action].held++;
 }
 
 void InputManager::MapAction(const std::string& action, const Keyboard::Key key)
 {
-    keyboardMapping[action].push_back(key);
+    MapAction(RegisterAction(action), key);
 }
 
 void InputManager::MapAction(const std::string& action, const Mouse::Button button)
 {
-    mouseMapping[action].push_back(button);
+    MapAction(RegisterAction(action), button);
 }
 
-bool InputManager::IsActionPressed(const std::string& action)
+bool InputManager::IsActionPressed(const ActionId action) const
 {
-    const auto it = actionStates.find(action);
+    return action < actionStates.size() && actionStates[action].pressed;
+}
+
+bool InputManager::IsActionJustPressed(const ActionId action) const
+{
+    return action < actionStates.size() && actionStates[action].justPressed;
+}
+
+bool InputManager::IsActionJustReleased(const ActionId action) const
+{
+    return action < actionStates.size() && actionStates[action].justReleased;
+}
+
+bool InputManager::IsActionPressed(const std::string& action) const
+{
+    return IsActionPressed(GetActionId(action));
+}
+
+bool InputManager::IsActionJustPressed(const std::string& action) const
+{
+    return IsActionJustPressed(GetActionId(action));
+}
+
+bool InputManager::IsActionJustReleased(const std::string& action) const
+{
+    return IsActionJustReleased(GetActionId(action));
+}
+
+bool InputManager::IsKeyDown(const Keyboard::Key key) const
+{
+    const auto index = static_cast<size_t>(key);
+
+    return index < keyCount && keyStates[index];
+}
+
+bool InputManager::IsButtonDown(const Mouse::Button button) const
+{
+    const auto index = static_cast<size_t>(button);
+
+    return index < buttonCount && buttonStates[index];
+}
+
+uint64_t InputManager::GetEventCursor() const
+{
+    return eventsWritten;
+}
+
+void InputManager::OnKey(const int key, const int action)
+{
+    PushEvent(InputEvent::Device::Keyboard, key, action);
+
+    // Key::Unknown is -1, and repeats don't change the state
+    if(key < 0 || static_cast<size_t>(key) >= keyCount || action == GLFW_REPEAT)
+        return;
+
+    const bool down = action == GLFW_PRESS;
+
+    if(keyStates[key] == down)
+        return;
+
+    keyStates[key] = down;
+
+    OnInput(keyActions[key], down);
+}
+
+void InputManager::OnButton(const int button, const int action)
+{
+    PushEvent(InputEvent::Device::Mouse, button, action);
+
+    if(button < 0 || static_cast<size_t>(button) >= buttonCount)
+        return;
+
+    const bool down = action == GLFW_PRESS;
+
+    if(buttonStates[button] == down)
+        return;
+
+    buttonStates[button] = down;
+
+    OnInput(buttonActions[button], down);
+}
+
+void InputManager::OnInput(const std::vector<ActionId>& actions, const bool down)
+{
+    for(const auto action : actions)
+    {
+        auto& state = actionStates[action];
+
+        if(down)
+        {
+            if(state.held++ == 0)
+                state.pressedLatch = true;
+        }
+        else if(state.held > 0 && --state.held == 0)
+            state.releasedLatch = true;
+    }
+}
+
+void InputManager::PushEvent(const InputEvent::Device device, const int code, const int action)
+{
+    events[eventsWritten % eventBufferSize] =
+    {
+        .device = device,
+        .action = static_cast<InputEvent::Action>(action),
+        .code = code,
+        .time = glfwGetTime()
+    };
 
-    return it == actionStates.end() ? false : it->second;
+    eventsWritten++;
 }
 
 }
@@ -1,8 +1,14 @@
 #include <Keyboard.hpp>
+#include <InputManager.hpp>
 
 namespace lustra::Keyboard
 {
 
+void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    InputManager::Get().OnKey(key, action);
+}
+
 bool IsKeyPressed(Key key)
 {
     return glfwGetKey(Window::GetLastCreatedGLFWWindow(), static_cast<int>(key)) == GLFW_PRESS;
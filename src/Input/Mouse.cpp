@@ -1,4 +1,5 @@
 #include <Mouse.hpp>
+#include <InputManager.hpp>
 
 namespace lustra::Mouse
 {
@@ -10,6 +11,11 @@ void ScrollCallback(GLFWwindow* window, double x, double y)
     Scroll::offset = { x, y };
 }
 
+void ButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    InputManager::Get().OnButton(button, action);
+}
+
 void SetCursorVisible(const bool visible)
 {
     glfwSetInputMode(Window::GetLastCreatedGLFWWindow(), GLFW_CURSOR, visible ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
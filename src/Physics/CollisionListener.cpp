@@ -0,0 +1,164 @@
+#include <CollisionListener.hpp>
+#include <EventBus.hpp>
+
+namespace lustra
+{
+
+CollisionListener::CollisionListener()
+{
+    static std::atomic<uint64_t> nextGeneration = 1;
+
+    generation = nextGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+JPH::ValidateResult CollisionListener::OnContactValidate(
+    const JPH::Body& body1,
+    const JPH::Body& body2,
+    JPH::RVec3Arg baseOffset,
+    const JPH::CollideShapeResult& result
+)
+{
+    return JPH::ValidateResult::AcceptAllContactsForThisBodyPair;
+}
+
+void CollisionListener::OnContactAdded(
+    const JPH::Body& body1,
+    const JPH::Body& body2,
+    const JPH::ContactManifold& manifold,
+    JPH::ContactSettings& settings
+)
+{
+    if(Accept(body1, body2))
+        GetThreadBuffer()[static_cast<size_t>(CollisionEvent::State::Added)]
+            .emplace_back(body1, body2, manifold, CollisionEvent::State::Added);
+}
+
+void CollisionListener::OnContactPersisted(
+    const JPH::Body& body1,
+    const JPH::Body& body2,
+    const JPH::ContactManifold& manifold,
+    JPH::ContactSettings& settings
+)
+{
+    if(reportPersisted && Accept(body1, body2))
+        GetThreadBuffer()[static_cast<size_t>(CollisionEvent::State::Persisted)]
+            .emplace_back(body1, body2, manifold, CollisionEvent::State::Persisted);
+}
+
+void CollisionListener::OnContactRemoved(const JPH::SubShapeIDPair& subShapePair)
+{
+    // Bodies can't be accessed here, the layer mask is applied in Flush()
+    if(IsWatched(subShapePair.GetBody1ID(), subShapePair.GetBody2ID()))
+        GetThreadBuffer()[static_cast<size_t>(CollisionEvent::State::Removed)]
+            .emplace_back(subShapePair.GetBody1ID(), subShapePair.GetBody2ID());
+}
+
+void CollisionListener::Flush(const JPH::BodyLockInterface& bodyLockInterface)
+{
+    batch.clear();
+
+    for(size_t state = 0; state < 3; state++)
+    {
+        for(const auto& buffer : buffers)
+        {
+            auto& events = (*buffer)[state];
+
+            for(auto& event : events)
+            {
+                event.body1 = bodyLockInterface.TryGetBody(event.bodyId1);
+                event.body2 = bodyLockInterface.TryGetBody(event.bodyId2);
+
+                if(event.state == CollisionEvent::State::Removed && event.body1 && event.body2
+                   && !Accept(*event.body1, *event.body2))
+                    continue;
+
+                batch.push_back(event);
+            }
+
+            events.clear(); // Keeps the capacity, so the next step doesn't allocate
+        }
+    }
+
+    if(!batch.empty())
+        EventBus::Get().PublishBatch<CollisionEvent>(batch);
+}
+
+void CollisionListener::SetLayerMask(const uint32_t mask)
+{
+    layerMask = mask;
+}
+
+void CollisionListener::SetReportPersisted(const bool report)
+{
+    reportPersisted = report;
+}
+
+void CollisionListener::WatchBody(const JPH::BodyID& bodyId)
+{
+    watchedBodies.insert(bodyId.GetIndexAndSequenceNumber());
+}
+
+void CollisionListener::UnwatchBody(const JPH::BodyID& bodyId)
+{
+    watchedBodies.erase(bodyId.GetIndexAndSequenceNumber());
+}
+
+void CollisionListener::ClearWatchedBodies()
+{
+    watchedBodies.clear();
+}
+
+uint32_t CollisionListener::GetLayerMask() const
+{
+    return layerMask;
+}
+
+bool CollisionListener::IsReportingPersisted() const
+{
+    return reportPersisted;
+}
+
+CollisionListener::Buffer& CollisionListener::GetThreadBuffer()
+{
+    thread_local struct
+    {
+        uint64_t generation = 0;
+        Buffer* buffer = nullptr;
+    } local;
+
+    if(local.generation != generation)
+    {
+        std::lock_guard lock(buffersMutex);
+
+        buffers.push_back(std::make_unique<Buffer>());
+
+        local = { generation, buffers.back().get() };
+    }
+
+    return *local.buffer;
+}
+
+bool CollisionListener::Accept(const JPH::Body& body1, const JPH::Body& body2) const
+{
+    // The mask only covers the first 32 layers, the ones above it never match
+    const auto layerBit = [&](const JPH::Body& body)
+    {
+        const auto layer = body.GetObjectLayer();
+
+        return layer < 32 ? 1u << layer : 0u;
+    };
+
+    if(!(layerMask & (layerBit(body1) | layerBit(body2))))
+        return false;
+
+    return IsWatched(body1.GetID(), body2.GetID());
+}
+
+bool CollisionListener::IsWatched(const JPH::BodyID& bodyId1, const JPH::BodyID& bodyId2) const
+{
+    return watchedBodies.empty()
+           || watchedBodies.contains(bodyId1.GetIndexAndSequenceNumber())
+           || watchedBodies.contains(bodyId2.GetIndexAndSequenceNumber());
+}
+
+}
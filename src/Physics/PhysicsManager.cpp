@@ -49,6 +49,9 @@ void PhysicsManager::Update(const float deltaTime) const
 {
     physicsSystem->OptimizeBroadPhase();
     physicsSystem->Update(deltaTime, 1, tempAllocator.get(), jobSystem.get());
+
+    // Contacts are only buffered during the step, deliver them all at once
+    collisionListener->Flush(physicsSystem->GetBodyLockInterfaceNoLock());
 }
 
 void PhysicsManager::DestroyBody(const JPH::BodyID& bodyId) const
@@ -81,4 +84,9 @@ JPH::BodyInterface& PhysicsManager::GetBodyInterface() const
     return physicsSystem->GetBodyInterface();
 }
 
+CollisionListener& PhysicsManager::GetCollisionListener() const
+{
+    return *collisionListener;
+}
+
 }
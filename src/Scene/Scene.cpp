@@ -1,8 +1,16 @@
 #include <Scene.hpp>
 #include <Entity.hpp>
+#include <Hash.hpp>
+#include <AnimationManager.hpp>
 #include <ScriptManager.hpp>
 #include <Listener.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <ranges>
+
 namespace lustra
 {
 
@@ -14,19 +22,33 @@ Scene::Scene()
 Scene::~Scene()
 {
     EventManager::Get().RemoveListener(Event::Type::WindowResize, this);
-    EventManager::Get().RemoveListener(Event::Type::Collision, this);
+
+    EventBus::Get().Unsubscribe(assetLoadedSubscription);
+    EventBus::Get().Unsubscribe(collisionSubscription);
+
+    // Another scene might get the same address
+    ShadowAtlas::Get().SetOwner(nullptr);
+
+    // Unlike the meshes of the models, the batches belong to the scene
+    if(Renderer::Get().IsInit())
+        for(const auto& batch : staticBatches | std::views::values)
+            if(batch.mesh)
+                batch.mesh->ReleaseBuffers();
 }
 
 void Scene::Setup()
 {
     EventManager::Get().AddListener(Event::Type::WindowResize, this);
-    EventManager::Get().AddListener(Event::Type::Collision, this);
 
-    if(!lightsBuffer)
-    {
-        SetupLightsBuffer();
-        SetupShadowsBuffer();
-    }
+    if(!assetLoadedSubscription.IsValid())
+        assetLoadedSubscription = EventBus::Get().Subscribe<AssetLoadedEvent>(
+            [this](const auto events) { OnAssetLoaded(events); }
+        );
+
+    if(!collisionSubscription.IsValid())
+        collisionSubscription = EventBus::Get().Subscribe<CollisionEvent>(
+            [this](const auto events) { OnCollision(events); }
+        );
 }
 
 void Scene::Start()
@@ -50,18 +72,25 @@ void Scene::Update(float deltaTime)
 
     if(updatePhysics)
         PhysicsManager::Get().Update(deltaTime);
+
+    animationDeltaTime += deltaTime;
 }
 
 void Scene::Draw(LLGL::RenderTarget* renderTarget)
 {
-    RenderToShadowMap();
-
     UpdateRigidBodies();
+    UpdateSkies();
+    UpdateStaticBatches();
 
     SetupCamera();
     SetupLights();
     SetupShadows();
 
+    // Needs the shadow lights to know who's visible, the shadow maps need the palettes
+    UpdateAnimations();
+
+    RenderToShadowMap();
+
     UpdateSounds();
 
     Renderer::Get().Begin();
@@ -75,6 +104,14 @@ void Scene::Draw(LLGL::RenderTarget* renderTarget)
 
     Renderer::Get().Submit();
 
+    // Only the Hi-Z trace of the SSR reads the pyramid, and SSR only runs with the tonemapping
+    const auto ssrView = registry.view<SSRComponent>();
+    const auto tonemapView = registry.view<TonemapComponent>();
+
+    if(ssrView->begin() != ssrView->end() && ssrView->begin()->hiZ
+       && tonemapView->begin() != tonemapView->end() && tonemapView->begin()->postProcessing)
+        HiZBuffer::Get().Build(DeferredRenderer::Get().GetDepth());
+
     ApplyPostProcessing(renderTarget);
 }
 
@@ -108,31 +145,100 @@ void Scene::OnEvent(Event& event)
         }
         break;
 
-        case Event::Type::Collision:
+        default:
+            break;
+    }
+}
+
+void Scene::OnCollision(const std::span<const CollisionEvent> events)
+{
+    if(!isRunning)
+        return;
+
+    static constexpr std::array<std::string_view, 3> declarations =
+    {
+        "void OnCollision(CollisionEvent@)",
+        "void OnCollisionPersisted(CollisionEvent@)",
+        "void OnCollisionRemoved(CollisionEvent@)"
+    };
+
+    // Events are grouped by state, so every script function gets a contiguous range
+    std::array<std::span<const CollisionEvent>, 3> ranges;
+
+    auto begin = events.begin();
+
+    for(size_t state = 0; state < ranges.size(); state++)
+    {
+        const auto end = std::find_if(begin, events.end(), [&](const auto& event)
         {
-            auto collisionEvent = dynamic_cast<CollisionEvent*>(&event);
+            return static_cast<size_t>(event.GetState()) != state;
+        });
 
-            registry.view<ScriptComponent>(entt::exclude<PrefabComponent>)
-                .each([&](auto, auto& script)
-            {
-                if(script.script)
+        ranges[state] = { begin, end };
+        begin = end;
+    }
+
+    registry.view<ScriptComponent>(entt::exclude<PrefabComponent>)
+        .each([&](auto, auto& script)
+    {
+        if(!script.script)
+            return;
+
+        for(size_t state = 0; state < ranges.size(); state++)
+        {
+            const auto range = ranges[state];
+
+            ScriptManager::Get().ExecuteFunction(
+                script.script,
+                declarations[state],
+                range.size(),
+                [&](auto context, const size_t index)
                 {
-                    ScriptManager::Get().ExecuteFunction(
-                        script.script,
-                        "void OnCollision(CollisionEvent@)",
-                        [&](auto context)
-                        {
-                            context->SetArgAddress(0, collisionEvent);
-                        },
-                        script.moduleIndex
-                    );
-                }
-            });
+                    context->SetArgAddress(0, const_cast<CollisionEvent*>(&range[index]));
+                },
+                script.moduleIndex
+            );
         }
-        break;
+    });
+}
 
-        default:
-            break;
+void Scene::OnAssetLoaded(const std::span<const AssetLoadedEvent> events)
+{
+    // Entities usually share a handful of shader pairs, each of them is only looked up once
+    std::map<std::pair<LLGL::Shader*, LLGL::Shader*>, LLGL::PipelineState*> rebuilt;
+
+    for(const auto& event : events)
+    {
+        const auto type = event.GetAsset()->type;
+
+        if(type != Asset::Type::VertexShader && type != Asset::Type::FragmentShader)
+            continue;
+
+        const auto reload = [&](PipelineComponent& pipeline)
+        {
+            if(!pipeline.vertexShader || !pipeline.fragmentShader
+               || (event.GetAsset() != pipeline.vertexShader && event.GetAsset() != pipeline.fragmentShader))
+                return;
+
+            auto& state = rebuilt[{ pipeline.vertexShader->shader, pipeline.fragmentShader->shader }];
+
+            if(!state)
+            {
+                pipeline.SetupPipeline();
+                state = pipeline.pipeline;
+            }
+            else
+            {
+                pipeline.pipeline = state;
+                pipeline.variants.clear();
+            }
+        };
+
+        registry.view<PipelineComponent>().each(reload);
+
+        // The batches keep copies of the pipelines of their entities
+        for(auto& batch : staticBatches | std::views::values)
+            reload(batch.pipeline);
     }
 }
 
@@ -344,46 +450,24 @@ void Scene::UpdateScript(const ScriptComponent& script, Entity entity, float del
     }
 }
 
-void Scene::SetupLightsBuffer()
-{
-    static constexpr uint64_t maxLights = 128;
-
-    const LLGL::BufferDescriptor lightBufferDesc = LLGL::ConstantBufferDesc(maxLights * sizeof(Light));
-
-    lightsBuffer = Renderer::Get().CreateBuffer("sceneLightBuffer", lightBufferDesc);
-
-    lights.reserve(maxLights);
-}
-
-void Scene::SetupShadowsBuffer()
-{
-    static constexpr uint64_t maxShadows = 4;
-
-    const LLGL::BufferDescriptor shadowBufferDesc = LLGL::ConstantBufferDesc(maxShadows * sizeof(Shadow));
-
-    shadowsBuffer = Renderer::Get().CreateBuffer("sceneShadowBuffer", shadowBufferDesc);
-
-    shadows.reserve(maxShadows);
-}
-
 void Scene::UpdateLightsBuffer()
 {
-    Renderer::Get().RenderPass(
-        [&](auto commandBuffer)
-        {
-            commandBuffer->UpdateBuffer(*lightsBuffer, 0, lights.data(), lights.size() * sizeof(Light));
-        }, {}, [](auto) {}, nullptr
+    const auto near = camera ? camera->GetNear() : 0.1f;
+    const auto far = camera ? camera->GetFar() : 1000.0f;
+
+    LightClusters::Get().Build(
+        lights,
+        Renderer::Get().GetMatrices()->GetView(),
+        Renderer::Get().GetMatrices()->GetProjection(),
+        near, far
     );
+
+    LightClusters::Get().Upload(lights);
 }
 
 void Scene::UpdateShadowsBuffer()
 {
-    Renderer::Get().RenderPass(
-        [&](auto commandBuffer)
-        {
-            commandBuffer->UpdateBuffer(*shadowsBuffer, 0, shadows.data(), shadows.size() * sizeof(Shadow));
-        }, {}, [](auto) {}, nullptr
-    );
+    ShadowAtlas::Get().Upload(shadows);
 }
 
 void Scene::UpdateRigidBodies()
@@ -422,29 +506,128 @@ void Scene::UpdateRigidBodies()
     }
 }
 
+void Scene::UpdateSkies()
+{
+    // Time-sliced builds, they continue even when the scene isn't running
+    registry.view<ProceduralSkyComponent>(entt::exclude<PrefabComponent>).each(
+        [](ProceduralSkyComponent& sky)
+        {
+            sky.Update();
+        }
+    );
+}
+
 void Scene::UpdateSounds()
 {
     const auto soundsView = registry.view<SoundComponent, TransformComponent>(entt::exclude<PrefabComponent>);
 
+    const auto listenerPosition = Listener::GetPosition();
+
+    audibleSounds.clear();
+
+    uint32_t realCount = 0, virtualCount = 0;
+
     for(const auto entity : soundsView)
     {
         auto [sound, transform] =
             soundsView.get<SoundComponent, TransformComponent>(entity);
 
-        auto worldTransform = transform;
+        if(!sound.sound || !sound.sound->sound.GetSound().get())
+            continue;
 
-        if(registry.all_of<HierarchyComponent>(entity))
-            worldTransform.SetTransform(GetWorldTransform(entity));
+        const auto& emitter = sound.sound->sound;
+
+        if(sound.attached)
+        {
+            auto worldTransform = transform;
+
+            if(registry.all_of<HierarchyComponent>(entity))
+                worldTransform.SetTransform(GetWorldTransform(entity));
+
+            // Only touch miniaudio for the emitters that have moved
+            if(worldTransform.position != sound.lastPosition || worldTransform.rotation != sound.lastRotation)
+            {
+                emitter.SetPosition(worldTransform.position);
+                emitter.SetOrientation(glm::radians(worldTransform.rotation));
+
+                sound.lastPosition = worldTransform.position;
+                sound.lastRotation = worldTransform.rotation;
+            }
+        }
+
+        const bool playing = emitter.IsPlaying();
+
+        // Restarted or stopped by a script
+        if(sound.virtualized && (playing || emitter.GetStopCount() != sound.virtualizedStopCount))
+            sound.virtualized = false;
+
+        if(!sound.virtualized && !playing)
+            continue;
+
+        if(!emitter.IsSpatializationEnabled())
+        {
+            realCount++;
+            continue;
+        }
+
+        const float distance = glm::distance(emitter.GetPosition(), listenerPosition);
+
+        if(distance > emitter.GetMaxDistance())
+        {
+            if(!sound.virtualized)
+            {
+                emitter.Stop();
+                sound.virtualized = true;
+                sound.virtualizedStopCount = emitter.GetStopCount();
+            }
 
-        if(sound.sound)
+            virtualCount++;
+        }
+        else
+            audibleSounds.push_back({ entity, AudioManager::Get().GetPriority(emitter), distance });
+    }
+
+    // Over the voice cap the least important (then the farthest) emitters are virtualized.
+    // The pooled instances and the non-spatialized emitters already take their share of the cap
+    const auto maxVoices = AudioManager::Get().GetMaxVoices();
+    const auto taken = std::min(maxVoices, AudioManager::Get().GetPlayingVoiceCount() + realCount);
+    const auto budget = std::min<size_t>(maxVoices - taken, audibleSounds.size());
+
+    if(budget < audibleSounds.size())
+        std::ranges::nth_element(audibleSounds, audibleSounds.begin() + budget, [](const auto& a, const auto& b)
+        {
+            return a.priority != b.priority ? a.priority > b.priority : a.distance < b.distance;
+        });
+
+    for(size_t i = 0; i < audibleSounds.size(); i++)
+    {
+        auto& sound = registry.get<SoundComponent>(audibleSounds[i].entity);
+        const auto& emitter = sound.sound->sound;
+
+        if(i < budget)
+        {
+            if(sound.virtualized)
+            {
+                ma_sound_start(emitter.GetHandle()); // Resumes from where it was paused
+                sound.virtualized = false;
+            }
+
+            realCount++;
+        }
+        else
         {
-            if(sound.sound->sound.GetSound().get() && sound.attached) // ??? :/
+            if(!sound.virtualized)
             {
-                sound.sound->sound.SetPosition(worldTransform.position);
-                sound.sound->sound.SetOrientation(glm::radians(worldTransform.rotation));
+                emitter.Stop();
+                sound.virtualized = true;
+                sound.virtualizedStopCount = emitter.GetStopCount();
             }
+
+            virtualCount++;
         }
     }
+
+    AudioManager::Get().SetEmitterStats(realCount, virtualCount);
 }
 
 void Scene::SetupCamera()
@@ -502,7 +685,13 @@ void Scene::SetupCamera()
 
 void Scene::SetupLights()
 {
+    // For the lights without a range. The attenuation is 10 / distance,
+    // the light is cut off where it falls below this value
+    static constexpr float influenceThreshold = 0.02f;
+    static constexpr float maxRadius = 1000.0f;
+
     lights.clear();
+    lightEntities.clear();
 
     const auto lightsView = registry.view<LightComponent, TransformComponent>(entt::exclude<PrefabComponent>);
 
@@ -516,15 +705,22 @@ void Scene::SetupLights()
         if(registry.all_of<HierarchyComponent>(entity))
             localTransform.SetTransform(GetWorldTransform(entity));
 
+        lightEntities.push_back(entity);
+
         lights.push_back(
             {
-                static_cast<int>(light.shadowMap),
+                -1, // Assigned in SetupShadows()
                 localTransform.position,
                 glm::quat(glm::radians(localTransform.rotation)) * glm::vec3(0.0f, 0.0f, -1.0f),
                 light.color,
                 light.intensity,
                 glm::cos(glm::radians(light.cutoff)),
-                glm::cos(glm::radians(light.outerCutoff))
+                glm::cos(glm::radians(light.outerCutoff)),
+                // Directional lights reach everything, like their cascades do
+                light.orthographic ? std::numeric_limits<float>::infinity()
+                : light.range > 0.0f
+                    ? std::min(light.range, maxRadius)
+                    : std::min(10.0f * light.intensity * std::max({ light.color.r, light.color.g, light.color.b }) / influenceThreshold, maxRadius)
             }
         );
     }
@@ -533,214 +729,905 @@ void Scene::SetupLights()
 void Scene::SetupShadows()
 {
     shadows.clear();
+    shadowLights.clear();
+    shadowRequests.clear();
 
-    // Fill shadowSamplers with an empty texture
-    std::ranges::fill(
-        shadowSamplers,
-        AssetManager::Get().Load<TextureAsset>("empty", true)->texture
-    );
+    UpdateShadowCasters();
 
-    const auto lightsView = registry.view<LightComponent, TransformComponent>(entt::exclude<PrefabComponent>);
+    auto& atlas = ShadowAtlas::Get();
 
-    for(const auto entity : lightsView)
+    atlas.SetOwner(this);
+
+    for(size_t i = 0; i < lights.size(); i++)
     {
-        auto [light, transform] =
-            lightsView.get<LightComponent, TransformComponent>(entity);
+        const auto& light = registry.get<LightComponent>(lightEntities[i]);
+
+        if(!light.shadowMap)
+            continue;
 
-        if(light.shadowMap)
+        // Directional lights follow the camera, without one they fall back to a single orthographic map
+        if(light.orthographic && camera)
         {
-            auto localTransform = transform;
+            SetupCascades(i, light);
+            continue;
+        }
 
-            if(registry.all_of<HierarchyComponent>(entity))
-                localTransform.SetTransform(GetWorldTransform(entity));
+        const auto& position = lights[i].position;
+        const auto view = glm::lookAt(position, position + lights[i].direction, glm::vec3(0.0f, 1.0f, 0.0f));
 
-            auto delta = glm::quat(glm::radians(localTransform.rotation)) * glm::vec3(0.0f, 0.0f, -1.0f);
+        // Directional lights cover the whole scene, they always go first.
+        // Other lights get less important as the camera leaves their radius
+        float importance = 2.0f;
 
-            shadows.push_back(
-                {
-                    light.projection *
-                    glm::lookAt(localTransform.position, localTransform.position + delta, glm::vec3(0.0f, 1.0f, 0.0f)),
-                    light.bias
-                }
-            );
+        if(!light.orthographic)
+            importance = lights[i].radius / (lights[i].radius + glm::distance(position, cameraPosition));
 
-            shadowSamplers[shadows.size() - 1] = light.depth;
-        }
-    }
-}
+        const auto maxSize = std::min(light.resolution.width, atlas.GetConfig().maxTileSize);
+        const auto key = GetShadowKey(lightEntities[i], 0);
 
-void Scene::RenderMeshes()
-{
-    bool empty = true;
+        shadowRequests.push_back(
+            {
+                .key = key,
+                .size = static_cast<uint32_t>(static_cast<float>(maxSize) * std::min(importance, 1.0f)),
+                .importance = importance
+            }
+        );
 
-    const auto view =
-        registry.view<
-            TransformComponent,
-            MeshComponent,
-            MeshRendererComponent,
-            PipelineComponent
-        >(entt::exclude<PrefabComponent>);
+        shadowLights.push_back(
+            {
+                .entity = lightEntities[i],
+                .lightIndex = i,
+                .key = key,
+                .view = view,
+                .projection = light.projection,
+                .lightSpaceMatrix = light.projection * view,
+                .splitDepth = std::numeric_limits<float>::max(),
+                .bias = light.bias
+            }
+        );
+    }
 
-    for(const auto entity : view)
+    atlas.Allocate(shadowRequests);
+
+    for(auto& shadowLight : shadowLights)
     {
-        auto [transform, mesh, meshRenderer, pipeline] =
-                view.get<TransformComponent, MeshComponent, MeshRendererComponent, PipelineComponent>(entity);
+        auto* tile = atlas.GetTile(shadowLight.key);
 
-        if(!mesh.drawable)
+        // Out of budget
+        if(!tile)
+            continue;
+
+        auto& firstShadow = lights[shadowLight.lightIndex].shadow;
+
+        // The far cascades are the first to go out of budget, the ones that are left must be consecutive
+        if(shadowLight.cascade > 0 && (firstShadow < 0 || shadows[firstShadow].cascadeCount != shadowLight.cascade))
             continue;
 
-        Renderer::Get().GetMatrices()->PushMatrix();
-        Renderer::Get().GetMatrices()->GetModel() = GetWorldTransform(entity);
+        // Snapped to the texels of the tile, so it can only be done after the allocation
+        if(shadowLight.cascade >= 0)
+            FitCascade(shadowLight, lights[shadowLight.lightIndex].direction, tile->size);
+
+        // Static lights keep their tile until something moves in front of them
+        if(tile->lightSpaceMatrix != shadowLight.lightSpaceMatrix)
+            tile->dirty = true;
+        else if(!tile->dirty)
+            tile->dirty = std::ranges::any_of(changedCasterBounds, [&](const auto& bounds)
+            {
+                return IsInFrustum(bounds, shadowLight.lightSpaceMatrix);
+            });
 
-        MeshRenderPass(mesh, meshRenderer, pipeline, DeferredRenderer::Get().GetPrimaryRenderTarget());
+        tile->lightSpaceMatrix = shadowLight.lightSpaceMatrix;
 
-        Renderer::Get().GetMatrices()->PopMatrix();
+        shadowLight.shadow = static_cast<int>(shadows.size());
 
-        empty = false;
-    }
+        if(shadowLight.cascade > 0)
+            shadows[firstShadow].cascadeCount++;
+        else
+            firstShadow = shadowLight.shadow;
 
-    if(empty)
-        Renderer::Get().ClearRenderTarget(DeferredRenderer::Get().GetPrimaryRenderTarget());
+        shadows.push_back(
+            {
+                shadowLight.lightSpaceMatrix,
+                atlas.GetRect(*tile),
+                shadowLight.bias,
+                shadowLight.splitDepth,
+                1
+            }
+        );
+    }
 }
 
-void Scene::RenderToShadowMap()
+void Scene::SetupCascades(const size_t lightIndex, const LightComponent& light)
 {
-    const auto meshesView =
-        registry.view<
-            TransformComponent,
-            MeshComponent
-        >(entt::exclude<PrefabComponent>);
+    const auto near = camera->GetNear();
+    const auto far = std::max(std::min(camera->GetFar(), maxShadowDistance), near * 1.001f);
 
-    const auto lightsView = registry.view<LightComponent, TransformComponent>(entt::exclude<PrefabComponent>);
+    const auto tanHalfFov = std::tan(glm::radians(camera->GetFov()) * 0.5f);
+    const auto aspect = camera->GetAspect();
+    const auto inverseView = glm::inverse(camera->GetViewMatrix());
 
-    Renderer::Get().Begin();
+    const auto maxSize = std::min(light.resolution.width, ShadowAtlas::Get().GetConfig().maxTileSize);
 
-    for(const auto light : lightsView)
+    float splitNear = near;
+
+    for(uint32_t cascade = 0; cascade < cascadeCount; cascade++)
     {
-        auto [lightComponent, lightTransform] =
-                lightsView.get<LightComponent, TransformComponent>(light);
+        // Blend of the uniform and the logarithmic splits
+        const float ratio = static_cast<float>(cascade + 1) / cascadeCount;
+        const float splitFar = glm::mix(near + (far - near) * ratio, near * std::pow(far / near, ratio), cascadeSplitLambda);
+
+        glm::vec3 corners[8];
+        glm::vec3 center{};
 
-        if(lightComponent.shadowMap && lightComponent.renderTarget)
+        for(int i = 0; i < 8; i++)
         {
-            Renderer::Get().ClearRenderTarget(lightComponent.renderTarget, false);
+            const float depth = i & 4 ? splitFar : splitNear;
 
-            auto delta = glm::quat(glm::radians(lightTransform.rotation)) * glm::vec3(0.0f, 0.0f, -1.0f);
+            const glm::vec4 corner =
+            {
+                (i & 1 ? 1.0f : -1.0f) * depth * tanHalfFov * aspect,
+                (i & 2 ? 1.0f : -1.0f) * depth * tanHalfFov,
+                -depth,
+                1.0f
+            };
+
+            corners[i] = inverseView * corner;
+            center += corners[i] / 8.0f;
+        }
 
-            Renderer::Get().GetMatrices()->GetView() = glm::lookAt(lightTransform.position, lightTransform.position + delta, glm::vec3(0.0f, 1.0f, 0.0f));
-            Renderer::Get().GetMatrices()->GetProjection() = lightComponent.projection;
+        // A sphere doesn't change its size when the camera turns.
+        // Rounded up so floating point errors don't make it flicker
+        float radius = 0.0f;
 
-            for(const auto mesh : meshesView)
-            {
-                auto [transform, meshComp] =
-                        meshesView.get<TransformComponent, MeshComponent>(mesh);
+        for(const auto& corner : corners)
+            radius = std::max(radius, glm::distance(center, corner));
 
-                Renderer::Get().GetMatrices()->PushMatrix();
-                Renderer::Get().GetMatrices()->GetModel() = GetWorldTransform(mesh);
+        radius = std::ceil(radius * 16.0f) / 16.0f;
 
-                ShadowRenderPass(lightComponent, meshComp);
+        const auto key = GetShadowKey(lightEntities[lightIndex], cascade);
 
-                Renderer::Get().GetMatrices()->PopMatrix();
+        // Above every other light, the nearest cascades are the most important.
+        // The far ones cover what's already small on the screen, so they get half the resolution
+        shadowRequests.push_back(
+            {
+                .key = key,
+                .size = cascade < 2 ? maxSize : maxSize / 2,
+                .importance = 3.0f - static_cast<float>(cascade) * 0.1f
             }
-        }
-    }
+        );
 
-    Renderer::Get().End();
+        shadowLights.push_back(
+            {
+                .entity = lightEntities[lightIndex],
+                .lightIndex = lightIndex,
+                .key = key,
+                .cascade = static_cast<int>(cascade),
+                .center = center,
+                .radius = radius,
+                .splitDepth = splitFar,
+                .bias = light.bias
+            }
+        );
 
-    Renderer::Get().Submit();
+        splitNear = splitFar;
+    }
 }
 
-void Scene::RenderSky(LLGL::RenderTarget* renderTarget)
+void Scene::FitCascade(ShadowLight& shadowLight, const glm::vec3& direction, const uint32_t tileSize)
 {
-    const auto hdriSkyView = registry.view<MeshComponent, HDRISkyComponent>(entt::exclude<PrefabComponent>);
+    const auto up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
 
-    if(hdriSkyView.begin() != hdriSkyView.end())
-    {
-        auto [mesh, sky] =
-            hdriSkyView.get<MeshComponent, HDRISkyComponent>(*hdriSkyView.begin());
+    // The rotation is the only thing that goes into the view matrix, the position is in the projection
+    shadowLight.view = glm::lookAt(glm::vec3(0.0f), direction, up);
 
-        HDRISkyRenderPass(mesh, sky, renderTarget);
+    glm::vec3 center = shadowLight.view * glm::vec4(shadowLight.center, 1.0f);
 
-        return;
-    }
+    // Move the cascade by whole texels, otherwise the edges of the shadows shimmer when the camera moves
+    const float texelSize = 2.0f * shadowLight.radius / static_cast<float>(tileSize);
 
-    const auto proceduralSkyView = registry.view<MeshComponent, ProceduralSkyComponent>(entt::exclude<PrefabComponent>);
+    center.x = std::floor(center.x / texelSize) * texelSize;
+    center.y = std::floor(center.y / texelSize) * texelSize;
 
-    if(proceduralSkyView.begin() != proceduralSkyView.end())
-    {
-        auto [mesh, sky] = proceduralSkyView.get<MeshComponent, ProceduralSkyComponent>(*proceduralSkyView.begin());
+    const auto radius = shadowLight.radius;
 
-        ProceduralSkyRenderPass(mesh, sky, renderTarget);
-    }
+    shadowLight.projection = glm::ortho(
+        center.x - radius, center.x + radius,
+        center.y - radius, center.y + radius,
+        -center.z - radius - casterExtrusion, -center.z + radius
+    );
+
+    shadowLight.lightSpaceMatrix = shadowLight.projection * shadowLight.view;
 }
 
-void Scene::MeshRenderPass(
-    const MeshComponent& mesh,
-    const MeshRendererComponent& meshRenderer,
-    const PipelineComponent& pipeline,
-    LLGL::RenderTarget* renderTarget
-)
+void Scene::UpdateShadowCasters()
 {
-    if(!mesh.model)
-        return;
+    shadowFrame++;
 
-    for(size_t i = 0; i < mesh.model->meshes.size(); i++)
+    changedCasterBounds.clear();
+
+    const auto meshesView = registry.view<TransformComponent, MeshComponent>(entt::exclude<PrefabComponent>);
+
+    for(const auto entity : meshesView)
     {
-        auto material = AssetManager::Get().Load<MaterialAsset>("default", true);
+        const auto& mesh = meshesView.get<MeshComponent>(entity);
 
-        if(meshRenderer.materials.size() > i)
-            material = meshRenderer.materials[i];
+        if(!mesh.model || mesh.model->meshes.empty())
+            continue;
 
-        Renderer::Get().RenderPass(
-            [&](auto commandBuffer)
-            {
-                mesh.model->meshes[i]->BindBuffers(commandBuffer);
-            },
-            {
-                { 0, Renderer::Get().GetMatricesBuffer() },
-                { 1, material->albedo.texture->texture },
-                { 2, material->normal.texture->texture },
-                { 3, material->metallic.texture->texture },
-                { 4, material->roughness.texture->texture },
-                { 5, material->ao.texture->texture },
-                { 6, material->emission.texture->texture },
-                { 7, material->albedo.texture->sampler }
-            },
-            [&](auto commandBuffer)
-            {
-                material->SetUniforms(commandBuffer);
+        const auto worldTransform = GetWorldTransform(entity);
 
-                float time = global::appTimer.GetElapsedSeconds();
+        const auto animator = registry.try_get<AnimatorComponent>(entity);
+        const auto animated = animator && mesh.model->animation;
 
-                commandBuffer->SetUniforms(13, &time, sizeof(time));
+        // Also catches the meshes of a model that finished loading asynchronously
+        const auto bounds =
+            animated ? GetAnimatedBounds(*mesh.model, worldTransform) : GetWorldBounds(*mesh.model, worldTransform);
 
-                mesh.model->meshes[i]->Draw(commandBuffer);
-            },
-            pipeline.pipeline,
-            DeferredRenderer::Get().GetPrimaryRenderTarget()
-        );
+        auto [it, inserted] = shadowCasters.try_emplace(entity);
+        auto& caster = it->second;
+
+        if(inserted
+           || caster.model != mesh.model.get()
+           || caster.worldTransform != worldTransform
+           || caster.bounds.min != bounds.min
+           || caster.bounds.max != bounds.max)
+        {
+            if(!inserted)
+                changedCasterBounds.push_back(caster.bounds);
+
+            changedCasterBounds.push_back(bounds);
+
+            caster.worldTransform = worldTransform;
+            caster.bounds = bounds;
+            caster.model = mesh.model.get();
+        }
+        // The pose changes even if the entity stays where it is
+        else if(animated && animator->playing && animationDeltaTime > 0.0f)
+            changedCasterBounds.push_back(bounds);
+
+        caster.animator = animated ? animator : nullptr;
+        caster.frame = shadowFrame;
+
+        // Picked with the current camera, but a cached tile keeps whatever it was rendered with
+        const auto meshRenderer = registry.try_get<MeshRendererComponent>(entity);
+        const auto threshold = meshRenderer ? meshRenderer->lodThreshold * meshRenderer->shadowLodBias : 0.0f;
+
+        caster.lods.resize(mesh.model->meshes.size(), 0);
+
+        for(size_t i = 0; i < mesh.model->meshes.size(); i++)
+            caster.lods[i] = SelectLod(*mesh.model->meshes[i], worldTransform, threshold, caster.lods[i]);
+    }
+
+    // Removed entities and the ones that lost their mesh
+    std::erase_if(shadowCasters, [&](const auto& pair)
+    {
+        if(pair.second.frame == shadowFrame)
+            return false;
+
+        changedCasterBounds.push_back(pair.second.bounds);
+
+        return true;
+    });
+}
+
+void Scene::UpdateAnimations()
+{
+    const auto view = registry.view<TransformComponent, MeshComponent, AnimatorComponent>(entt::exclude<PrefabComponent>);
+
+    std::vector<AnimationManager::Instance> instances;
+
+    const auto viewProjection = camera ? camera->GetProjectionMatrix() * camera->GetViewMatrix() : glm::mat4(1.0f);
+
+    for(const auto entity : view)
+    {
+        auto [mesh, animator] = view.get<MeshComponent, AnimatorComponent>(entity);
+
+        if(!mesh.model || !mesh.model->animation || mesh.model->meshes.empty())
+            continue;
+
+        const auto bounds = GetAnimatedBounds(*mesh.model, GetWorldTransform(entity));
+
+        // A character behind the camera can still cast a shadow into the view
+        const auto visible = !camera || IsInFrustum(bounds, viewProjection)
+            || std::ranges::any_of(shadowLights, [&](const ShadowLight& shadowLight)
+            {
+                return shadowLight.shadow >= 0 && IsInFrustum(bounds, shadowLight.lightSpaceMatrix);
+            });
+
+        instances.push_back({ &animator, mesh.model->animation.get(), visible });
+    }
+
+    AnimationManager::Get().Update(instances, animationDeltaTime);
+
+    animationDeltaTime = 0.0f;
+}
+
+void Scene::UpdateStaticBatches()
+{
+    staticFrame++;
+
+    const auto view =
+        registry.view<
+            TransformComponent,
+            MeshComponent,
+            MeshRendererComponent,
+            PipelineComponent
+        >(entt::exclude<PrefabComponent, RigidBodyComponent, ScriptComponent, AnimatorComponent>);
+
+    for(const auto entity : view)
+    {
+        const auto [transform, mesh, meshRenderer, pipeline] =
+            view.get<TransformComponent, MeshComponent, MeshRendererComponent, PipelineComponent>(entity);
+
+        if(!mesh.drawable || !mesh.model || mesh.model->meshes.empty() || !pipeline.pipeline)
+            continue;
+
+        const auto worldTransform = GetWorldTransform(entity);
+        const auto signature = GetStaticSignature(mesh, meshRenderer, pipeline, worldTransform);
+
+        auto [it, inserted] = staticEntities.try_emplace(entity);
+        auto& staticEntity = it->second;
+
+        if(inserted || staticEntity.signature != signature)
+        {
+            if(!inserted)
+                RemoveFromStaticBatches(entity, staticEntity);
+
+            staticEntity.signature = signature;
+            staticEntity.changedFrame = staticFrame;
+        }
+
+        staticEntity.frame = staticFrame;
+
+        // The new ones (e.g. the whole scene after loading) don't wait
+        if(staticEntity.batches.empty() && (inserted || staticFrame - staticEntity.changedFrame >= staticBatchDelay))
+            AddToStaticBatches(entity, staticEntity, worldTransform);
+    }
+
+    // Removed entities and the ones that got a rigid body, a script or were hidden
+    std::erase_if(staticEntities, [&](auto& pair)
+    {
+        if(pair.second.frame == staticFrame)
+            return false;
+
+        RemoveFromStaticBatches(pair.first, pair.second);
+
+        return true;
+    });
+
+    std::erase_if(staticBatches, [&](auto& pair)
+    {
+        auto& batch = pair.second;
+
+        if(!batch.dirty)
+            return false;
+
+        RebuildStaticBatch(batch);
+
+        return !batch.mesh;
+    });
+}
+
+uint64_t Scene::GetStaticSignature(
+    const MeshComponent& mesh,
+    const MeshRendererComponent& meshRenderer,
+    const PipelineComponent& pipeline,
+    const glm::mat4& worldTransform
+)
+{
+    Hash hash;
+
+    hash.Add(&worldTransform, sizeof(worldTransform));
+
+    hash.Add(reinterpret_cast<uintptr_t>(pipeline.vertexShader.get()));
+    hash.Add(reinterpret_cast<uintptr_t>(pipeline.fragmentShader.get()));
+
+    hash.Add(meshRenderer.lodThreshold);
+
+    // Also catches the meshes of a model that finished loading asynchronously
+    for(size_t i = 0; i < mesh.model->meshes.size(); i++)
+    {
+        hash.Add(reinterpret_cast<uintptr_t>(mesh.model->meshes[i].get()));
+        hash.Add(reinterpret_cast<uintptr_t>(GetMaterial(meshRenderer, i).get()));
+    }
+
+    return hash.Get();
+}
+
+void Scene::AddToStaticBatches(const entt::entity entity, StaticEntity& staticEntity, const glm::mat4& worldTransform)
+{
+    const auto& mesh = registry.get<MeshComponent>(entity);
+    const auto& meshRenderer = registry.get<MeshRendererComponent>(entity);
+    const auto& pipeline = registry.get<PipelineComponent>(entity);
+
+    for(size_t i = 0; i < mesh.model->meshes.size(); i++)
+    {
+        const auto material = GetMaterial(meshRenderer, i);
+
+        // A submesh goes to the cell its center is in, so a batch may stick out of its cell a bit
+        const auto bounds = mesh.model->meshes[i]->GetBounds();
+        const auto center = glm::vec3(worldTransform * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.0f));
+        const auto cell = glm::ivec3(glm::floor(center / staticBatchCellSize));
+
+        const StaticBatchKey key =
+        {
+            pipeline.vertexShader.get(),
+            pipeline.fragmentShader.get(),
+            material.get(),
+            { cell.x, cell.y, cell.z }
+        };
+
+        auto [it, inserted] = staticBatches.try_emplace(key);
+        auto& batch = it->second;
+
+        if(inserted)
+        {
+            batch.material = material;
+            batch.pipeline = pipeline;
+        }
+
+        batch.members.emplace_back(entity, i);
+        batch.dirty = true;
+
+        staticEntity.batches.push_back(key);
+    }
+}
+
+void Scene::RemoveFromStaticBatches(const entt::entity entity, StaticEntity& staticEntity)
+{
+    for(const auto& key : staticEntity.batches)
+    {
+        const auto it = staticBatches.find(key);
+
+        if(it == staticBatches.end())
+            continue;
+
+        std::erase_if(it->second.members, [&](const auto& member) { return member.first == entity; });
+
+        it->second.dirty = true;
+    }
+
+    staticEntity.batches.clear();
+}
+
+void Scene::RebuildStaticBatch(StaticBatch& batch)
+{
+    batch.dirty = false;
+
+    if(batch.mesh)
+    {
+        batch.mesh->ReleaseBuffers();
+        batch.mesh.reset();
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    size_t lodCount = 1;
+
+    for(const auto& [entity, submesh] : batch.members)
+        lodCount = std::max(lodCount, registry.get<MeshComponent>(entity).model->meshes[submesh]->GetLodCount());
+
+    // Index 0 is unused, the full detail goes to indices
+    std::vector<Mesh::Lod> lods(lodCount);
+
+    Mesh::Bounds bounds
+    {
+        glm::vec3(std::numeric_limits<float>::max()),
+        glm::vec3(std::numeric_limits<float>::lowest())
+    };
+
+    batch.lodThreshold = std::numeric_limits<float>::max();
+
+    // The members haven't changed since they joined, otherwise they would have left the batch first
+    for(const auto& [entity, submesh] : batch.members)
+    {
+        const auto& mesh = *registry.get<MeshComponent>(entity).model->meshes[submesh];
+
+        batch.lodThreshold = std::min(batch.lodThreshold, registry.get<MeshRendererComponent>(entity).lodThreshold);
+
+        const auto worldTransform = GetWorldTransform(entity);
+        // The same as the vertex shader does, so a batched mesh looks like the one drawn on its own.
+        // The tangents only depend on the world space normals, they match as well
+        const auto normalMatrix = glm::mat3(worldTransform);
+
+        const auto first = static_cast<uint32_t>(vertices.size());
+
+        for(auto vertex : mesh.GetVertices())
+        {
+            vertex.position = glm::vec3(worldTransform * glm::vec4(vertex.position, 1.0f));
+            vertex.normal = glm::normalize(normalMatrix * vertex.normal);
+
+            bounds.min = glm::min(bounds.min, vertex.position);
+            bounds.max = glm::max(bounds.max, vertex.position);
+
+            vertices.push_back(vertex);
+        }
+
+        for(const auto index : mesh.GetIndices())
+            indices.push_back(first + index);
+
+        const auto localBounds = mesh.GetBounds();
+        const auto scale = std::max({
+            glm::length(glm::vec3(worldTransform[0])),
+            glm::length(glm::vec3(worldTransform[1])),
+            glm::length(glm::vec3(worldTransform[2]))
+        });
+        const auto size = glm::length(localBounds.max - localBounds.min) * scale;
+
+        for(size_t lod = 1; lod < lodCount; lod++)
+        {
+            const auto memberLod = std::min(lod, mesh.GetLodCount() - 1);
+
+            for(const auto index : mesh.GetIndices(memberLod))
+                lods[lod].indices.push_back(first + index);
+
+            // In world units for now, relative to the batch below
+            lods[lod].error = std::max(lods[lod].error, mesh.GetLodError(memberLod) * size);
+        }
+    }
+
+    batch.lod = 0;
+
+    if(indices.empty())
+        return;
+
+    const auto size = glm::length(bounds.max - bounds.min);
+
+    for(auto& lod : lods)
+        lod.error = size > 0.0f ? lod.error / size : 0.0f;
+
+    lods.erase(lods.begin());
+
+    batch.mesh = std::make_shared<Mesh>(vertices, indices, false, true);
+    batch.mesh->SetLods(std::move(lods));
+    batch.mesh->SetupBuffers();
+}
+
+void Scene::RenderMeshes()
+{
+    const auto view =
+        registry.view<
+            TransformComponent,
+            MeshComponent,
+            MeshRendererComponent,
+            PipelineComponent
+        >(entt::exclude<PrefabComponent>);
+
+    // Gathered here, the workers only read the components and never touch the registry
+    struct MeshDraw
+    {
+        glm::mat4 worldTransform;
+
+        const MeshComponent* mesh;
+        const MeshRendererComponent* meshRenderer;
+        const PipelineComponent* pipeline;
+
+        const AnimatorComponent* animator;
+    };
+
+    std::vector<MeshDraw> draws;
+
+    for(const auto entity : view)
+    {
+        auto [transform, mesh, meshRenderer, pipeline] =
+                view.get<TransformComponent, MeshComponent, MeshRendererComponent, PipelineComponent>(entity);
+
+        if(!mesh.drawable)
+            continue;
+
+        // Drawn with its static batches
+        if(const auto it = staticEntities.find(entity); it != staticEntities.end() && !it->second.batches.empty())
+            continue;
+
+        const auto worldTransform = GetWorldTransform(entity);
+
+        if(mesh.model)
+            meshRenderer.lods.resize(mesh.model->meshes.size(), 0);
+
+        auto animator = registry.try_get<AnimatorComponent>(entity);
+
+        if(!mesh.model || !mesh.model->animation)
+            animator = nullptr;
+
+        // Variants are compiled and the LODs are picked here, the workers only look them up
+        for(size_t i = 0; mesh.model && i < mesh.model->meshes.size(); i++)
+        {
+            const auto skinned = IsSkinned(*mesh.model->meshes[i], animator);
+
+            pipeline.SetupVariant(GetMaterial(meshRenderer, i)->GetVariant() | (skinned ? PipelineComponent::skinnedVariant : 0));
+
+            meshRenderer.lods[i] = SelectLod(*mesh.model->meshes[i], worldTransform, meshRenderer.lodThreshold, meshRenderer.lods[i]);
+        }
+
+        draws.push_back({ worldTransform, &mesh, &meshRenderer, &pipeline, animator });
     }
+
+    std::vector<const StaticBatch*> batches;
+
+    const auto viewProjection = camera ? camera->GetProjectionMatrix() * camera->GetViewMatrix() : glm::mat4(1.0f);
+
+    for(auto& batch : staticBatches | std::views::values)
+    {
+        if(!batch.mesh || (camera && !IsInFrustum(batch.mesh->GetBounds(), viewProjection)))
+            continue;
+
+        batch.pipeline.SetupVariant(batch.material->GetVariant());
+
+        batch.lod = SelectLod(*batch.mesh, glm::mat4(1.0f), batch.lodThreshold, batch.lod);
+
+        batches.push_back(&batch);
+    }
+
+    if(draws.empty() && batches.empty())
+    {
+        Renderer::Get().ClearRenderTarget(DeferredRenderer::Get().GetPrimaryRenderTarget());
+        return;
+    }
+
+    Renderer::Get().RecordParallel(draws.size() + batches.size(), [&](const size_t begin, const size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            Renderer::Get().GetMatrices()->PushMatrix();
+
+            if(i < draws.size())
+            {
+                Renderer::Get().GetMatrices()->GetModel() = draws[i].worldTransform;
+
+                MeshRenderPass(
+                    *draws[i].mesh,
+                    *draws[i].meshRenderer,
+                    *draws[i].pipeline,
+                    draws[i].animator,
+                    DeferredRenderer::Get().GetPrimaryRenderTarget()
+                );
+            }
+            else
+            {
+                const auto& batch = *batches[i - draws.size()];
+
+                // Already in world space
+                Renderer::Get().GetMatrices()->GetModel() = glm::mat4(1.0f);
+
+                SubmeshRenderPass(*batch.mesh, batch.lod, batch.material, batch.pipeline, nullptr, DeferredRenderer::Get().GetPrimaryRenderTarget());
+            }
+
+            Renderer::Get().GetMatrices()->PopMatrix();
+        }
+    });
+}
+
+void Scene::RenderToShadowMap()
+{
+    auto& atlas = ShadowAtlas::Get();
+
+    std::vector<std::pair<const ShadowLight*, ShadowAtlas::Tile*>> dirty;
+
+    for(const auto& shadowLight : shadowLights)
+    {
+        auto* tile = atlas.GetTile(shadowLight.key);
+
+        if(shadowLight.shadow >= 0 && tile && tile->dirty)
+            dirty.emplace_back(&shadowLight, tile);
+    }
+
+    // Nothing is submitted at all if every tile is up to date
+    if(dirty.empty())
+        return;
+
+    Renderer::Get().Begin(false);
+
+    // Every tile is a separate job, they don't overlap so the order doesn't matter
+    Renderer::Get().RecordParallel(dirty.size(), [&](const size_t begin, const size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            const auto& [shadowLight, tile] = dirty[i];
+
+            Renderer::Get().RenderPass(
+                [](auto) {}, {},
+                [&](auto commandBuffer)
+                {
+                    ShadowAtlas::SetTileViewport(commandBuffer, *tile);
+
+                    commandBuffer->Clear(LLGL::ClearFlags::Depth);
+                },
+                atlas.GetPipeline(),
+                atlas.GetRenderTarget()
+            );
+
+            Renderer::Get().GetMatrices()->GetView() = shadowLight->view;
+            Renderer::Get().GetMatrices()->GetProjection() = shadowLight->projection;
+
+            for(const auto& caster : shadowCasters | std::views::values)
+            {
+                if(!IsInFrustum(caster.bounds, shadowLight->lightSpaceMatrix))
+                    continue;
+
+                Renderer::Get().GetMatrices()->PushMatrix();
+                Renderer::Get().GetMatrices()->GetModel() = caster.worldTransform;
+
+                ShadowRenderPass(*caster.model, caster.lods, caster.animator, *tile);
+
+                Renderer::Get().GetMatrices()->PopMatrix();
+            }
+        }
+    }, 1);
+
+    for(const auto& [shadowLight, tile] : dirty)
+        tile->dirty = false;
+
+    Renderer::Get().End();
+
+    Renderer::Get().Submit();
+
+    // Restore the camera matrices for the passes that follow
+    if(camera)
+    {
+        Renderer::Get().GetMatrices()->GetView() = camera->GetViewMatrix();
+        Renderer::Get().GetMatrices()->GetProjection() = camera->GetProjectionMatrix();
+    }
+}
+
+void Scene::RenderSky(LLGL::RenderTarget* renderTarget)
+{
+    const auto hdriSkyView = registry.view<MeshComponent, HDRISkyComponent>(entt::exclude<PrefabComponent>);
+
+    if(hdriSkyView.begin() != hdriSkyView.end())
+    {
+        auto [mesh, sky] =
+            hdriSkyView.get<MeshComponent, HDRISkyComponent>(*hdriSkyView.begin());
+
+        HDRISkyRenderPass(mesh, sky, renderTarget);
+
+        return;
+    }
+
+    const auto proceduralSkyView = registry.view<MeshComponent, ProceduralSkyComponent>(entt::exclude<PrefabComponent>);
+
+    if(proceduralSkyView.begin() != proceduralSkyView.end())
+    {
+        auto [mesh, sky] = proceduralSkyView.get<MeshComponent, ProceduralSkyComponent>(*proceduralSkyView.begin());
+
+        ProceduralSkyRenderPass(mesh, sky, renderTarget);
+    }
+}
+
+void Scene::MeshRenderPass(
+    const MeshComponent& mesh,
+    const MeshRendererComponent& meshRenderer,
+    const PipelineComponent& pipeline,
+    const AnimatorComponent* animator,
+    LLGL::RenderTarget* renderTarget
+)
+{
+    if(!mesh.model)
+        return;
+
+    for(size_t i = 0; i < mesh.model->meshes.size(); i++)
+        SubmeshRenderPass(
+            *mesh.model->meshes[i],
+            i < meshRenderer.lods.size() ? meshRenderer.lods[i] : 0,
+            GetMaterial(meshRenderer, i),
+            pipeline,
+            animator,
+            renderTarget
+        );
+}
+
+void Scene::SubmeshRenderPass(
+    const Mesh& mesh,
+    const size_t lod,
+    const MaterialAssetPtr& material,
+    const PipelineComponent& pipeline,
+    const AnimatorComponent* animator,
+    LLGL::RenderTarget* renderTarget
+)
+{
+    const auto variant = pipeline.GetVariant(material->GetVariant() | (IsSkinned(mesh, animator) ? PipelineComponent::skinnedVariant : 0));
+    // Not if the vertex shader doesn't support skinning
+    const auto skinned = variant.skinned;
+
+    std::unordered_map<uint32_t, LLGL::Resource*> resources =
+    {
+        { 0, Renderer::Get().GetMatricesBuffer() },
+        { 1, material->albedo.texture->texture },
+        { 2, material->normal.texture->texture },
+        { 3, material->metallic.texture->texture },
+        { 4, material->roughness.texture->texture },
+        { 5, material->ao.texture->texture },
+        { 6, material->emission.texture->texture },
+        { 7, material->albedo.texture->sampler }
+    };
+
+    // Uploaded once per frame by the animation manager, the draw only points at its palette
+    if(skinned)
+        resources[8] = AnimationManager::Get().GetPaletteBuffer();
+
+    Renderer::Get().RenderPass(
+        [&](auto commandBuffer)
+        {
+            mesh.BindBuffers(commandBuffer);
+        },
+        resources,
+        [&](auto commandBuffer)
+        {
+            material->SetUniforms(commandBuffer, !variant.keywords);
+
+            float time = global::appTimer.GetElapsedSeconds();
+
+            commandBuffer->SetUniforms(13, &time, sizeof(time));
+
+            if(skinned)
+            {
+                const auto paletteOffset = static_cast<int>(animator->paletteOffset);
+
+                commandBuffer->SetUniforms(14, &paletteOffset, sizeof(paletteOffset));
+            }
+
+            mesh.Draw(commandBuffer, lod);
+        },
+        variant.pipeline,
+        renderTarget
+    );
+}
+
+MaterialAssetPtr Scene::GetMaterial(const MeshRendererComponent& meshRenderer, const size_t index)
+{
+    if(meshRenderer.materials.size() > index)
+        return meshRenderer.materials[index];
+
+    return AssetManager::Get().Load<MaterialAsset>("default", true);
 }
 
-void Scene::ShadowRenderPass(const LightComponent& light, const MeshComponent& mesh)
+void Scene::ShadowRenderPass(
+    const ModelAsset& model,
+    const std::vector<uint32_t>& lods,
+    const AnimatorComponent* animator,
+    const ShadowAtlas::Tile& tile
+)
 {
-    for(auto& i : mesh.model->meshes)
+    for(size_t i = 0; i < model.meshes.size(); i++)
     {
+        const auto& mesh = model.meshes[i];
+        const auto skinned = IsSkinned(*mesh, animator);
+
+        std::unordered_map<uint32_t, LLGL::Resource*> resources = { { 0, Renderer::Get().GetMatricesBuffer() } };
+
+        if(skinned)
+            resources[1] = AnimationManager::Get().GetPaletteBuffer();
+
         Renderer::Get().RenderPass(
             [&](auto commandBuffer)
             {
-                i->BindBuffers(commandBuffer);
+                mesh->BindBuffers(commandBuffer, true, true);
             },
-            { { 0, Renderer::Get().GetMatricesBuffer() } },
+            resources,
             [&](auto commandBuffer)
             {
-                i->Draw(commandBuffer);
+                ShadowAtlas::SetTileViewport(commandBuffer, tile);
+
+                if(skinned)
+                {
+                    const auto paletteOffset = static_cast<int>(animator->paletteOffset);
+
+                    commandBuffer->SetUniforms(0, &paletteOffset, sizeof(paletteOffset));
+                }
+
+                mesh->Draw(commandBuffer, i < lods.size() ? lods[i] : 0);
             },
-            light.shadowMapPipeline,
-            light.renderTarget
+            skinned ? ShadowAtlas::Get().GetSkinnedPipeline() : ShadowAtlas::Get().GetPipeline(),
+            ShadowAtlas::Get().GetRenderTarget()
         );
     }
 }
 
+bool Scene::IsSkinned(const Mesh& mesh, const AnimatorComponent* animator)
+{
+    return animator && animator->paletteOffset != AnimatorComponent::noPalette && mesh.IsSkinned();
+}
+
 void Scene::ProceduralSkyRenderPass(
     const MeshComponent& mesh,
     const ProceduralSkyComponent& sky,
@@ -791,23 +1678,28 @@ void Scene::HDRISkyRenderPass(
     );
 }
 
-void Scene::RenderResult(LLGL::RenderTarget* renderTarget)
+void Scene::RenderResult(LLGL::RenderTarget* renderTarget, LLGL::Texture* occlusion)
 {
     auto uniforms = [&](auto commandBuffer)
     {
-        auto numLights = lights.size();
-        auto numShadows = shadows.size();
-
-        commandBuffer->SetUniforms(0, &numLights, sizeof(numLights));
-        commandBuffer->SetUniforms(1, &numShadows, sizeof(numShadows));
-        commandBuffer->SetUniforms(2, &cameraPosition, sizeof(cameraPosition));
-        commandBuffer->SetUniforms(3, &Renderer::Get().GetMatrices()->GetView(), sizeof(glm::mat4));
+        const float sliceScale = LightClusters::Get().GetSliceScale();
+        const float sliceBias = LightClusters::Get().GetSliceBias();
+
+        const auto& view = Renderer::Get().GetMatrices()->GetView();
+        const auto& projection = Renderer::Get().GetMatrices()->GetProjection();
+
+        const auto inverseView = glm::inverse(view);
+        const auto inverseProjection = glm::inverse(projection);
+
+        commandBuffer->SetUniforms(0, &cameraPosition, sizeof(cameraPosition));
+        commandBuffer->SetUniforms(1, &view, sizeof(glm::mat4));
+        commandBuffer->SetUniforms(2, &projection, sizeof(glm::mat4));
+        commandBuffer->SetUniforms(3, &inverseView, sizeof(glm::mat4));
+        commandBuffer->SetUniforms(4, &inverseProjection, sizeof(glm::mat4));
+        commandBuffer->SetUniforms(5, &sliceScale, sizeof(sliceScale));
+        commandBuffer->SetUniforms(6, &sliceBias, sizeof(sliceBias));
     };
 
-    auto gtaoResult = ApplyGTAO();
-
-    Renderer::Get().Begin();
-
     RenderSky(renderTarget);
 
     const auto defaultTexture = AssetManager::Get().Load<TextureAsset>("default", true)->texture;
@@ -838,202 +1730,588 @@ void Scene::RenderResult(LLGL::RenderTarget* renderTarget)
 
     DeferredRenderer::Get().Draw(
         {
-            { 5, lightsBuffer },
-            { 6, shadowsBuffer },
-
-            { 7, shadowSamplers[0] },
-            { 8, shadowSamplers[1] },
-            { 9, shadowSamplers[2] },
-            { 10, shadowSamplers[3] },
-
-            { 11, irradiance },
-            { 12, prefiltered },
-            { 13, brdf },
-            { 14, gtaoResult }
+            { 5, LightClusters::Get().GetLightBuffer() },
+            { 6, ShadowAtlas::Get().GetShadowBuffer() },
+            { 7, ShadowAtlas::Get().GetTexture() },
+
+            { 8, irradiance },
+            { 9, prefiltered },
+            { 10, brdf },
+            { 11, occlusion },
+
+            { 13, LightClusters::Get().GetClusterBuffer() },
+            { 14, LightClusters::Get().GetIndexBuffer() }
         },
         uniforms,
         renderTarget
     );
-
-    Renderer::Get().End();
-
-    Renderer::Get().Submit();
 }
 
 void Scene::ApplyPostProcessing(LLGL::RenderTarget* renderTarget)
 {
+    auto& graph = RenderGraph::Get();
+
+    const auto output = graph.Import(nullptr, renderTarget);
+    const auto occlusion = AddGTAOPasses();
+
     const auto tonemapView = registry.view<TonemapComponent>();
 
-    if(tonemapView->begin() == tonemapView->end())
+    if(tonemapView->begin() == tonemapView->end() || !tonemapView->begin()->postProcessing)
     {
-        RenderResult(renderTarget);
+        graph.AddPass({ occlusion }, { output }, [this, &graph, occlusion, renderTarget]
+        {
+            Renderer::Get().ClearRenderTarget(renderTarget, false);
+
+            RenderResult(renderTarget, graph.GetTexture(occlusion));
+        });
+
+        graph.Execute(output);
+
         return;
     }
 
     auto& toneMapping = *tonemapView->begin();
 
-    if(!toneMapping.postProcessing)
-    {
-        RenderResult(renderTarget);
-        return;
-    }
+    const auto frame = graph.Create({ .resolution = toneMapping.resolution });
 
-    RenderResult(toneMapping.postProcessing->GetRenderTarget());
+    graph.AddPass({ occlusion }, { frame }, [this, &graph, occlusion, frame]
+    {
+        RenderResult(graph.GetRenderTarget(frame), graph.GetTexture(occlusion));
+    });
 
     // Problem: reflections don't affect bloom yet
-    auto ssrResult = ApplySSR(toneMapping.postProcessing->GetFrame());
-    const auto [frame, strength] = ApplyBloom(toneMapping.postProcessing->GetFrame());
+    const auto ssr = AddSSRPasses(frame);
+    const auto [bloom, strength] = AddBloomPasses(frame);
 
-    toneMapping.postProcessing->Apply(
-        {
-            { 0, toneMapping.postProcessing->GetFrame() },
-            { 1, frame },
-            { 2, ssrResult },
-            { 3, DeferredRenderer::Get().GetAlbedo() },
-            { 4, DeferredRenderer::Get().GetCombined() },
-            { 5, toneMapping.lut->texture }
-        },
-        [&](auto commandBuffer)
-        {
-            toneMapping.setUniforms(commandBuffer);
+    graph.AddPass({ frame, bloom, ssr }, { output }, [&graph, &toneMapping, frame, bloom, ssr, bloomStrength = strength, renderTarget]
+    {
+        toneMapping.postProcessing->Record(
+            {
+                { 0, graph.GetTexture(frame) },
+                { 1, graph.GetTexture(bloom) },
+                { 2, graph.GetTexture(ssr) },
+                { 3, DeferredRenderer::Get().GetAlbedo() },
+                { 4, DeferredRenderer::Get().GetCombined() },
+                { 5, toneMapping.lut->texture }
+            },
+            [&](auto commandBuffer)
+            {
+                toneMapping.setUniforms(commandBuffer);
 
-            commandBuffer->SetUniforms(2, &strength, sizeof(float));
-        },
-        renderTarget
-    );
+                commandBuffer->SetUniforms(2, &bloomStrength, sizeof(float));
+            },
+            renderTarget
+        );
+    });
+
+    graph.Execute(output);
 }
 
-std::pair<LLGL::Texture*, float> Scene::ApplyBloom(LLGL::Texture* frame)
+std::pair<RenderGraph::Handle, float> Scene::AddBloomPasses(const RenderGraph::Handle frame)
 {
+    auto& graph = RenderGraph::Get();
+
     const auto bloomView = registry.view<BloomComponent>();
 
     if(bloomView->begin() == bloomView->end())
-        return { AssetManager::Get().Load<TextureAsset>("empty", true)->texture, 0.0f };
+        return { graph.Import(AssetManager::Get().Load<TextureAsset>("empty", true)->texture), 0.0f };
 
     auto& bloom = *bloomView->begin();
 
-    bloom.thresholdPass->Apply(
+    const auto scaledResolution = bloom.GetScaledResolution();
+
+    const auto threshold = graph.Create({ .resolution = scaledResolution });
+
+    graph.AddPass({ frame }, { threshold }, [&graph, &bloom, frame, threshold]
+    {
+        bloom.thresholdPass->Record(
+            {
+                { 0, graph.GetTexture(frame) }
+            },
+            bloom.setThresholdUniforms,
+            graph.GetRenderTarget(threshold)
+        );
+    });
+
+    if(bloom.mipChain)
+        return { AddBloomMipChainPasses(bloom, threshold), bloom.strength };
+
+    // Every blur pass writes a new texture, the graph only keeps two of them alive at a time
+    auto source = threshold;
+
+    for(int i = 0; i < 10; i++)
+    {
+        const auto target = graph.Create({ .resolution = scaledResolution });
+        const int horizontal = i % 2 == 0;
+
+        graph.AddPass({ source }, { target }, [&graph, &bloom, source, target, horizontal, i]
         {
-            { 0, frame }
-        },
-        bloom.setThresholdUniforms,
-        bloom.thresholdPass->GetRenderTarget()
-    );
+            bloom.pingPong[i % 2]->Record(
+                {
+                    { 0, graph.GetTexture(source) },
+                    { 1, bloom.sampler }
+                },
+                [&](auto commandBuffer)
+                {
+                    commandBuffer->SetUniforms(0, &horizontal, sizeof(int));
+                },
+                graph.GetRenderTarget(target)
+            );
+        });
+
+        source = target;
+    }
+
+    return { source, bloom.strength };
+}
+
+RenderGraph::Handle Scene::AddBloomMipChainPasses(const BloomComponent& bloom, const RenderGraph::Handle threshold)
+{
+    auto& graph = RenderGraph::Get();
 
-    int horizontal = 1;
+    // Level 0 is the threshold pass, each next one is half the size of the previous
+    std::vector levels = { threshold };
+    std::vector sizes = { bloom.GetScaledResolution() };
 
-    auto setPingPongUniforms = [&](auto commandBuffer)
+    for(int level = 1; level < bloom.mipCount && sizes.back().width > 1 && sizes.back().height > 1; level++)
     {
-        commandBuffer->SetUniforms(0, &horizontal, sizeof(int));
-    };
+        sizes.push_back({ sizes.back().width / 2, sizes.back().height / 2 });
+        levels.push_back(graph.Create({ .resolution = sizes.back(), .format = LLGL::Format::R11G11B10Float }));
+    }
+
+    if(levels.size() == 1)
+        return threshold;
 
-    bloom.pingPong[1]->Apply(
+    for(size_t level = 1; level < levels.size(); level++)
+    {
+        const int karisAverage = level == 1;
+
+        const auto source = levels[level - 1];
+        const auto target = levels[level];
+
+        graph.AddPass({ source }, { target }, [&graph, &bloom, source, target, karisAverage]
         {
-            { 0, bloom.thresholdPass->GetFrame() },
-            { 1, bloom.sampler }
-        },
-        setPingPongUniforms,
-        bloom.pingPong[1]->GetRenderTarget()
-    );
+            bloom.downsample->Record(
+                {
+                    { 0, graph.GetTexture(source) },
+                    { 1, bloom.sampler }
+                },
+                [&](auto commandBuffer)
+                {
+                    commandBuffer->SetUniforms(0, &karisAverage, sizeof(karisAverage));
+                },
+                graph.GetRenderTarget(target)
+            );
+        });
+    }
+
+    // Every level adds itself to the upsampled lower one, the sum is averaged in the end
+    const float levelCount = static_cast<float>(levels.size());
 
-    for(int i = 0; i < 9; i++)
+    auto lower = levels.back();
+
+    for(auto level = static_cast<int>(levels.size()) - 2; level >= 0; level--)
     {
-        horizontal = !horizontal;
+        const auto current = levels[level];
+        const auto target = graph.Create({ .resolution = sizes[level], .format = LLGL::Format::R11G11B10Float });
 
-        bloom.pingPong[i % 2]->Apply(
-            {
-                { 0, bloom.pingPong[(i + 1) % 2]->GetFrame() },
-                { 1, bloom.sampler }
-            },
-            setPingPongUniforms,
-            bloom.pingPong[i % 2]->GetRenderTarget()
-        );
+        const float weight = level == 0 ? 1.0f / levelCount : 1.0f;
+
+        graph.AddPass({ lower, current }, { target }, [&graph, &bloom, lower, current, target, weight]
+        {
+            bloom.upsample->Record(
+                {
+                    { 0, graph.GetTexture(lower) },
+                    { 1, graph.GetTexture(current) },
+                    { 2, bloom.sampler }
+                },
+                [&](auto commandBuffer)
+                {
+                    commandBuffer->SetUniforms(0, &bloom.filterRadius, sizeof(bloom.filterRadius));
+                    commandBuffer->SetUniforms(1, &weight, sizeof(weight));
+                },
+                graph.GetRenderTarget(target)
+            );
+        });
+
+        lower = target;
     }
 
-    return { bloom.pingPong[0]->GetFrame(), bloom.strength };
+    return lower;
 }
 
-LLGL::Texture* Scene::ApplyGTAO()
+RenderGraph::Handle Scene::AddGTAOPasses()
 {
+    auto& graph = RenderGraph::Get();
+
     const auto gtaoView = registry.view<GTAOComponent>();
 
     if(gtaoView->begin() == gtaoView->end())
-        return AssetManager::Get().Load<TextureAsset>("empty", true)->texture;
+        return graph.Import(AssetManager::Get().Load<TextureAsset>("empty", true)->texture);
 
     auto& gtao = *gtaoView->begin();
 
     auto depth = DeferredRenderer::Get().GetDepth();
 
-    Renderer::Get().GenerateMips(depth);
+    const bool temporal = gtao.temporal && camera;
 
-    gtao.gtao->Apply(
-        {
-            { 0, depth }
-        },
-        [&](auto commandBuffer)
-        {
-            if(camera)
+    // Six rotations between the spatial directions and four step offsets, so every pixel
+    // goes through 24 different sample patterns before it repeats
+    static constexpr std::array temporalRotations = { 60.0f, 300.0f, 180.0f, 240.0f, 120.0f, 0.0f };
+    static constexpr std::array temporalOffsets = { 0.0f, 0.5f, 0.25f, 0.75f };
+
+    const float temporalRotation = temporal
+        ? glm::radians(temporalRotations[gtao.frameIndex % temporalRotations.size()]) / 32.0f // Within PI / 16
+        : 0.0f;
+    const float temporalOffset = temporal ? temporalOffsets[gtao.frameIndex % temporalOffsets.size()] : 0.0f;
+
+    const auto scaledResolution = gtao.GetScaledResolution();
+
+    const auto occlusion = graph.Create({ .resolution = scaledResolution, .format = LLGL::Format::R16Float });
+    const auto blurred = graph.Create({ .resolution = scaledResolution, .format = LLGL::Format::R16Float });
+
+    graph.AddPass({}, { occlusion }, [this, &graph, &gtao, depth, occlusion, temporalRotation, temporalOffset]
+    {
+        Renderer::Get().GenerateMips(depth, false);
+
+        gtao.gtao->Record(
+            {
+                { 0, depth }
+            },
+            [&](auto commandBuffer)
             {
-                float far = camera->GetFar();
-                float near = camera->GetNear();
+                if(camera)
+                {
+                    float far = camera->GetFar();
+                    float near = camera->GetNear();
 
-                commandBuffer->SetUniforms(0, &far, sizeof(far));
-                commandBuffer->SetUniforms(1, &near, sizeof(near));
-            }
+                    commandBuffer->SetUniforms(0, &far, sizeof(far));
+                    commandBuffer->SetUniforms(1, &near, sizeof(near));
+                }
 
-            commandBuffer->SetUniforms(2, &gtao.samples, sizeof(gtao.samples));
-            commandBuffer->SetUniforms(3, &gtao.limit, sizeof(gtao.limit));
-            commandBuffer->SetUniforms(4, &gtao.radius, sizeof(gtao.radius));
-            commandBuffer->SetUniforms(5, &gtao.falloff, sizeof(gtao.falloff));
-            commandBuffer->SetUniforms(6, &gtao.thicknessMix, sizeof(gtao.thicknessMix));
-            commandBuffer->SetUniforms(7, &gtao.maxStride, sizeof(gtao.maxStride));
-        }
-    );
+                commandBuffer->SetUniforms(2, &gtao.samples, sizeof(gtao.samples));
+                commandBuffer->SetUniforms(3, &gtao.limit, sizeof(gtao.limit));
+                commandBuffer->SetUniforms(4, &gtao.radius, sizeof(gtao.radius));
+                commandBuffer->SetUniforms(5, &gtao.falloff, sizeof(gtao.falloff));
+                commandBuffer->SetUniforms(6, &gtao.thicknessMix, sizeof(gtao.thicknessMix));
+                commandBuffer->SetUniforms(7, &gtao.maxStride, sizeof(gtao.maxStride));
+                commandBuffer->SetUniforms(8, &temporalRotation, sizeof(temporalRotation));
+                commandBuffer->SetUniforms(9, &temporalOffset, sizeof(temporalOffset));
+            },
+            graph.GetRenderTarget(occlusion)
+        );
+    });
 
-    gtao.boxBlur->Apply(
-        {
-            { 0, gtao.gtao->GetFrame() }
-        },
-        [&](auto) {}
-    );
+    graph.AddPass({ occlusion }, { blurred }, [&graph, &gtao, occlusion, blurred]
+    {
+        gtao.boxBlur->Record(
+            {
+                { 0, graph.GetTexture(occlusion) }
+            },
+            [&](auto) {},
+            graph.GetRenderTarget(blurred)
+        );
+    });
+
+    if(!temporal)
+    {
+        gtao.historyValid = false;
+
+        return blurred;
+    }
+
+    const auto viewProjection = Renderer::Get().GetMatrices()->GetProjection() * Renderer::Get().GetMatrices()->GetView();
+    const auto inverseViewProjection = glm::inverse(viewProjection);
+
+    const float far = camera->GetFar();
+    const float near = camera->GetNear();
+
+    const auto& currentPass = gtao.history[gtao.frameIndex % 2];
+    const auto& previousPass = gtao.history[(gtao.frameIndex + 1) % 2];
+
+    const auto current = graph.Import(currentPass->GetFrame(), currentPass->GetRenderTarget());
+    const auto previous = graph.Import(previousPass->GetFrame());
+
+    const auto upsampled = graph.Create({ .resolution = gtao.resolution, .format = LLGL::Format::R16Float });
+
+    graph.AddPass({ blurred, previous }, { current }, [&graph, &gtao, &currentPass, blurred, previous, current, viewProjection, inverseViewProjection, far, near]
+    {
+        currentPass->Record(
+            {
+                { 0, graph.GetTexture(blurred) },
+                { 1, graph.GetTexture(previous) },
+                { 2, DeferredRenderer::Get().GetDepth() }
+            },
+            [&](auto commandBuffer)
+            {
+                const int historyValid = gtao.historyValid;
+
+                commandBuffer->SetUniforms(0, &inverseViewProjection, sizeof(glm::mat4));
+                commandBuffer->SetUniforms(1, &gtao.previousViewProjection, sizeof(glm::mat4));
+                commandBuffer->SetUniforms(2, &far, sizeof(far));
+                commandBuffer->SetUniforms(3, &near, sizeof(near));
+                commandBuffer->SetUniforms(4, &gtao.historyWeight, sizeof(gtao.historyWeight));
+                commandBuffer->SetUniforms(5, &historyValid, sizeof(historyValid));
+            },
+            graph.GetRenderTarget(current)
+        );
+
+        gtao.previousViewProjection = viewProjection;
+        gtao.historyValid = true;
+        gtao.frameIndex++;
+    });
+
+    graph.AddPass({ current }, { upsampled }, [&graph, &gtao, current, upsampled, far, near]
+    {
+        gtao.upsample->Record(
+            {
+                { 0, graph.GetTexture(current) },
+                { 1, DeferredRenderer::Get().GetDepth() }
+            },
+            [&](auto commandBuffer)
+            {
+                commandBuffer->SetUniforms(0, &far, sizeof(far));
+                commandBuffer->SetUniforms(1, &near, sizeof(near));
+            },
+            graph.GetRenderTarget(upsampled)
+        );
+    });
 
-    return gtao.boxBlur->GetFrame();
+    return upsampled;
 }
 
-LLGL::Texture* Scene::ApplySSR(LLGL::Texture* frame)
+RenderGraph::Handle Scene::AddSSRPasses(const RenderGraph::Handle frame)
 {
+    auto& graph = RenderGraph::Get();
+
     const auto ssrView = registry.view<SSRComponent>();
 
     if(ssrView->begin() == ssrView->end())
-        return AssetManager::Get().Load<TextureAsset>("empty", true)->texture;
+        return graph.Import(AssetManager::Get().Load<TextureAsset>("empty", true)->texture);
 
     auto& ssr = *ssrView->begin();
 
-    auto gNormal = DeferredRenderer::Get().GetNormal();
-    auto gCombined = DeferredRenderer::Get().GetCombined();
-    auto depth = DeferredRenderer::Get().GetDepth();
+    const bool temporal = ssr.temporal && camera;
 
-    ssr.ssr->Apply(
+    // The tonemapping pass picks the mip level by roughness, without the temporal pass it reads the traced reflections
+    const auto traced = graph.Create({ .resolution = ssr.GetScaledResolution(), .mipMaps = !temporal });
+
+    if(ssr.hiZ)
+    {
+        // Golden ratio sequence, the ray origins of consecutive frames are spread evenly
+        const float jitter = temporal ? std::fmod(static_cast<float>(ssr.frameIndex) * 0.618034f, 1.0f) : 0.0f;
+
+        graph.AddPass({ frame }, { traced }, [&graph, &ssr, frame, traced, jitter]
         {
-            { 0, Renderer::Get().GetMatricesBuffer() },
-            { 1, gNormal },
-            { 2, gCombined },
-            { 3, depth },
-            { 4, frame }
-        },
-        [&](auto commandBuffer)
+            const int levelCount = static_cast<int>(HiZBuffer::Get().GetLevelCount());
+
+            ssr.hiZTrace->Record(
+                {
+                    { 0, Renderer::Get().GetMatricesBuffer() },
+                    { 1, DeferredRenderer::Get().GetNormal() },
+                    { 2, DeferredRenderer::Get().GetCombined() },
+                    { 3, HiZBuffer::Get().GetTexture() },
+                    { 4, graph.GetTexture(frame) }
+                },
+                [&](auto commandBuffer)
+                {
+                    commandBuffer->SetUniforms(0, &ssr.maxSteps, sizeof(ssr.maxSteps));
+                    commandBuffer->SetUniforms(1, &levelCount, sizeof(levelCount));
+                    commandBuffer->SetUniforms(2, &ssr.maxDistance, sizeof(ssr.maxDistance));
+                    commandBuffer->SetUniforms(3, &ssr.thickness, sizeof(ssr.thickness));
+                    commandBuffer->SetUniforms(4, &jitter, sizeof(jitter));
+                },
+                graph.GetRenderTarget(traced),
+                true
+            );
+        });
+    }
+    else
+    {
+        graph.AddPass({ frame }, { traced }, [&graph, &ssr, frame, traced]
         {
-            commandBuffer->SetUniforms(0, &ssr.maxSteps, sizeof(ssr.maxSteps));
-            commandBuffer->SetUniforms(1, &ssr.maxBinarySearchSteps, sizeof(ssr.maxBinarySearchSteps));
-            commandBuffer->SetUniforms(2, &ssr.rayStep, sizeof(ssr.rayStep));
-        },
-        nullptr,
-        true
-    );
+            ssr.ssr->Record(
+                {
+                    { 0, Renderer::Get().GetMatricesBuffer() },
+                    { 1, DeferredRenderer::Get().GetNormal() },
+                    { 2, DeferredRenderer::Get().GetCombined() },
+                    { 3, DeferredRenderer::Get().GetDepth() },
+                    { 4, graph.GetTexture(frame) }
+                },
+                [&](auto commandBuffer)
+                {
+                    commandBuffer->SetUniforms(0, &ssr.maxSteps, sizeof(ssr.maxSteps));
+                    commandBuffer->SetUniforms(1, &ssr.maxBinarySearchSteps, sizeof(ssr.maxBinarySearchSteps));
+                    commandBuffer->SetUniforms(2, &ssr.rayStep, sizeof(ssr.rayStep));
+                },
+                graph.GetRenderTarget(traced),
+                true
+            );
+        });
+    }
+
+    if(!temporal)
+    {
+        ssr.historyValid = false;
+
+        return traced;
+    }
+
+    const auto viewProjection = Renderer::Get().GetMatrices()->GetProjection() * Renderer::Get().GetMatrices()->GetView();
+    const auto inverseViewProjection = glm::inverse(viewProjection);
+
+    const auto& currentPass = ssr.history[ssr.frameIndex % 2];
+    const auto& previousPass = ssr.history[(ssr.frameIndex + 1) % 2];
 
-    Renderer::Get().GenerateMips(ssr.ssr->GetFrame());
+    // The history has mips, the graph regenerates them after the pass
+    const auto current = graph.Import(currentPass->GetFrame(), currentPass->GetRenderTarget());
+    const auto previous = graph.Import(previousPass->GetFrame());
+
+    graph.AddPass({ traced, previous }, { current }, [&graph, &ssr, &currentPass, traced, previous, current, viewProjection, inverseViewProjection]
+    {
+        currentPass->Record(
+            {
+                { 0, graph.GetTexture(traced) },
+                { 1, graph.GetTexture(previous) },
+                { 2, DeferredRenderer::Get().GetDepth() }
+            },
+            [&](auto commandBuffer)
+            {
+                const int historyValid = ssr.historyValid;
+
+                commandBuffer->SetUniforms(0, &inverseViewProjection, sizeof(glm::mat4));
+                commandBuffer->SetUniforms(1, &ssr.previousViewProjection, sizeof(glm::mat4));
+                commandBuffer->SetUniforms(2, &ssr.historyWeight, sizeof(ssr.historyWeight));
+                commandBuffer->SetUniforms(3, &historyValid, sizeof(historyValid));
+            },
+            graph.GetRenderTarget(current)
+        );
+
+        ssr.previousViewProjection = viewProjection;
+        ssr.historyValid = true;
+        ssr.frameIndex++;
+    });
+
+    return current;
+}
+
+uint32_t Scene::GetShadowKey(const entt::entity entity, const uint32_t cascade)
+{
+    return static_cast<uint32_t>(entt::to_entity(entity)) * cascadeCount + cascade;
+}
+
+uint32_t Scene::SelectLod(
+    const Mesh& mesh,
+    const glm::mat4& worldTransform,
+    const float threshold,
+    const uint32_t current
+) const
+{
+    if(!camera || threshold <= 0.0f || mesh.GetLodCount() == 1)
+        return 0;
+
+    const auto bounds = mesh.GetBounds();
+
+    const auto scale = std::max({
+        glm::length(glm::vec3(worldTransform[0])),
+        glm::length(glm::vec3(worldTransform[1])),
+        glm::length(glm::vec3(worldTransform[2]))
+    });
+
+    const auto size = glm::length(bounds.max - bounds.min) * scale;
+    const auto center = glm::vec3(worldTransform * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.0f));
+
+    // To the bounding sphere, from the inside it's as close as it gets
+    const auto distance = std::max(glm::distance(center, cameraPosition) - size * 0.5f, camera->GetNear());
+
+    const auto pixelsPerUnit =
+        camera->GetViewport().y * 0.5f / (distance * std::tan(glm::radians(camera->GetFov()) * 0.5f));
+
+    uint32_t lod = 0;
+
+    // The errors only grow with every level
+    for(uint32_t i = 1; i < mesh.GetLodCount(); i++)
+    {
+        const auto limit = i > current ? threshold * (1.0f - lodHysteresis) : threshold;
+
+        if(mesh.GetLodError(i) * size * pixelsPerUnit > limit)
+            break;
+
+        lod = i;
+    }
+
+    return lod;
+}
+
+Mesh::Bounds Scene::GetWorldBounds(const ModelAsset& model, const glm::mat4& transform)
+{
+    Mesh::Bounds local{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+
+    for(const auto& mesh : model.meshes)
+    {
+        const auto bounds = mesh->GetBounds();
+
+        local.min = glm::min(local.min, bounds.min);
+        local.max = glm::max(local.max, bounds.max);
+    }
+
+    Mesh::Bounds world{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+
+    for(int i = 0; i < 8; i++)
+    {
+        const glm::vec3 corner =
+        {
+            i & 1 ? local.max.x : local.min.x,
+            i & 2 ? local.max.y : local.min.y,
+            i & 4 ? local.max.z : local.min.z
+        };
+
+        const glm::vec3 transformed = transform * glm::vec4(corner, 1.0f);
+
+        world.min = glm::min(world.min, transformed);
+        world.max = glm::max(world.max, transformed);
+    }
+
+    return world;
+}
+
+Mesh::Bounds Scene::GetAnimatedBounds(const ModelAsset& model, const glm::mat4& transform)
+{
+    auto bounds = GetWorldBounds(model, transform);
+
+    const auto padding = (bounds.max - bounds.min) * animatedBoundsPadding;
+
+    bounds.min -= padding;
+    bounds.max += padding;
+
+    return bounds;
+}
+
+bool Scene::IsInFrustum(const Mesh::Bounds& bounds, const glm::mat4& viewProjection)
+{
+    // Outside only if all the corners are on the outer side of the same plane
+    int outside[6] = {};
+
+    for(int i = 0; i < 8; i++)
+    {
+        const glm::vec4 corner =
+        {
+            i & 1 ? bounds.max.x : bounds.min.x,
+            i & 2 ? bounds.max.y : bounds.min.y,
+            i & 4 ? bounds.max.z : bounds.min.z,
+            1.0f
+        };
+
+        const auto clip = viewProjection * corner;
+
+        for(int axis = 0; axis < 3; axis++)
+        {
+            outside[axis * 2] += clip[axis] < -clip.w;
+            outside[axis * 2 + 1] += clip[axis] > clip.w;
+        }
+    }
 
-    return ssr.ssr->GetFrame();
+    return std::ranges::none_of(outside, [](const int count) { return count == 8; });
 }
 
 }
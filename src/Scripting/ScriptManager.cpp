@@ -80,6 +80,7 @@ ScriptManager::ScriptManager()
     RegisterScriptComponent();
     RegisterBodyComponent();
     RegisterSoundComponent();
+    RegisterAnimatorComponent();
 
     RegisterProceduralSkyComponent();
     RegisterHDRISkyComponent();
@@ -155,6 +156,40 @@ void ScriptManager::ExecuteFunction(
     }
 }
 
+void ScriptManager::ExecuteFunction(
+    const ScriptAssetPtr& script,
+    const std::string_view declaration,
+    const size_t count,
+    const std::function<void(asIScriptContext*, size_t)>& setArgs,
+    const uint32_t moduleIndex
+) const
+{
+    if(count == 0)
+        return;
+
+    const auto module = engine->GetModule((script->path.stem().string() + std::to_string(moduleIndex)).c_str());
+
+    if(const auto func = module->GetFunctionByDecl(declaration.data()))
+    {
+        if(context->GetState() == asEContextState::asEXECUTION_ACTIVE)
+            LLGL::Log::Printf(
+                LLGL::Log::ColorFlags::StdError,
+                "Context is already in use\n"
+            );
+
+        for(size_t i = 0; i < count; i++)
+        {
+            context->Prepare(func);
+
+            setArgs(context, i);
+
+            context->Execute();
+        }
+
+        context->Unprepare();
+    }
+}
+
 void ScriptManager::AddScript(const ScriptAssetPtr& script)
 {
     if(std::ranges::find(scripts, script) == scripts.end())
@@ -523,6 +558,11 @@ void ScriptManager::RegisterRayCast() const
     );
 
     AddFunction("RayCastResult CastRay(const glm::vec3& in, const glm::vec3& in)", WRAP_FN(as::CastRay));
+
+    AddFunction("void SetCollisionLayerMask(uint32)", WRAP_FN(as::SetCollisionLayerMask));
+    AddFunction("void SetReportPersistedCollisions(bool)", WRAP_FN(as::SetReportPersistedCollisions));
+    AddFunction("void WatchCollisions(Body@)", WRAP_FN(as::WatchCollisions));
+    AddFunction("void UnwatchCollisions(Body@)", WRAP_FN(as::UnwatchCollisions));
 }
 
 void ScriptManager::RegisterExtent2D() const
@@ -580,6 +620,10 @@ void ScriptManager::RegisterSound() const
         {
             { "void Play()", WRAP_MFN(Sound, Play) },
             { "void Stop()", WRAP_MFN(Sound, Stop) },
+            { "bool PlayInstance()", WRAP_MFN(Sound, PlayInstance) },
+            { "void StopInstances()", WRAP_MFN(Sound, StopInstances) },
+            { "void SetPriority(int)", WRAP_MFN(Sound, SetPriority) },
+            { "void SetInstanceLimit(uint32)", WRAP_MFN(Sound, SetInstanceLimit) },
 
             { "void SetPosition(const glm::vec3& in)", WRAP_MFN(Sound, SetPosition) },
             { "void SetVelocity(const glm::vec3& in)", WRAP_MFN(Sound, SetVelocity) },
@@ -772,6 +816,16 @@ void ScriptManager::RegisterInputManager() const
     AddFunction("void MapKeyboardAction(const string& in, int)", WRAP_FN_PR(as::MapAction, (const std::string&, Keyboard::Key), void));
     AddFunction("void MapMouseAction(const string& in, int)", WRAP_FN_PR(as::MapAction, (const std::string&, Mouse::Button), void));
     AddFunction("bool IsActionPressed(const string& in)", WRAP_FN(as::IsActionPressed));
+    AddFunction("bool IsActionJustPressed(const string& in)", WRAP_FN(as::IsActionJustPressed));
+    AddFunction("bool IsActionJustReleased(const string& in)", WRAP_FN(as::IsActionJustReleased));
+
+    // Resolve the id once and use these in hot paths
+    AddFunction("uint32 RegisterAction(const string& in)", WRAP_FN(as::RegisterAction));
+    AddFunction("void MapKeyboardAction(uint32, int)", WRAP_FN_PR(as::MapActionById, (InputManager::ActionId, Keyboard::Key), void));
+    AddFunction("void MapMouseAction(uint32, int)", WRAP_FN_PR(as::MapActionById, (InputManager::ActionId, Mouse::Button), void));
+    AddFunction("bool IsActionPressed(uint32)", WRAP_FN(as::IsActionPressedById));
+    AddFunction("bool IsActionJustPressed(uint32)", WRAP_FN(as::IsActionJustPressedById));
+    AddFunction("bool IsActionJustReleased(uint32)", WRAP_FN(as::IsActionJustReleasedById));
 }
 
 void ScriptManager::RegisterScriptManager() const
@@ -931,6 +985,8 @@ void ScriptManager::RegisterCollisionEvent() const
             { "bool IsHandled() const", WRAP_MFN(CollisionEvent, IsHandled) },
             { "JPH::Body@ GetBody1() const", WRAP_MFN(CollisionEvent, GetBody1) },
             { "JPH::Body@ GetBody2() const", WRAP_MFN(CollisionEvent, GetBody2) },
+            { "const JPH::BodyID& GetBodyID1() const", WRAP_MFN(CollisionEvent, GetBodyID1) },
+            { "const JPH::BodyID& GetBodyID2() const", WRAP_MFN(CollisionEvent, GetBodyID2) },
             { "glm::vec3 GetContactPosition1() const", WRAP_MFN(CollisionEvent, GetContactPosition1) },
             { "glm::vec3 GetContactPosition2() const", WRAP_MFN(CollisionEvent, GetContactPosition2) },
             { "glm::vec3 GetNormal() const", WRAP_MFN(CollisionEvent, GetNormal) },
@@ -989,7 +1045,11 @@ void ScriptManager::RegisterMeshRendererComponent() const
     AddType("MeshRendererComponent", sizeof(MeshRendererComponent),
         {
             { "MaterialAssetPtr& at(uint64)", WRAP_OBJ_LAST(as::MaterialListAt) }
-        }, {}
+        },
+        {
+            { "float lodThreshold", asOFFSET(MeshRendererComponent, lodThreshold) },
+            { "float shadowLodBias", asOFFSET(MeshRendererComponent, shadowLodBias) }
+        }
     );
 }
 
@@ -1013,6 +1073,7 @@ void ScriptManager::RegisterLightComponent() const
             { "float intensity", asOFFSET(LightComponent, intensity) },
             { "float cutoff", asOFFSET(LightComponent, cutoff) },
             { "float outerCutoff", asOFFSET(LightComponent, outerCutoff) },
+            { "float range", asOFFSET(LightComponent, range) },
             { "bool shadowMap", asOFFSET(LightComponent, shadowMap) }
         }
     );
@@ -1046,6 +1107,22 @@ void ScriptManager::RegisterSoundComponent() const
     );
 }
 
+void ScriptManager::RegisterAnimatorComponent() const
+{
+    AddType("AnimatorComponent", sizeof(AnimatorComponent),
+        {
+            { "void Play(int animation, float fadeDuration = 0.2f)", WRAP_MFN(AnimatorComponent, Play) }
+        },
+        {
+            { "int animation", asOFFSET(AnimatorComponent, animation) },
+            { "float time", asOFFSET(AnimatorComponent, time) },
+            { "float speed", asOFFSET(AnimatorComponent, speed) },
+            { "bool loop", asOFFSET(AnimatorComponent, loop) },
+            { "bool playing", asOFFSET(AnimatorComponent, playing) }
+        }
+    );
+}
+
 void ScriptManager::RegisterProceduralSkyComponent() const
 {
     AddType("ProceduralSkyComponent", sizeof(ProceduralSkyComponent),
@@ -1056,7 +1133,8 @@ void ScriptManager::RegisterProceduralSkyComponent() const
             { "float time", asOFFSET(ProceduralSkyComponent, time) },
             { "float cirrus", asOFFSET(ProceduralSkyComponent, cirrus) },
             { "float cumulus", asOFFSET(ProceduralSkyComponent, cumulus) },
-            { "int flip", asOFFSET(ProceduralSkyComponent, flip) }
+            { "int flip", asOFFSET(ProceduralSkyComponent, flip) },
+            { "bool timeSliced", asOFFSET(ProceduralSkyComponent, timeSliced) }
         }
     );
 }
@@ -1102,7 +1180,10 @@ void ScriptManager::RegisterBloomComponent() const
         {
             { "float threshold", asOFFSET(BloomComponent, threshold) },
             { "float strength", asOFFSET(BloomComponent, strength) },
-            { "float resolutionScale", asOFFSET(BloomComponent, resolutionScale) }
+            { "float resolutionScale", asOFFSET(BloomComponent, resolutionScale) },
+            { "bool mipChain", asOFFSET(BloomComponent, mipChain) },
+            { "int mipCount", asOFFSET(BloomComponent, mipCount) },
+            { "float filterRadius", asOFFSET(BloomComponent, filterRadius) }
         }
     );
 }
@@ -1114,7 +1195,9 @@ void ScriptManager::RegisterGTAOComponent() const
             { "void SetupPostProcessing()", WRAP_MFN(GTAOComponent, SetupPostProcessing) }
         },
         {
-            { "float resolutionScale", asOFFSET(GTAOComponent, resolutionScale) }
+            { "float resolutionScale", asOFFSET(GTAOComponent, resolutionScale) },
+            { "bool temporal", asOFFSET(GTAOComponent, temporal) },
+            { "float historyWeight", asOFFSET(GTAOComponent, historyWeight) }
         }
     );
 }
@@ -1129,7 +1212,12 @@ void ScriptManager::RegisterSSRComponent() const
             { "float resolutionScale", asOFFSET(SSRComponent, resolutionScale) },
             { "int maxSteps", asOFFSET(SSRComponent, maxSteps) },
             { "int maxBinarySearchSteps", asOFFSET(SSRComponent, maxBinarySearchSteps) },
-            { "float rayStep", asOFFSET(SSRComponent, rayStep) }
+            { "float rayStep", asOFFSET(SSRComponent, rayStep) },
+            { "bool hiZ", asOFFSET(SSRComponent, hiZ) },
+            { "float maxDistance", asOFFSET(SSRComponent, maxDistance) },
+            { "float thickness", asOFFSET(SSRComponent, thickness) },
+            { "bool temporal", asOFFSET(SSRComponent, temporal) },
+            { "float historyWeight", asOFFSET(SSRComponent, historyWeight) }
         }
     );
 }
@@ -1148,6 +1236,7 @@ void ScriptManager::RegisterEntity() const
             { "CameraComponent@ GetCameraComponent()", WRAP_MFN(Entity, GetComponent<CameraComponent>) },
             { "RigidBodyComponent@ GetRigidBodyComponent()", WRAP_MFN(Entity, GetComponent<RigidBodyComponent>) },
             { "SoundComponent@ GetSoundComponent()", WRAP_MFN(Entity, GetComponent<SoundComponent>) },
+            { "AnimatorComponent@ GetAnimatorComponent()", WRAP_MFN(Entity, GetComponent<AnimatorComponent>) },
 
             { "ProceduralSkyComponent@ GetProceduralSkyComponent()", WRAP_MFN(Entity, GetComponent<ProceduralSkyComponent>) },
             { "HDRISkyComponent@ GetHDRISkyComponent()", WRAP_MFN(Entity, GetComponent<HDRISkyComponent>) },
@@ -1168,6 +1257,7 @@ void ScriptManager::RegisterEntity() const
             { "ScriptComponent@ RemoveScriptComponent()", WRAP_MFN(Entity, RemoveComponent<ScriptComponent>) },
             { "CameraComponent@ RemoveCameraComponent()", WRAP_MFN(Entity, RemoveComponent<CameraComponent>) },
             { "RigidBodyComponent@ RemoveRigidBodyComponent()", WRAP_MFN(Entity, RemoveComponent<RigidBodyComponent>) },
+            { "AnimatorComponent@ RemoveAnimatorComponent()", WRAP_MFN(Entity, RemoveComponent<AnimatorComponent>) },
 
             { "ProceduralSkyComponent@ RemoveProceduralSkyComponent()", WRAP_MFN(Entity, RemoveComponent<ProceduralSkyComponent>) },
             { "HDRISkyComponent@ RemoveHDRISkyComponent()", WRAP_MFN(Entity, RemoveComponent<HDRISkyComponent>) },